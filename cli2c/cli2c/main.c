@@ -21,7 +21,7 @@ static inline void  show_commands(void);
  * GLOBALS
  */
 // Hold an I2C data structure
-I2CDriver i2c;
+I2CDriver* i2c = NULL;
 
 
 /**
@@ -29,13 +29,10 @@ I2CDriver i2c;
  */
 int main(int argc, char *argv[]) {
 
-    // Listen for SIGINT
-    signal(SIGINT, ctrl_c_handler);
-
     // Process arguments
     if (argc < 2) {
         // Insufficient arguments -- issue usage info and bail
-        fprintf(stderr, "Usage: cli2c {DEVICE_PATH} [command] ... [command]\n");
+        fprintf(stderr, "Usage: cli2c {DEVICE_PATH} [options] [command] ... [command]\n");
         return EXIT_OK;
     } else {
         // Check for a help and/or version request
@@ -55,17 +52,57 @@ int main(int argc, char *argv[]) {
             }
         }
         
-        // Check we have commands to process
+        // FROM 1.2.0
+        // Check for options, which precede the commands
         int delta = 2;
+        uint32_t min_gap_us = 0;
+        bool binary_io = false;
+        const char* trace_path = NULL;
+        bool show_stats = false;
+        while (argc > delta && strncmp(argv[delta], "--", 2) == 0) {
+            if (strcasecmp(argv[delta], "--min-gap-us") == 0 && argc > delta + 1) {
+                min_gap_us = (uint32_t)strtol(argv[delta + 1], NULL, 0);
+                delta += 2;
+            } else if (strcasecmp(argv[delta], "--binary") == 0 || strcasecmp(argv[delta], "--raw") == 0) {
+                binary_io = true;
+                delta += 1;
+            } else if (strcasecmp(argv[delta], "--trace") == 0 && argc > delta + 1) {
+                trace_path = argv[delta + 1];
+                delta += 2;
+            } else if (strcasecmp(argv[delta], "--stats") == 0) {
+                show_stats = true;
+                delta += 1;
+            } else {
+                print_error("Unknown option: %s", argv[delta]);
+                return EXIT_ERR;
+            }
+        }
+
+        // Check we have commands to process
         if (argc > delta) {
-            // Connect... with the device path
-            i2c.port = -1;
-            i2c_connect(&i2c, argv[1]);
-            
-            if (i2c.connected) {
-                // Process the remaining commands in sequence
-                int result = process_commands(&i2c, argc, argv, delta);
-                flush_and_close_port(i2c.port);
+            // Connect... with the device path, tracing to
+            // the `--trace` path as given if there is one
+            i2c = i2c_open_traced(argv[1], trace_path);
+
+            if (i2c != NULL) {
+                // Listen for SIGINT
+                set_ctrl_c_handler(i2c);
+                if (show_stats) i2c_enable_stats(i2c);
+                i2c_set_min_gap(i2c, min_gap_us);
+                i2c_set_binary_io(i2c, binary_io);
+
+                int result;
+                if (strcmp(argv[delta], "-") == 0) {
+                    // FROM 1.2.0
+                    // Process commands from a script file or stdin
+                    result = process_script(i2c, (argc > delta + 1 ? argv[delta + 1] : NULL), process_commands);
+                } else {
+                    // Process the remaining commands in sequence
+                    result = process_commands(i2c, argc, argv, delta);
+                }
+
+                if (i2c_get_stats(i2c) != NULL) i2c_stats_print(i2c_get_stats(i2c), stderr);
+                i2c_close(i2c);
                 return result;
             }
         } else {
@@ -74,7 +111,6 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (i2c.port != -1) flush_and_close_port(i2c.port);
     return EXIT_ERR;
 }
 
@@ -84,10 +120,21 @@ int main(int argc, char *argv[]) {
  */
 static inline void show_help(void) {
     
-    fprintf(stderr, "cli2c {device} [commands]\n\n");
+    fprintf(stderr, "cli2c {device} [options] [commands]\n\n");
     fprintf(stderr, "Usage:\n");
     fprintf(stderr, "  {device} is a mandatory device path, eg. /dev/cu.usbmodem-101.\n");
-    fprintf(stderr, "  [commands] are optional commands, as shown below.\n\n");
+    fprintf(stderr, "  [options] are optional settings, as shown below.\n");
+    fprintf(stderr, "  [commands] are optional commands, as shown below. Pass - in place of commands\n");
+    fprintf(stderr, "             to read them, one command sequence per line, from stdin, or pass\n");
+    fprintf(stderr, "             - {path} to read them from a file.\n\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --min-gap-us {period}            Pause for the period (in microseconds) between commands.\n");
+    fprintf(stderr, "                                   Only needed for bus hosts running older firmware.\n");
+    fprintf(stderr, "  --binary | --raw                 Output read data as raw bytes, not hex. The w command\n");
+    fprintf(stderr, "                                   takes a file path, or - for stdin, in place of its bytes.\n");
+    fprintf(stderr, "  --trace {path}                   Record traffic with the bus host to a trace file. View\n");
+    fprintf(stderr, "                                   it with cli2ctrace. Or set %s to a path.\n", I2C_TRACE_ENV_VAR);
+    fprintf(stderr, "  --stats                          On exit, show response latencies for each type of command.\n\n");
     show_commands();
 }
 
@@ -115,9 +162,11 @@ static inline void show_commands(void) {
     fprintf(stderr, "  w {address} {bytes}              Write bytes out to I2C.\n");
     fprintf(stderr, "  r {address} {count}              Read count bytes in from I2C.\n");
     fprintf(stderr, "                                   Issues a STOP after all the bytes have been read.\n");
+    fprintf(stderr, "  t {address} {bytes} {count}      Write bytes out to I2C then read count bytes in,\n");
+    fprintf(stderr, "                                   with a repeated START between them.\n");
     fprintf(stderr, "  p                                Manually issue an I2C STOP.\n");
     fprintf(stderr, "  x                                Reset the I2C bus.\n");
-    fprintf(stderr, "  s                                Scan for devices on the I2C bus.\n");
+    fprintf(stderr, "  s [{first} {last}]               Scan for devices on the I2C bus, or in a range of addresses.\n");
     fprintf(stderr, "  i                                Get I2C bus host device information.\n");
     fprintf(stderr, "  g {number} [hi|lo] [in|out]      Control a GPIO pin.\n");
     fprintf(stderr, "  l {on|off}                       Turn the I2C bus host LED on or off.\n");
@@ -0,0 +1,407 @@
+/*
+ * cli2c-bench - measure bus host throughput and latency
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#include "i2cdriver.h"
+#include "utils.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define BENCH_ITERATIONS_DEFAULT        100
+#define BENCH_HANDSHAKES_MAX            10
+#define BENCH_RESULTS_MAX               32
+#define BENCH_CHUNK_MAX_B               64
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    const char*     test;
+    size_t          size;               // Payload bytes per iteration, or 0
+    uint32_t        iterations;
+    uint32_t        errors;             // Iterations that were not ACK'd in full
+    uint64_t        elapsed_us;         // Time taken by all the iterations
+    I2CHistogram    histogram;          // Time taken by each iteration
+} BenchResult;
+
+typedef bool (*BenchOp)(I2CDriver *sd, size_t size);
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void         run_handshakes(const char* device_path, uint32_t iterations);
+static void         run_test(I2CDriver *sd, const char* test, size_t size, uint32_t iterations, BenchOp op);
+static bool         op_info(I2CDriver *sd, size_t size);
+static bool         op_start_stop(I2CDriver *sd, size_t size);
+static bool         op_write(I2CDriver *sd, size_t size);
+static bool         op_read(I2CDriver *sd, size_t size);
+static bool         op_scan(I2CDriver *sd, size_t size);
+static void         output_csv(FILE* out, I2CDriver *sd);
+static void         output_json(FILE* out, I2CDriver *sd, const char* device_path);
+static inline uint64_t get_time_us(void);
+static inline void  show_help(void);
+static inline void  show_version(void);
+
+
+/*
+ * GLOBALS
+ */
+static BenchResult  results[BENCH_RESULTS_MAX];
+static uint32_t     result_count = 0;
+static uint8_t      device_address = 0;
+static uint8_t      data_buffer[BENCH_CHUNK_MAX_B];
+
+
+/**
+ * @brief Main entry point.
+ */
+int main(int argc, char *argv[]) {
+
+    // Process arguments
+    if (argc < 2) {
+        // Insufficient arguments -- issue usage info and bail
+        fprintf(stderr, "Usage: cli2c-bench {DEVICE_PATH} [options]\n");
+        return EXIT_OK;
+    }
+
+    // Check for a help and/or version request
+    for (int i = 0 ; i < argc ; ++i) {
+        if (strcasecmp(argv[i], "h") == 0 ||
+            strcasecmp(argv[i], "--help") == 0 ||
+            strcasecmp(argv[i], "-h") == 0) {
+            show_help();
+            return EXIT_OK;
+        }
+
+        if (strcasecmp(argv[i], "v") == 0 ||
+            strcasecmp(argv[i], "--version") == 0 ||
+            strcasecmp(argv[i], "-v") == 0) {
+            show_version();
+            return EXIT_OK;
+        }
+    }
+
+    // Check for options
+    int address = -1;
+    uint32_t iterations = BENCH_ITERATIONS_DEFAULT;
+    bool do_json = false;
+    const char* output_path = NULL;
+    for (int i = 2 ; i < argc ; ++i) {
+        if (strcasecmp(argv[i], "--address") == 0 && i < argc - 1) {
+            address = (int)strtol(argv[++i], NULL, 0);
+            if (address < 0x08 || address > 0x77) {
+                print_error("I2C address out of range: %s", argv[i]);
+                return EXIT_ERR;
+            }
+        } else if (strcasecmp(argv[i], "--iterations") == 0 && i < argc - 1) {
+            iterations = (uint32_t)strtol(argv[++i], NULL, 0);
+            if (iterations == 0) {
+                print_error("Iterations must be 1 or more");
+                return EXIT_ERR;
+            }
+        } else if (strcasecmp(argv[i], "--json") == 0) {
+            do_json = true;
+        } else if (strcasecmp(argv[i], "--csv") == 0) {
+            do_json = false;
+        } else if (strcasecmp(argv[i], "--output") == 0 && i < argc - 1) {
+            output_path = argv[++i];
+        } else {
+            print_error("Unknown option: %s", argv[i]);
+            return EXIT_ERR;
+        }
+    }
+
+    // Time connecting to the bus host, then connect for the other tests
+    run_handshakes(argv[1], iterations < BENCH_HANDSHAKES_MAX ? iterations : BENCH_HANDSHAKES_MAX);
+    I2CDriver* sd = i2c_open(argv[1]);
+    if (sd == NULL) return EXIT_ERR;
+
+    if (!i2c_get_info(sd, false)) {
+        i2c_close(sd);
+        return EXIT_ERR;
+    }
+
+    run_test(sd, "info", 0, iterations, op_info);
+    run_test(sd, "scan", 0, iterations, op_scan);
+
+    // Device tests need a device: use the first one found if none was given.
+    // The write tests change the device's registers, so they only run on
+    // a device the user has named
+    bool do_writes = (address != -1);
+    if (address == -1) {
+        uint8_t devices[CONNECTED_DEVICES_MAX_B];
+        if (i2c_scan(sd, devices, sizeof(devices)) > 0) address = devices[0];
+    }
+
+    if (address != -1) {
+        device_address = (uint8_t)address;
+        run_test(sd, "start_stop", 0, iterations, op_start_stop);
+        if (do_writes) {
+            for (size_t size = 1 ; size <= BENCH_CHUNK_MAX_B ; size <<= 1) run_test(sd, "write", size, iterations, op_write);
+        } else {
+            print_warning("No device set with --address: skipping the write tests");
+        }
+
+        for (size_t size = 1 ; size <= BENCH_CHUNK_MAX_B ; size <<= 1) run_test(sd, "read", size, iterations, op_read);
+    } else {
+        print_warning("No I2C devices found: skipping the START/STOP, write and read tests");
+    }
+
+    // Output the results
+    int result = EXIT_OK;
+    FILE* out = stdout;
+    if (output_path != NULL) {
+        out = fopen(output_path, "w");
+        if (out == NULL) {
+            print_error("Could not open %s - %s (%d)", output_path, strerror(errno), errno);
+            out = stdout;
+            result = EXIT_ERR;
+        }
+    }
+
+    if (do_json) {
+        output_json(out, sd, argv[1]);
+    } else {
+        output_csv(out, sd);
+    }
+
+    if (out != stdout) fclose(out);
+    i2c_close(sd);
+    return result;
+}
+
+
+#pragma mark - Tests
+
+/**
+ * @brief Time how long it takes to open a bus host's port
+ *        and handshake with it.
+ *
+ * @param device_path: The bus host's device path.
+ * @param iterations:  The number of connections to make.
+ */
+static void run_handshakes(const char* device_path, uint32_t iterations) {
+
+    BenchResult* result = &results[result_count++];
+    result->test = "handshake";
+    result->iterations = iterations;
+
+    uint64_t start_us = get_time_us();
+    for (uint32_t i = 0 ; i < iterations ; ++i) {
+        uint64_t op_start_us = get_time_us();
+        I2CDriver* sd = i2c_open(device_path);
+        i2c_stats_add(&result->histogram, (uint32_t)(get_time_us() - op_start_us));
+        if (sd == NULL) {
+            result->errors++;
+        } else {
+            i2c_close(sd);
+        }
+    }
+
+    result->elapsed_us = get_time_us() - start_us;
+}
+
+
+/**
+ * @brief Run one test, timing each iteration.
+ *
+ * @param sd:         Pointer to an I2CDriver structure.
+ * @param test:       The test's name.
+ * @param size:       The number of bytes each iteration transfers, or 0.
+ * @param iterations: The number of iterations.
+ * @param op:         The operation to time.
+ */
+static void run_test(I2CDriver *sd, const char* test, size_t size, uint32_t iterations, BenchOp op) {
+
+    if (result_count == BENCH_RESULTS_MAX) return;
+    BenchResult* result = &results[result_count++];
+    result->test = test;
+    result->size = size;
+    result->iterations = iterations;
+
+    uint64_t start_us = get_time_us();
+    for (uint32_t i = 0 ; i < iterations ; ++i) {
+        uint64_t op_start_us = get_time_us();
+        if (!op(sd, size)) result->errors++;
+        i2c_stats_add(&result->histogram, (uint32_t)(get_time_us() - op_start_us));
+    }
+
+    result->elapsed_us = get_time_us() - start_us;
+}
+
+
+/**
+ * @brief Get the bus host's information string.
+ */
+static bool op_info(I2CDriver *sd, size_t size) {
+
+    return i2c_get_info(sd, false);
+}
+
+
+/**
+ * @brief Scan the bus.
+ */
+static bool op_scan(I2CDriver *sd, size_t size) {
+
+    uint8_t devices[CONNECTED_DEVICES_MAX_B];
+    return (i2c_scan(sd, devices, sizeof(devices)) != -1);
+}
+
+
+/**
+ * @brief Issue a START then a STOP, each awaiting its ACK.
+ */
+static bool op_start_stop(I2CDriver *sd, size_t size) {
+
+    bool is_ok = i2c_start(sd, device_address, 0);
+    return i2c_stop(sd) && is_ok;
+}
+
+
+/**
+ * @brief Write bytes to the device as `cli2c w` does: START and
+ *        data are sent back to back where the bus host supports it.
+ */
+static bool op_write(I2CDriver *sd, size_t size) {
+
+    i2c_pipeline_begin(sd);
+    i2c_start(sd, device_address, 0);
+    i2c_write(sd, data_buffer, size);
+    return i2c_pipeline_end(sd);
+}
+
+
+/**
+ * @brief Read bytes from the device as `cli2c r` does.
+ */
+static bool op_read(I2CDriver *sd, size_t size) {
+
+    bool is_ok = i2c_start(sd, device_address, 1);
+    if (is_ok) is_ok = (i2c_read(sd, data_buffer, size) == size);
+    return i2c_stop(sd) && is_ok;
+}
+
+
+#pragma mark - Output Functions
+
+/**
+ * @brief Output the results as CSV, one row per test, with the bus
+ *        host's model and firmware on each row so that runs on
+ *        different boards can be concatenated.
+ *
+ * @param out: The stream to write to.
+ * @param sd:  Pointer to an I2CDriver structure.
+ */
+static void output_csv(FILE* out, I2CDriver *sd) {
+
+    I2CHostInfo info;
+    i2c_get_host_info(sd, &info);
+    fprintf(out, "host,firmware,test,size,iterations,errors,mean_us,p50_us,p99_us,max_us,ops_per_s,bytes_per_s\n");
+    for (uint32_t i = 0 ; i < result_count ; ++i) {
+        const BenchResult* result = &results[i];
+        double seconds = (double)result->elapsed_us / 1000000.0;
+        double ops_per_s = seconds > 0 ? result->iterations / seconds : 0;
+        fprintf(out, "%s,%s,%s,%zu,%u,%u,%" PRIu64 ",%u,%u,%u,%.1f,%.1f\n",
+                info.model, info.version, result->test, result->size,
+                result->iterations, result->errors,
+                result->histogram.total_us / result->histogram.count,
+                i2c_stats_percentile(&result->histogram, 50.0),
+                i2c_stats_percentile(&result->histogram, 99.0),
+                result->histogram.max_us,
+                ops_per_s, ops_per_s * result->size);
+    }
+}
+
+
+/**
+ * @brief Output the results as a JSON object.
+ *
+ * @param out:         The stream to write to.
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param device_path: The bus host's device path.
+ */
+static void output_json(FILE* out, I2CDriver *sd, const char* device_path) {
+
+    I2CHostInfo info;
+    i2c_get_host_info(sd, &info);
+    fprintf(out, "{\"device\":\"");
+    for (const char* c = device_path ; *c != '\0' ; ++c) {
+        if (*c == '"' || *c == '\\') fputc('\\', out);
+        fputc(*c, out);
+    }
+
+    fprintf(out, "\",\"host\":\"%s\",\"firmware\":\"%s\",\"frequency_khz\":%u,\"capabilities\":%u,\"address\":%u,\"results\":[",
+            info.model, info.version, info.speed, info.capabilities, device_address);
+
+    for (uint32_t i = 0 ; i < result_count ; ++i) {
+        const BenchResult* result = &results[i];
+        double seconds = (double)result->elapsed_us / 1000000.0;
+        double ops_per_s = seconds > 0 ? result->iterations / seconds : 0;
+        fprintf(out, "%s\n{\"test\":\"%s\",\"size\":%zu,\"iterations\":%u,\"errors\":%u,\"mean_us\":%" PRIu64 ",\"p50_us\":%u,\"p99_us\":%u,\"max_us\":%u,\"ops_per_s\":%.1f,\"bytes_per_s\":%.1f}",
+                i > 0 ? "," : "", result->test, result->size,
+                result->iterations, result->errors,
+                result->histogram.total_us / result->histogram.count,
+                i2c_stats_percentile(&result->histogram, 50.0),
+                i2c_stats_percentile(&result->histogram, 99.0),
+                result->histogram.max_us,
+                ops_per_s, ops_per_s * result->size);
+    }
+
+    fprintf(out, "\n]}\n");
+}
+
+
+#pragma mark - Misc Functions
+
+/**
+ * @brief Get the monotonic time in microseconds.
+ *
+ * @retval The time.
+ */
+static inline uint64_t get_time_us(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+
+/**
+ * @brief Show help.
+ */
+static inline void show_help(void) {
+
+    fprintf(stderr, "cli2c-bench {device} [options]\n\n");
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "  {device} is a mandatory device path, eg. /dev/ttyACM0.\n");
+    fprintf(stderr, "  [options] are optional settings, as shown below.\n\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --address {address}              The I2C device to write to and read from. The write\n");
+    fprintf(stderr, "                                   tests only run when this is set. Default: the first\n");
+    fprintf(stderr, "                                   device found by a scan, for reads only.\n");
+    fprintf(stderr, "  --iterations {count}             The number of times to run each test. Default: %u\n", BENCH_ITERATIONS_DEFAULT);
+    fprintf(stderr, "  --csv | --json                   The output format. Default: CSV\n");
+    fprintf(stderr, "  --output {path}                  Write the results to a file. Default: stdout\n\n");
+    fprintf(stderr, "cli2c-bench times connecting to the bus host, getting its information, scanning,\n");
+    fprintf(stderr, "START/STOP round trips, and writes and reads of 1 to %u bytes.\n", BENCH_CHUNK_MAX_B);
+    fprintf(stderr, "WARNING The write tests write zeros to the --address device, from register 0.\n");
+}
+
+
+/**
+ * @brief Show app version.
+ */
+static inline void show_version(void) {
+
+    fprintf(stderr, "cli2c-bench %s\n", APP_VERSION);
+    fprintf(stderr, "Copyright © 2023, Tony Smith.\n");
+}
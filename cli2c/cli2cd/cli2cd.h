@@ -0,0 +1,56 @@
+/*
+ * cli2cd - I2C bus host daemon
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#ifndef _CLI2CD_H_
+#define _CLI2CD_H_
+
+
+/*
+ * CONSTANTS
+ */
+// Where the daemon listens if no socket path is given: this name in
+// $XDG_RUNTIME_DIR or, if that's not set, the per-user fallback path,
+// where `%u` is the user's ID
+#define CLI2CD_SOCKET_NAME              "cli2cd.sock"
+#define CLI2CD_SOCKET_PATH_FALLBACK     "/tmp/cli2cd-%u.sock"
+
+// Wire format. All multi-byte values are little endian.
+//
+// Request:  address, flags, write_count (2 bytes), read_count (2 bytes),
+//           then `write_count` bytes to write
+// Response: status, reserved, read_count (2 bytes),
+//           then `read_count` bytes read
+//
+// A request is a single I2C transaction: the daemon writes the bytes
+// (if any), reads the bytes (if any) after a repeated START, then
+// issues a STOP. Requests from different clients are never interleaved
+// on the bus. A request with no bytes to write or read probes the address.
+//
+// The repeated START needs a bus host that supports the transfer
+// command, and no more than I2C_TRANSFER_LENGTH_MAX_B (64) bytes each
+// to write and to read. Otherwise the write ends with a STOP and the
+// read is made separately, unless the request sets
+// CLI2CD_FLAG_REPEATED_START, in which case it fails with
+// CLI2CD_STATUS_UNSUPPORTED and nothing is sent to the device.
+#define CLI2CD_REQUEST_HEADER_B         6
+#define CLI2CD_RESPONSE_HEADER_B        4
+#define CLI2CD_DATA_MAX_B               4096
+
+// Request flags
+#define CLI2CD_FLAG_INFO                0x01    // Return bus state instead: bus, SDA pin, SCL pin, speed (kHz, 2 bytes)
+#define CLI2CD_FLAG_REPEATED_START      0x02    // Fail rather than read after a STOP
+
+// Response status values
+#define CLI2CD_STATUS_OK                0x00
+#define CLI2CD_STATUS_NACK              0x01    // The bus host reported an error
+#define CLI2CD_STATUS_IO                0x02    // The bus host didn't respond
+#define CLI2CD_STATUS_BAD_REQUEST       0x03    // The request was malformed or too large
+#define CLI2CD_STATUS_UNSUPPORTED       0x04    // The bus host can't make the transaction with a repeated START
+
+
+#endif      // _CLI2CD_H_
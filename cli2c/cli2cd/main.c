@@ -0,0 +1,528 @@
+/*
+ * cli2cd - I2C bus host daemon
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static int          open_socket(const char* path);
+static bool         is_socket_live(const struct sockaddr_un* address);
+static void         get_default_socket_path(char* path, size_t size);
+static void         serve(I2CDriver* sd, int listen_fd);
+static void         accept_client(int listen_fd);
+static bool         service_client(I2CDriver* sd, Client* client, short events);
+static bool         run_requests(I2CDriver* sd, Client* client);
+static void         run_transaction(I2CDriver* sd, const uint8_t* request, uint8_t* response);
+static bool         send_output(Client* client);
+static inline bool  can_read(const Client* client);
+static inline bool  has_request(const Client* client);
+static void         close_client(Client* client);
+static void         stop_handler(int dummy);
+static inline void  show_help(void);
+static inline void  show_version(void);
+
+
+/*
+ * GLOBALS
+ */
+// Hold an I2C data structure
+I2CDriver* i2c = NULL;
+
+// Connected clients
+static Client clients[CLI2CD_CLIENTS_MAX];
+
+// Cleared by the signal handler to end the service loop
+static volatile sig_atomic_t do_run = 1;
+
+
+/**
+ * @brief Main entry point.
+ */
+int main(int argc, char *argv[]) {
+
+    // Process arguments
+    if (argc < 2) {
+        // Insufficient arguments -- issue usage info and bail
+        fprintf(stderr, "Usage: cli2cd {DEVICE_PATH} [SOCKET_PATH]\n");
+        return EXIT_OK;
+    }
+
+    // Check for a help and/or version request
+    for (int i = 0 ; i < argc ; ++i) {
+        if (strcasecmp(argv[i], "h") == 0 ||
+            strcasecmp(argv[i], "--help") == 0 ||
+            strcasecmp(argv[i], "-h") == 0) {
+            show_help();
+            return EXIT_OK;
+        }
+
+        if (strcasecmp(argv[i], "v") == 0 ||
+            strcasecmp(argv[i], "--version") == 0 ||
+            strcasecmp(argv[i], "-v") == 0) {
+            show_version();
+            return EXIT_OK;
+        }
+    }
+
+    char default_path[PATH_MAX];
+    get_default_socket_path(default_path, sizeof(default_path));
+    const char* socket_path = (argc > 2 ? argv[2] : default_path);
+
+    // Connect to the bus host and set up the bus once, for all clients
+    i2c = i2c_open(argv[1]);
+    if (i2c == NULL) return EXIT_ERR;
+
+    if (!i2c_init(i2c)) print_warning("I2C init un-ACK’d");
+    i2c_get_info(i2c, false);
+
+    // Open the socket clients will connect to
+    int listen_fd = open_socket(socket_path);
+    if (listen_fd == -1) {
+        i2c_close(i2c);
+        return EXIT_ERR;
+    }
+
+    // Stop cleanly on SIGINT and SIGTERM, and don't die when
+    // a client goes away before it has read its response
+    signal(SIGINT, stop_handler);
+    signal(SIGTERM, stop_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    I2CHostInfo info;
+    i2c_get_host_info(i2c, &info);
+    print_log("Serving I2C bus %i (SDA GP%i, SCL GP%i, %ikHz) at %s",
+              info.bus, info.sda_pin, info.scl_pin, info.speed, socket_path);
+    serve(i2c, listen_fd);
+
+    // Tidy up
+    for (uint32_t i = 0 ; i < CLI2CD_CLIENTS_MAX ; ++i) close_client(&clients[i]);
+    close(listen_fd);
+    unlink(socket_path);
+    i2c_close(i2c);
+    return EXIT_OK;
+}
+
+
+/**
+ * @brief Create, bind and listen on the daemon's Unix domain socket.
+ *        Any stale socket file at the path is removed first.
+ *
+ * @param path: The socket's file system path.
+ *
+ * @retval The socket's file descriptor, or -1 on error.
+ */
+static int open_socket(const char* path) {
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        print_error("Socket path %s is too long", path);
+        return -1;
+    }
+
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        print_error("Could not create socket: %s (%i)", strerror(errno), errno);
+        return -1;
+    }
+
+    // Don't take over a live daemon's socket, or delete
+    // anything at the path that isn't our own stale socket
+    struct stat info;
+    if (lstat(path, &info) == 0) {
+        if (!S_ISSOCK(info.st_mode) || info.st_uid != getuid()) {
+            print_error("%s is in use, and not by one of our sockets", path);
+            close(fd);
+            return -1;
+        }
+
+        if (is_socket_live(&address)) {
+            print_error("Another cli2cd is already serving %s", path);
+            close(fd);
+            return -1;
+        }
+
+        unlink(path);
+    }
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) == -1 || listen(fd, CLI2CD_CLIENTS_MAX) == -1) {
+        print_error("Could not listen on %s: %s (%i)", path, strerror(errno), errno);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/**
+ * @brief Check whether a daemon is listening on a socket.
+ *
+ * @param address: The socket's address.
+ *
+ * @retval Whether a daemon answered (`true`) or not (`false`).
+ */
+static bool is_socket_live(const struct sockaddr_un* address) {
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) return false;
+    bool is_live = (connect(fd, (const struct sockaddr*)address, sizeof(*address)) == 0);
+    close(fd);
+    return is_live;
+}
+
+
+/**
+ * @brief Get the socket path to use if none is given: in the user's
+ *        runtime directory if there is one, otherwise a path in
+ *        `/tmp` that includes the user's ID.
+ *
+ * @param path: A buffer for the path.
+ * @param size: The size of the buffer.
+ */
+static void get_default_socket_path(char* path, size_t size) {
+
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir != NULL && runtime_dir[0] != '\0') {
+        snprintf(path, size, "%s/%s", runtime_dir, CLI2CD_SOCKET_NAME);
+    } else {
+        snprintf(path, size, CLI2CD_SOCKET_PATH_FALLBACK, (unsigned int)getuid());
+    }
+}
+
+
+/**
+ * @brief Service clients until signalled to stop. Transactions are
+ *        run to completion one at a time, so each is atomic on the bus.
+ *        Client sockets are non-blocking: responses are queued and sent
+ *        as each client reads them, so a client that stops reading can't
+ *        stall the others.
+ *
+ * @param sd:        Pointer to an I2CDriver structure.
+ * @param listen_fd: The daemon's listening socket.
+ */
+static void serve(I2CDriver* sd, int listen_fd) {
+
+    struct pollfd fds[CLI2CD_CLIENTS_MAX + 1];
+    for (uint32_t i = 0 ; i < CLI2CD_CLIENTS_MAX ; ++i) clients[i].fd = -1;
+
+    while (do_run) {
+        // Watch the listening socket and every connected client
+        nfds_t count = 0;
+        fds[count].fd = listen_fd;
+        fds[count++].events = POLLIN;
+
+        for (uint32_t i = 0 ; i < CLI2CD_CLIENTS_MAX ; ++i) {
+            if (clients[i].fd != -1) {
+                // A client with responses waiting to go out sends no more
+                // requests until it has read enough of them. Requests
+                // already received are run when there's room to respond
+                bool can_write = clients[i].output_count > 0 || has_request(&clients[i]);
+                fds[count].fd = clients[i].fd;
+                fds[count].events = (can_read(&clients[i]) ? POLLIN : 0) | (can_write ? POLLOUT : 0);
+                count++;
+            }
+        }
+
+        if (poll(fds, count, -1) == -1) {
+            if (errno == EINTR) continue;
+            print_error("Could not poll clients: %s (%i)", strerror(errno), errno);
+            break;
+        }
+
+        // Service clients in slot order
+        for (nfds_t i = 1 ; i < count ; ++i) {
+            if (fds[i].revents == 0) continue;
+
+            for (uint32_t j = 0 ; j < CLI2CD_CLIENTS_MAX ; ++j) {
+                if (clients[j].fd == fds[i].fd) {
+                    if (!service_client(sd, &clients[j], fds[i].revents)) close_client(&clients[j]);
+                    break;
+                }
+            }
+        }
+
+        if (fds[0].revents & POLLIN) accept_client(listen_fd);
+    }
+}
+
+
+/**
+ * @brief Accept a new client connection, if there's a free slot for it.
+ *
+ * @param listen_fd: The daemon's listening socket.
+ */
+static void accept_client(int listen_fd) {
+
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd == -1) return;
+
+    int flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        print_warning("Could not make client socket non-blocking: %s (%i)", strerror(errno), errno);
+        close(fd);
+        return;
+    }
+
+    for (uint32_t i = 0 ; i < CLI2CD_CLIENTS_MAX ; ++i) {
+        if (clients[i].fd == -1) {
+            clients[i].fd = fd;
+            clients[i].count = 0;
+            clients[i].output_count = 0;
+            return;
+        }
+    }
+
+    print_warning("Client limit (%i) reached", CLI2CD_CLIENTS_MAX);
+    close(fd);
+}
+
+
+/**
+ * @brief Send queued responses to a client, read any data it has sent,
+ *        and run every complete request that there's room to respond to.
+ *
+ * @param sd:     Pointer to an I2CDriver structure.
+ * @param client: Pointer to the client's record.
+ * @param events: The events polled on the client's socket.
+ *
+ * @retval Whether the client should stay connected (`true`) or not (`false`).
+ */
+static bool service_client(I2CDriver* sd, Client* client, short events) {
+
+    if (events & POLLNVAL) return false;
+    if ((events & (POLLOUT | POLLERR | POLLHUP)) && !send_output(client)) return false;
+
+    if ((events & (POLLIN | POLLERR | POLLHUP)) && can_read(client)) {
+        ssize_t result = read(client->fd, client->request + client->count, sizeof(client->request) - client->count);
+        if (result == 0) return false;
+        if (result == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+        } else {
+            client->count += result;
+        }
+    }
+
+    if (!run_requests(sd, client)) return false;
+    return send_output(client);
+}
+
+
+/**
+ * @brief Run each complete request a client has sent, in turn, while
+ *        its output buffer has room for the response.
+ *
+ * @param sd:     Pointer to an I2CDriver structure.
+ * @param client: Pointer to the client's record.
+ *
+ * @retval Whether the client should stay connected (`true`) or not (`false`).
+ */
+static bool run_requests(I2CDriver* sd, Client* client) {
+
+    while (client->count >= CLI2CD_REQUEST_HEADER_B) {
+        uint8_t* header = client->request;
+        size_t write_count = header[2] | (header[3] << 8);
+        size_t read_count  = header[4] | (header[5] << 8);
+        uint8_t* response = client->output + client->output_count;
+
+        // Reject requests we can't buffer, then drop the client:
+        // we can no longer tell where its next request starts.
+        // The rejection is sent if the client is reading
+        if (write_count > CLI2CD_DATA_MAX_B || read_count > CLI2CD_DATA_MAX_B) {
+            if (client->output_count + CLI2CD_RESPONSE_HEADER_B <= sizeof(client->output)) {
+                memset(response, 0, CLI2CD_RESPONSE_HEADER_B);
+                response[0] = CLI2CD_STATUS_BAD_REQUEST;
+                client->output_count += CLI2CD_RESPONSE_HEADER_B;
+                send_output(client);
+            }
+
+            return false;
+        }
+
+        // Wait for the rest of the request, and for room to respond
+        size_t request_length = CLI2CD_REQUEST_HEADER_B + write_count;
+        if (client->count < request_length) break;
+        if (client->output_count + CLI2CD_RESPONSE_HEADER_B + CLI2CD_DATA_MAX_B > sizeof(client->output)) break;
+
+        run_transaction(sd, client->request, response);
+        client->output_count += CLI2CD_RESPONSE_HEADER_B + (response[2] | (response[3] << 8));
+
+        // Move any further requests to the front of the buffer
+        client->count -= request_length;
+        memmove(client->request, client->request + request_length, client->count);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Perform a client's I2C transaction: write, then read
+ *        after a repeated START, then STOP. Without a repeated START,
+ *        the write and read are made separately, unless the client
+ *        has asked for the transaction to fail instead.
+ *
+ * @param sd:       Pointer to an I2CDriver structure.
+ * @param request:  The complete request: header and bytes to write.
+ * @param response: Buffer for the response: header and bytes read.
+ */
+static void run_transaction(I2CDriver* sd, const uint8_t* request, uint8_t* response) {
+
+    uint8_t address = request[0];
+    uint8_t flags = request[1];
+    size_t write_count = request[2] | (request[3] << 8);
+    size_t read_count  = request[4] | (request[5] << 8);
+    uint8_t* read_data = response + CLI2CD_RESPONSE_HEADER_B;
+    uint8_t status = CLI2CD_STATUS_OK;
+    size_t bytes_read = 0;
+
+    if (flags & CLI2CD_FLAG_INFO) {
+        // Report the bus state we hold for clients
+        I2CHostInfo info;
+        i2c_get_host_info(sd, &info);
+        read_data[0] = info.bus;
+        read_data[1] = (uint8_t)info.sda_pin;
+        read_data[2] = (uint8_t)info.scl_pin;
+        read_data[3] = info.speed & 0xFF;
+        read_data[4] = (info.speed >> 8) & 0xFF;
+        bytes_read = 5;
+    } else if ((flags & CLI2CD_FLAG_REPEATED_START) && write_count > 0 && read_count > 0 &&
+               !i2c_can_transfer(sd, write_count, read_count)) {
+        // The client needs a repeated START we can't provide
+        status = CLI2CD_STATUS_UNSUPPORTED;
+    } else if (i2c_transaction(sd, address, request + CLI2CD_REQUEST_HEADER_B, write_count, read_data, read_count)) {
+        bytes_read = read_count;
+    } else {
+        // Distinguish errors reported by the bus host from no response
+        status = (i2c_get_failed_op(sd) != 0) ? CLI2CD_STATUS_NACK : CLI2CD_STATUS_IO;
+    }
+
+    response[0] = status;
+    response[1] = 0;
+    response[2] = bytes_read & 0xFF;
+    response[3] = (bytes_read >> 8) & 0xFF;
+}
+
+
+/**
+ * @brief Send as much of a client's queued output as its socket will
+ *        take without blocking.
+ *
+ * @param client: Pointer to the client's record.
+ *
+ * @retval Whether the client should stay connected (`true`) or not (`false`).
+ */
+static bool send_output(Client* client) {
+
+    size_t sent = 0;
+    while (sent < client->output_count) {
+        ssize_t result = write(client->fd, client->output + sent, client->output_count - sent);
+        if (result == -1) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+
+        sent += result;
+    }
+
+    // Move any unsent output to the front of the buffer
+    client->output_count -= sent;
+    memmove(client->output, client->output + sent, client->output_count);
+    return true;
+}
+
+
+/**
+ * @brief Whether to read more requests from a client: it must have
+ *        room for them, and room to queue a response.
+ *
+ * @param client: Pointer to the client's record.
+ *
+ * @retval Whether to read from the client (`true`) or not (`false`).
+ */
+static inline bool can_read(const Client* client) {
+
+    return client->count < sizeof(client->request) &&
+           client->output_count + CLI2CD_RESPONSE_HEADER_B + CLI2CD_DATA_MAX_B <= sizeof(client->output);
+}
+
+
+/**
+ * @brief Whether a client has sent a complete request that has yet to be run.
+ *
+ * @param client: Pointer to the client's record.
+ *
+ * @retval Whether there's a request to run (`true`) or not (`false`).
+ */
+static inline bool has_request(const Client* client) {
+
+    if (client->count < CLI2CD_REQUEST_HEADER_B) return false;
+    size_t write_count = client->request[2] | (client->request[3] << 8);
+    return client->count >= CLI2CD_REQUEST_HEADER_B + write_count;
+}
+
+
+/**
+ * @brief Disconnect a client and free its slot.
+ *
+ * @param client: Pointer to the client's record.
+ */
+static void close_client(Client* client) {
+
+    if (client->fd != -1) {
+        close(client->fd);
+        client->fd = -1;
+        client->count = 0;
+        client->output_count = 0;
+    }
+}
+
+
+/**
+ * @brief Callback for SIGINT and SIGTERM: end the service loop.
+ *
+ * @param dummy: Not used.
+ */
+static void stop_handler(int dummy) {
+
+    do_run = 0;
+}
+
+
+/**
+ * @brief Show help.
+ */
+static inline void show_help(void) {
+
+    fprintf(stderr, "cli2cd {device} [socket]\n\n");
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "  {device} is a mandatory device path, eg. /dev/cu.usbmodem-101.\n");
+    fprintf(stderr, "  [socket] is an optional path for the daemon's Unix domain socket.\n");
+    char default_path[PATH_MAX];
+    get_default_socket_path(default_path, sizeof(default_path));
+    fprintf(stderr, "           Default: %s\n\n", default_path);
+    fprintf(stderr, "cli2cd holds the bus host's port open and runs I2C transactions\n");
+    fprintf(stderr, "sent by clients to the socket, one at a time.\n");
+}
+
+
+/**
+ * @brief Show app version.
+ */
+static inline void show_version(void) {
+
+    fprintf(stderr, "cli2cd %s\n", APP_VERSION);
+    fprintf(stderr, "Copyright © 2023, Tony Smith.\n");
+}
@@ -0,0 +1,44 @@
+/*
+ * cli2cd - I2C bus host daemon
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#ifndef _MAIN_H_
+#define _MAIN_H_
+
+
+/*
+ * INCLUDES
+ */
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "i2cdriver.h"
+#include "utils.h"
+#include "cli2cd.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define CLI2CD_CLIENTS_MAX              32
+// Room for two of the largest responses: one being sent, one queued
+#define CLI2CD_OUTPUT_MAX_B             (2 * (CLI2CD_RESPONSE_HEADER_B + CLI2CD_DATA_MAX_B))
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    int             fd;                 // Client socket, or -1 if the slot is free
+    size_t          count;              // Bytes received but not yet processed
+    uint8_t         request[CLI2CD_REQUEST_HEADER_B + CLI2CD_DATA_MAX_B];
+    size_t          output_count;       // Response bytes not yet sent
+    uint8_t         output[CLI2CD_OUTPUT_MAX_B];
+} Client;
+
+
+#endif      // _MAIN_H_
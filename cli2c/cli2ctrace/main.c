@@ -0,0 +1,86 @@
+/*
+ * cli2ctrace - export cli2c trace files
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#include "i2cdriver.h"
+#include "utils.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static inline void  show_help(void);
+static inline void  show_version(void);
+
+
+/**
+ * @brief Main entry point.
+ */
+int main(int argc, char *argv[]) {
+
+    // Process arguments
+    if (argc < 2) {
+        // Insufficient arguments -- issue usage info and bail
+        fprintf(stderr, "Usage: cli2ctrace {TRACE_PATH} [JSON_PATH]\n");
+        return EXIT_OK;
+    }
+
+    // Check for a help and/or version request
+    for (int i = 0 ; i < argc ; ++i) {
+        if (strcasecmp(argv[i], "h") == 0 ||
+            strcasecmp(argv[i], "--help") == 0 ||
+            strcasecmp(argv[i], "-h") == 0) {
+            show_help();
+            return EXIT_OK;
+        }
+
+        if (strcasecmp(argv[i], "v") == 0 ||
+            strcasecmp(argv[i], "--version") == 0 ||
+            strcasecmp(argv[i], "-v") == 0) {
+            show_version();
+            return EXIT_OK;
+        }
+    }
+
+    FILE* out = stdout;
+    if (argc > 2) {
+        out = fopen(argv[2], "w");
+        if (out == NULL) {
+            print_error("Could not open %s - %s (%d)", argv[2], strerror(errno), errno);
+            return EXIT_ERR;
+        }
+    }
+
+    bool result = i2c_trace_export(argv[1], out);
+    if (out != stdout) fclose(out);
+    return result ? EXIT_OK : EXIT_ERR;
+}
+
+
+/**
+ * @brief Show help.
+ */
+static inline void show_help(void) {
+
+    fprintf(stderr, "cli2ctrace {trace} [json]\n\n");
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "  {trace} is a mandatory trace file path, as recorded by cli2c --trace or\n");
+    fprintf(stderr, "          by any app run with %s set to a path.\n", I2C_TRACE_ENV_VAR);
+    fprintf(stderr, "  [json] is an optional output path. Default: stdout\n\n");
+    fprintf(stderr, "cli2ctrace writes the trace as Chrome trace JSON, for Perfetto\n");
+    fprintf(stderr, "or chrome://tracing.\n");
+}
+
+
+/**
+ * @brief Show app version.
+ */
+static inline void show_version(void) {
+
+    fprintf(stderr, "cli2ctrace %s\n", APP_VERSION);
+    fprintf(stderr, "Copyright © 2023, Tony Smith.\n");
+}
@@ -0,0 +1,290 @@
+/*
+ * Generic macOS I2C driver - Asynchronous Transactions
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#include "i2casync.h"
+#include "utils.h"
+#ifdef BUILD_FOR_LINUX
+#include <sys/eventfd.h>
+#endif
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void*    io_thread(void* arg);
+static void     complete(I2CTransaction* transaction, void* context);
+static bool     open_event(I2CAsync* async);
+static void     close_event(I2CAsync* async);
+static void     signal_event(I2CAsync* async);
+static void     clear_event(I2CAsync* async);
+
+
+/**
+ * @brief Start an I/O thread to run transactions on a connection.
+ *        From now on, only the I/O thread should use the connection,
+ *        until `i2c_async_stop()` is called.
+ *
+ * @param sd: Pointer to a connected I2CDriver structure.
+ *
+ * @retval The async record, or NULL on error.
+ */
+I2CAsync* i2c_async_start(I2CDriver *sd) {
+
+    I2CAsync* async = calloc(1, sizeof(I2CAsync));
+    if (async == NULL) return NULL;
+
+    async->sd = sd;
+    async->is_running = true;
+    if (!open_event(async)) {
+        free(async);
+        return NULL;
+    }
+
+    pthread_mutex_init(&async->lock, NULL);
+    pthread_cond_init(&async->wake, NULL);
+
+    if (pthread_create(&async->thread, NULL, io_thread, async) != 0) {
+        print_error("Could not start I/O thread - %s (%d)", strerror(errno), errno);
+        pthread_cond_destroy(&async->wake);
+        pthread_mutex_destroy(&async->lock);
+        close_event(async);
+        free(async);
+        return NULL;
+    }
+
+    return async;
+}
+
+
+/**
+ * @brief Complete all submitted transactions, then stop the I/O
+ *        thread and free the async record. Completed transactions
+ *        not yet collected are abandoned to their owners.
+ *
+ * @param async: The async record.
+ */
+void i2c_async_stop(I2CAsync* async) {
+
+    if (async == NULL) return;
+
+    pthread_mutex_lock(&async->lock);
+    async->is_running = false;
+    pthread_cond_signal(&async->wake);
+    pthread_mutex_unlock(&async->lock);
+    pthread_join(async->thread, NULL);
+
+    pthread_cond_destroy(&async->wake);
+    pthread_mutex_destroy(&async->lock);
+    close_event(async);
+    free(async);
+}
+
+
+/**
+ * @brief Queue a transaction for the I/O thread. Returns at once.
+ *
+ * @param async:       The async record.
+ * @param transaction: The transaction.
+ *
+ * @retval Whether the transaction was queued (`true`) or not (`false`).
+ */
+bool i2c_async_submit(I2CAsync* async, I2CTransaction* transaction) {
+
+    transaction->next = NULL;
+    transaction->succeeded = false;
+
+    pthread_mutex_lock(&async->lock);
+    bool is_running = async->is_running;
+    if (is_running) {
+        if (async->queue_tail != NULL) {
+            async->queue_tail->next = transaction;
+        } else {
+            async->queue_head = transaction;
+        }
+
+        async->queue_tail = transaction;
+        pthread_cond_signal(&async->wake);
+    }
+
+    pthread_mutex_unlock(&async->lock);
+    return is_running;
+}
+
+
+/**
+ * @brief Get a file descriptor that's readable while there are completed
+ *        transactions to collect, for use with `poll()` etc.
+ *
+ * @param async: The async record.
+ *
+ * @retval The file descriptor.
+ */
+int i2c_async_get_fd(I2CAsync* async) {
+
+    return async->event_fds[0];
+}
+
+
+/**
+ * @brief Collect a completed transaction that has no callback.
+ *
+ * @param async: The async record.
+ *
+ * @retval The oldest completed transaction, or NULL if there are none.
+ */
+I2CTransaction* i2c_async_next_completed(I2CAsync* async) {
+
+    pthread_mutex_lock(&async->lock);
+    I2CTransaction* transaction = async->done_head;
+    if (transaction != NULL) {
+        async->done_head = transaction->next;
+        if (async->done_head == NULL) {
+            async->done_tail = NULL;
+            clear_event(async);
+        }
+
+        transaction->next = NULL;
+    }
+
+    pthread_mutex_unlock(&async->lock);
+    return transaction;
+}
+
+
+/**
+ * @brief The I/O thread: run queued transactions until stopped,
+ *        then finish any that remain. Each batch is pipelined, so
+ *        the bus host can have several transactions in hand.
+ *
+ * @param arg: The async record.
+ */
+static void* io_thread(void* arg) {
+
+    I2CAsync* async = (I2CAsync*)arg;
+
+    pthread_mutex_lock(&async->lock);
+    while (true) {
+        while (async->queue_head == NULL && async->is_running) {
+            pthread_cond_wait(&async->wake, &async->lock);
+        }
+
+        if (async->queue_head == NULL) break;
+
+        // Take everything queued so far, so callers can keep
+        // submitting while we work
+        I2CTransaction* batch = async->queue_head;
+        async->queue_head = NULL;
+        async->queue_tail = NULL;
+        pthread_mutex_unlock(&async->lock);
+
+        i2c_transaction_batch(async->sd, batch, complete, async);
+        pthread_mutex_lock(&async->lock);
+    }
+
+    pthread_mutex_unlock(&async->lock);
+    return NULL;
+}
+
+
+/**
+ * @brief Pass on a completed transaction: call its callback,
+ *        or add it to the list for `i2c_async_next_completed()`.
+ *
+ * @param transaction: The transaction.
+ * @param context:     The async record.
+ */
+static void complete(I2CTransaction* transaction, void* context) {
+
+    I2CAsync* async = (I2CAsync*)context;
+
+    if (transaction->callback != NULL) {
+        transaction->callback(transaction, transaction->context);
+        return;
+    }
+
+    pthread_mutex_lock(&async->lock);
+    if (async->done_tail != NULL) {
+        async->done_tail->next = transaction;
+    } else {
+        async->done_head = transaction;
+        signal_event(async);
+    }
+
+    async->done_tail = transaction;
+    pthread_mutex_unlock(&async->lock);
+}
+
+
+/**
+ * @brief Create the completion event: an eventfd on Linux,
+ *        a non-blocking pipe on macOS.
+ *
+ * @param async: The async record.
+ *
+ * @retval Whether the event was created (`true`) or not (`false`).
+ */
+static bool open_event(I2CAsync* async) {
+
+#ifdef BUILD_FOR_LINUX
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    async->event_fds[0] = fd;
+    async->event_fds[1] = fd;
+    if (fd != -1) return true;
+#else
+    if (pipe(async->event_fds) == 0) {
+        fcntl(async->event_fds[0], F_SETFL, O_NONBLOCK);
+        fcntl(async->event_fds[1], F_SETFL, O_NONBLOCK);
+        return true;
+    }
+#endif
+
+    print_error("Could not create completion event - %s (%d)", strerror(errno), errno);
+    return false;
+}
+
+
+/**
+ * @brief Close the completion event.
+ *
+ * @param async: The async record.
+ */
+static void close_event(I2CAsync* async) {
+
+    close(async->event_fds[0]);
+    if (async->event_fds[1] != async->event_fds[0]) close(async->event_fds[1]);
+}
+
+
+/**
+ * @brief Make the completion event readable.
+ *
+ * @param async: The async record.
+ */
+static void signal_event(I2CAsync* async) {
+
+#ifdef BUILD_FOR_LINUX
+    uint64_t value = 1;
+    ssize_t result = write(async->event_fds[1], &value, sizeof(value));
+#else
+    uint8_t value = 1;
+    ssize_t result = write(async->event_fds[1], &value, sizeof(value));
+#endif
+    (void)result;
+}
+
+
+/**
+ * @brief Make the completion event unreadable.
+ *
+ * @param async: The async record.
+ */
+static void clear_event(I2CAsync* async) {
+
+    uint64_t value;
+    while (read(async->event_fds[0], &value, sizeof(value)) > 0) {}
+}
@@ -0,0 +1,47 @@
+/*
+ * Generic macOS I2C driver - Asynchronous Transactions
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#ifndef _I2C_ASYNC_H
+#define _I2C_ASYNC_H
+
+
+/*
+ * INCLUDES
+ */
+#include <pthread.h>
+#include "i2cdriver.h"
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    I2CDriver*          sd;             // The connection the I/O thread owns
+    pthread_t           thread;         // The I/O thread
+    pthread_mutex_t     lock;           // Guards the lists below and `is_running`
+    pthread_cond_t      wake;           // Signalled when work is submitted
+    I2CTransaction*     queue_head;     // Submitted transactions, oldest first
+    I2CTransaction*     queue_tail;
+    I2CTransaction*     done_head;      // Completed transactions without a callback
+    I2CTransaction*     done_tail;
+    int                 event_fds[2];   // Readable when `done_head` is set: [read, write]
+    bool                is_running;     // Cleared to stop the I/O thread
+} I2CAsync;
+
+
+/*
+ * PROTOTYPES
+ */
+I2CAsync*       i2c_async_start(I2CDriver *sd);
+void            i2c_async_stop(I2CAsync* async);
+bool            i2c_async_submit(I2CAsync* async, I2CTransaction* transaction);
+int             i2c_async_get_fd(I2CAsync* async);
+I2CTransaction* i2c_async_next_completed(I2CAsync* async);
+
+
+#endif  // _I2C_ASYNC_H
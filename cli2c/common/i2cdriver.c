@@ -6,33 +6,114 @@
  * Licence: MIT
  *
  */
-#include "main.h"
+// FROM 1.2.0 -- Include only the driver's own headers, so the
+//               driver can be built as a library
+#include "i2cdriver.h"
+#include "utils.h"
+
+
+/*
+ * STRUCTURES
+ */
+// FROM 1.2.0 -- Private: apps hold a pointer from `i2c_open()`
+struct I2CDriver {
+    bool            connected;          // Set to true when connected
+    int             port;               // OS file descriptor for host
+    unsigned int    speed;              // I2C line speed (in kHz)
+    // FROM 1.2.0
+    uint8_t         rx_buffer[SERIAL_RX_BUFFER_MAX_B];  // Bytes read from the port but not yet consumed
+    size_t          rx_start;           // Index of the first unconsumed byte in `rx_buffer`
+    size_t          rx_count;           // Number of unconsumed bytes in `rx_buffer`
+    uint8_t         capabilities;       // Bus host feature flags
+    bool            is_pipelined;       // Set to true to defer ACK collection
+    uint32_t        acks_pending;       // Number of ops awaiting an ACK
+    uint8_t         pending_ops[I2C_PIPELINE_OPS_MAX];  // Command bytes of ops awaiting an ACK
+    uint8_t         failed_op;          // Command byte of the first un-ACK'd pipelined op, or 0
+    uint32_t        tx_window;          // Bytes the bus host can receive before it must ACK
+    uint32_t        tx_in_flight;       // Bytes of pipelined frames not yet ACK'd
+    uint32_t        min_gap_us;         // Optional pause between commands, for older firmware
+    uint8_t         bus;                // I2C bus in use (0 or 1), set by `i2c_get_info()`
+    int             sda_pin;            // SDA GPIO, set by `i2c_get_info()`
+    int             scl_pin;            // SCL GPIO, set by `i2c_get_info()`
+    char            host_model[25];     // Bus host board, eg. "QTPY-RP2040", set by `i2c_get_info()`
+    char            host_version[24];   // Bus host firmware version and build, set by `i2c_get_info()`
+    bool            binary_io;          // Set to true to read and write raw bytes rather than hex
+    struct iovec    tx_iov[I2C_TX_IOV_MAX];             // Queued frame segments, sent by a single writev()
+    int             tx_iov_count;       // Number of queued segments
+    uint8_t         tx_headers[I2C_TX_HEADERS_MAX_B];   // Copies of queued commands and prefix bytes
+    size_t          tx_headers_count;   // Number of bytes used in `tx_headers`
+    struct termios  original_settings;  // The port's settings before we changed them
+    I2CTrace*       trace;              // Set to record traffic with the bus host, or NULL
+    I2CStats*       stats;              // Set to gather response latencies, or NULL
+};
+
+// A response that a frame queued by `i2c_transaction_batch()` will prompt
+typedef struct {
+    I2CTransaction*     transaction;    // The transaction the frame belongs to
+    uint8_t             command;        // The frame's command byte
+    uint32_t            frame_length;   // The frame's length, credited back on response
+    uint8_t*            data;           // A buffer for data following an ACK, or NULL
+    size_t              data_count;     // The number of data bytes following an ACK
+    bool                is_last;        // Set on the transaction's final frame
+} I2CBatchStep;
+
+// The responses awaited by `i2c_transaction_batch()`, oldest first
+typedef struct {
+    I2CBatchStep        steps[I2C_PIPELINE_OPS_MAX];
+    uint32_t            first;          // Index of the oldest step
+    uint32_t            count;          // Number of steps awaiting a response
+    I2CCompletion       on_complete;    // Called as each transaction completes
+    void*               context;        // Passed to `on_complete`
+} I2CBatch;
 
 
 #pragma mark - Static Function Prototypes
 
 // FROM 1.1.1 -- implement internal functions as statics
-static int          openSerialPort(const char *portname);
-static size_t       readFromSerialPort(int fd, uint8_t* b, size_t s);
-static bool         writeToSerialPort(int fd, const uint8_t* b, size_t s);
+static int          openSerialPort(I2CDriver *sd, const char *portname);
+static size_t       readFromSerialPort(I2CDriver *sd, uint8_t* b, size_t s);
+static bool         writeToSerialPort(I2CDriver *sd, const uint8_t* b, size_t s);
 static inline void  print_bad_command_help(char* token);
 static bool         board_set_led(I2CDriver *sd, bool is_on);
 static inline void  send_command(I2CDriver *sd, char c);
+static bool         i2c_connect(I2CDriver *sd, const char* portname);
 static bool         i2c_ack(I2CDriver *sd);
 static bool         i2c_set_bus(I2CDriver *sd, uint8_t bus_id, uint8_t sda_pin, uint8_t scl_pin);
 static bool         i2c_set_speed(I2CDriver *sd, long speed);
 static bool         i2c_reset(I2CDriver *sd);
-static void         i2c_get_info(I2CDriver *sd, bool do_print);
 static bool         gpio_set_pin(I2CDriver *sd, uint8_t pin);
 static uint8_t      gpio_get_pin(I2CDriver *sd, uint8_t pin);
 // FROM 1.1.3
 static bool         board_get_last_error(I2CDriver *sd);
-
-
-#pragma mark - Globals
-
-// Retain the original port settings
-static struct termios original_settings;
+// FROM 1.2.0
+static size_t       readLineFromSerialPort(I2CDriver *sd, uint8_t* b, size_t s);
+static size_t       readResponseFromSerialPort(I2CDriver *sd, uint8_t command, uint8_t* b, size_t s);
+static bool         fillSerialBuffer(I2CDriver *sd, uint64_t deadline_us);
+static bool         waitForSerialData(int fd, uint64_t deadline_us);
+static inline uint64_t time_now_us(void);
+static bool         i2c_expect_ack(I2CDriver *sd, uint8_t op);
+static bool         i2c_pipeline_drain(I2CDriver *sd);
+static void         board_get_capabilities(I2CDriver *sd);
+static inline const char* get_op_name(uint8_t op);
+static bool         send_frame(I2CDriver *sd, const uint8_t* frame, size_t length);
+static bool         queue_frame(I2CDriver *sd, const uint8_t* header, size_t header_length, const uint8_t* data, size_t data_length);
+static bool         flush_frames(I2CDriver *sd);
+static bool         writeVectorToSerialPort(int fd, struct iovec* iov, int iov_count);
+static size_t       parse_bytes(const char* token, uint8_t* bytes, size_t max_bytes);
+static size_t       get_long_frame_length(I2CDriver *sd, size_t byte_count);
+static void         output_data(I2CDriver *sd, const uint8_t* bytes, size_t byte_count);
+static bool         i2c_write_file(I2CDriver *sd, uint8_t address, const char* path);
+static void         print_scan_table(const uint8_t* devices, int device_count);
+static int          scan_list(I2CDriver *sd, uint8_t first, uint8_t last, uint8_t devices[], size_t max_devices);
+static inline int   get_hex_value(char digit);
+static inline void  trace_status(I2CDriver *sd, bool ackd);
+static inline void  record_latency(I2CDriver *sd, uint8_t command);
+static size_t       get_transaction_length(I2CDriver *sd, const I2CTransaction* transaction);
+static bool         queue_transaction(I2CDriver *sd, I2CBatch* batch, I2CTransaction* transaction);
+static void         add_batch_step(I2CDriver *sd, I2CBatch* batch, I2CTransaction* transaction, uint8_t command, size_t frame_length, uint8_t* data, size_t data_count);
+static bool         collect_batch_response(I2CDriver *sd, I2CBatch* batch);
+static void         finish_batch(I2CDriver *sd, I2CBatch* batch);
+static void         abandon_batch(I2CDriver *sd, I2CBatch* batch);
 
 
 #pragma mark - Serial Port Control Functions
@@ -44,7 +125,7 @@ static struct termios original_settings;
  *
  * @retval The OS file descriptor, or -1 on error.
  */
-static int openSerialPort(const char *device_path) {
+static int openSerialPort(I2CDriver *sd, const char *device_path) {
 
     struct termios serial_settings;
     speed_t speed = (speed_t)203400;
@@ -63,18 +144,20 @@ static int openSerialPort(const char *device_path) {
     }
 
     // Get the port settings
-    if (tcgetattr(fd, &original_settings) != 0) {
+    // FROM 1.2.0 -- Keep them with the port's driver record
+    if (tcgetattr(fd, &sd->original_settings) != 0) {
         print_error("Could not get the port settings - %s (%d)", strerror(errno), errno);
         goto error;
     }
 
-    serial_settings = original_settings;
+    serial_settings = sd->original_settings;
 
-    // Calls to read() will return as soon as there is
-    // at least one byte available or after 100ms.
+    // FROM 1.2.0
+    // Calls to read() will return immediately with whatever
+    // bytes are available: waiting is handled by `waitForSerialData()`
     cfmakeraw(&serial_settings);
     serial_settings.c_cc[VMIN]  = 0;
-    serial_settings.c_cc[VTIME] = 1;
+    serial_settings.c_cc[VTIME] = 0;
 
 #ifdef BUILD_FOR_LINUX
     cfsetispeed(&serial_settings, speed);
@@ -116,57 +199,61 @@ error:
 
 /**
  * @brief Read bytes from the serial port FIFO.
+ *        FROM 1.2.0 -- bytes are taken from the driver's
+ *        receive buffer, which is refilled as required.
  *
- * @param fd:            The port’s OS file descriptor.
+ * @param sd:            Pointer to an I2CDriver structure.
  * @param buffer:        The buffer into which the read data will be written.
- * @param bytes_to_read: The number of bytes to read, or 0 to scan for `\r\n`.
+ * @param bytes_to_read: The number of bytes to read.
  *
- * @retval The number of bytes read.
+ * @retval The number of bytes read, or -1 on timeout.
+ */
+static size_t readFromSerialPort(I2CDriver *sd, uint8_t* buffer, size_t bytes_to_read) {
+
+    return readResponseFromSerialPort(sd, 0, buffer, bytes_to_read);
+}
+
+
+/**
+ * @brief Read the response to a given frame from the serial port FIFO,
+ *        for when other frames have been sent since: the frame's command
+ *        byte labels the response in any trace.
+ *        FROM 1.2.0
+ *
+ * @param sd:            Pointer to an I2CDriver structure.
+ * @param command:       The command or prefix byte of the frame that
+ *                       prompted the response, or 0 for the last frame sent.
+ * @param buffer:        The buffer into which the read data will be written.
+ * @param bytes_to_read: The number of bytes to read.
+ *
+ * @retval The number of bytes read, or -1 on timeout.
  */
-static size_t readFromSerialPort(int fd, uint8_t* buffer, size_t bytes_to_read) {
+static size_t readResponseFromSerialPort(I2CDriver *sd, uint8_t command, uint8_t* buffer, size_t bytes_to_read) {
+
+    // FROM 1.2.0 -- Make sure the bus host has what it's responding to
+    if (sd->tx_iov_count > 0) flush_frames(sd);
 
     size_t rx_byte_count = 0;
-    ssize_t number_read = -1;
-    struct timespec now, then;
-    clock_gettime(CLOCK_MONOTONIC_RAW, &then);
-
-    if (bytes_to_read == 0) {
-        // Unknown number of bytes -- look for \r\n as EOL
-        while(1) {
-            number_read = read(fd, buffer + rx_byte_count, 1);
-            if (number_read == -1) break;
-            rx_byte_count += number_read;
-            if (rx_byte_count > 2 && buffer[rx_byte_count - 2] == 0x0D && buffer[rx_byte_count - 1] == 0x0A) {
-                // Backstep to clear the \r\n from the string
-                buffer[rx_byte_count - 2] = '\0';
-                buffer[rx_byte_count - 1] = '\0';
-                rx_byte_count -= 2;
-                break;
-            }
-            
-            clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-            if (now.tv_sec - then.tv_sec > READ_BUS_HOST_TIMEOUT_S) {
-                print_error("Read timeout: %i bytes read of %i", rx_byte_count, bytes_to_read);
-                return -1;
-            }
-        }
-    } else {
-        // Read a fixed number of bytes
-        while (rx_byte_count < bytes_to_read) {
-            // Read in the data a byte at a time
-            number_read = read(fd, buffer + rx_byte_count, 1);
-            if (number_read != -1) {
-                rx_byte_count += number_read;
-            }
+    uint64_t deadline_us = time_now_us() + READ_BUS_HOST_TIMEOUT_US;
 
-            clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-            if (now.tv_sec - then.tv_sec > READ_BUS_HOST_TIMEOUT_S) {
-                print_error("Read timeout: %i bytes read of %i", rx_byte_count, bytes_to_read);
-                return -1;
-            }
+    while (rx_byte_count < bytes_to_read) {
+        if (sd->rx_count == 0 && !fillSerialBuffer(sd, deadline_us)) {
+            print_error("Read timeout: %i bytes read of %i", rx_byte_count, bytes_to_read);
+            if (sd->trace != NULL) i2c_trace_rx(sd->trace, command, rx_byte_count, I2C_TRACE_STATUS_TIMEOUT);
+            return -1;
         }
+
+        // Take as many buffered bytes as we need
+        size_t count = bytes_to_read - rx_byte_count;
+        if (count > sd->rx_count) count = sd->rx_count;
+        memcpy(buffer + rx_byte_count, sd->rx_buffer + sd->rx_start, count);
+        sd->rx_start += count;
+        sd->rx_count -= count;
+        rx_byte_count += count;
     }
 
+    if (sd->trace != NULL) i2c_trace_rx(sd->trace, command, rx_byte_count, I2C_TRACE_STATUS_NONE);
+
 #ifdef DEBUG
     // Output the read data for debugging
     fprintf(stderr, "  READ %d of %d: ", (int)rx_byte_count, (int)bytes_to_read);
@@ -180,19 +267,176 @@ static size_t readFromSerialPort(int fd, uint8_t* buffer, size_t bytes_to_read)
 }
 
 
+/**
+ * @brief Read a `\r\n`-terminated line from the serial port FIFO.
+ *        The terminator is not included in the returned data,
+ *        which is NUL-terminated.
+ *        FROM 1.2.0
+ *
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param buffer:      The buffer into which the read data will be written.
+ * @param buffer_size: The size of the buffer in bytes.
+ *
+ * @retval The number of bytes read, or -1 on timeout or overflow.
+ */
+static size_t readLineFromSerialPort(I2CDriver *sd, uint8_t* buffer, size_t buffer_size) {
+
+    if (sd->tx_iov_count > 0) flush_frames(sd);
+
+    size_t rx_byte_count = 0;
+    uint64_t deadline_us = time_now_us() + READ_BUS_HOST_TIMEOUT_US;
+
+    while (1) {
+        if (sd->rx_count == 0 && !fillSerialBuffer(sd, deadline_us)) {
+            print_error("Read timeout: %i bytes read", rx_byte_count);
+            if (sd->trace != NULL) i2c_trace_rx(sd->trace, 0, rx_byte_count, I2C_TRACE_STATUS_TIMEOUT);
+            return -1;
+        }
+
+        // Copy up to and including the next LF, if there is one
+        uint8_t* unread = sd->rx_buffer + sd->rx_start;
+        uint8_t* lf = memchr(unread, 0x0A, sd->rx_count);
+        size_t count = (lf == NULL) ? sd->rx_count : (size_t)(lf - unread) + 1;
+        if (rx_byte_count + count >= buffer_size) {
+            print_error("Read overflow: %i bytes read", rx_byte_count + count);
+            return -1;
+        }
+
+        memcpy(buffer + rx_byte_count, unread, count);
+        sd->rx_start += count;
+        sd->rx_count -= count;
+        rx_byte_count += count;
+
+        // Only a CR-LF pair marks the end of the line
+        if (lf != NULL && rx_byte_count > 1 && buffer[rx_byte_count - 2] == 0x0D) {
+            // Backstep to clear the \r\n from the string
+            rx_byte_count -= 2;
+            break;
+        }
+    }
+
+    buffer[rx_byte_count] = '\0';
+    if (sd->trace != NULL) i2c_trace_rx(sd->trace, 0, rx_byte_count, I2C_TRACE_STATUS_NONE);
+
+#ifdef DEBUG
+    // Output the read data for debugging
+    fprintf(stderr, "  READ LINE %d: ", (int)rx_byte_count);
+    for (size_t i = 0 ; i < rx_byte_count ; ++i) {
+        fprintf(stderr, "%02X ", 0xFF & buffer[i]);
+    }
+    fprintf(stderr, "\n");
+#endif
+
+    return rx_byte_count;
+}
+
+
+/**
+ * @brief Top up the driver's receive buffer with whatever
+ *        bytes the OS has received from the port, waiting
+ *        for some to arrive if necessary.
+ *        FROM 1.2.0
+ *
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param deadline_us: The monotonic time by which data must arrive.
+ *
+ * @retval Whether any bytes were added (`true`) or not (`false`).
+ */
+static bool fillSerialBuffer(I2CDriver *sd, uint64_t deadline_us) {
+
+    // Move unconsumed bytes to the front of the buffer
+    if (sd->rx_count == 0) {
+        sd->rx_start = 0;
+    } else if (sd->rx_start > 0) {
+        memmove(sd->rx_buffer, sd->rx_buffer + sd->rx_start, sd->rx_count);
+        sd->rx_start = 0;
+    }
+
+    size_t space = SERIAL_RX_BUFFER_MAX_B - sd->rx_count;
+    if (space == 0) return false;
+
+    while (1) {
+        if (!waitForSerialData(sd->port, deadline_us)) return false;
+        ssize_t number_read = read(sd->port, sd->rx_buffer + sd->rx_count, space);
+        if (number_read > 0) {
+            sd->rx_count += number_read;
+            return true;
+        }
+
+        if (number_read == -1 && errno != EAGAIN && errno != EINTR) return false;
+    }
+}
+
+
+/**
+ * @brief Block until the port has data to read or the deadline passes.
+ *        FROM 1.2.0
+ *
+ * @param fd:          The port’s OS file descriptor.
+ * @param deadline_us: The monotonic time by which data must arrive.
+ *
+ * @retval Whether data is available (`true`) or not (`false`).
+ */
+static bool waitForSerialData(int fd, uint64_t deadline_us) {
+
+    while (1) {
+        uint64_t now_us = time_now_us();
+        if (now_us >= deadline_us) return false;
+        uint64_t wait_us = deadline_us - now_us;
+        int result;
+
+#ifdef BUILD_FOR_LINUX
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        struct timespec timeout = {.tv_sec = wait_us / 1000000, .tv_nsec = (wait_us % 1000000) * 1000};
+        result = ppoll(&pfd, 1, &timeout, NULL);
+        if (result > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) return false;
+#else
+        // NOTE macOS' poll() does not support tty devices
+        fd_set read_set;
+        FD_ZERO(&read_set);
+        FD_SET(fd, &read_set);
+        struct timeval timeout = {.tv_sec = wait_us / 1000000, .tv_usec = wait_us % 1000000};
+        result = select(fd + 1, &read_set, NULL, NULL, &timeout);
+#endif
+
+        if (result > 0) return true;
+        if (result == -1 && errno != EINTR) return false;
+    }
+}
+
+
+/**
+ * @brief Get the current monotonic time.
+ *        FROM 1.2.0
+ *
+ * @retval The time in microseconds.
+ */
+static inline uint64_t time_now_us(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+
 /**
  * @brief Write bytes to the serial port FIFO.
+ *        FROM 1.2.0 -- Take a driver record, for tracing.
  *
- * @param fd:         The port’s OS file descriptor.
+ * @param sd:         Pointer to an I2CDriver structure.
  * @param buffer:     The buffer into which the read data will be written.
  * @param byte_count: The number of bytes to write`.
  *
  * @retval The number of bytes read.
  */
-static bool writeToSerialPort(int fd, const uint8_t* buffer, size_t byte_count) {
+static bool writeToSerialPort(I2CDriver *sd, const uint8_t* buffer, size_t byte_count) {
 
     // Write the bytes
-    ssize_t written = write(fd, buffer, byte_count);
+    if (sd->trace != NULL) i2c_trace_tx(sd->trace, buffer[0], byte_count);
+    if (sd->stats != NULL) i2c_stats_queued(sd->stats, buffer[0]);
+    ssize_t written = write(sd->port, buffer, byte_count);
+    if (sd->trace != NULL) i2c_trace_sent(sd->trace);
+    if (sd->stats != NULL) i2c_stats_sent(sd->stats);
 
 #ifdef DEBUG
     // Output the read data for debugging
@@ -215,29 +459,81 @@ static bool writeToSerialPort(int fd, const uint8_t* buffer, size_t byte_count)
 }
 
 
+/**
+ * @brief Write several buffers to the serial port FIFO with a single
+ *        system call, resuming if the write is cut short.
+ *        FROM 1.2.0
+ *
+ * @param fd:        The port’s OS file descriptor.
+ * @param iov:       The buffers. Entries are modified by partial writes.
+ * @param iov_count: The number of buffers.
+ *
+ * @retval Whether all the bytes were written (`true`) or not (`false`).
+ */
+static bool writeVectorToSerialPort(int fd, struct iovec* iov, int iov_count) {
+
+    int index = 0;
+    while (index < iov_count) {
+        ssize_t written = writev(fd, &iov[index], iov_count - index);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+#ifdef DEBUG
+            print_log("writev() returned an error: %s (%i)", strerror(errno), errno);
+#endif
+            return false;
+        }
+
+        // Skip the buffers that were written, and trim a partly written one
+        while (index < iov_count && (size_t)written >= iov[index].iov_len) {
+            written -= iov[index].iov_len;
+            index++;
+        }
+
+        if (index < iov_count) {
+            iov[index].iov_base = (uint8_t*)iov[index].iov_base + written;
+            iov[index].iov_len -= written;
+        }
+    }
+
+    return true;
+}
+
+
 /**
  * @brief Flush the port FIFOs and close the port.
+ *        FROM 1.2.0 -- Take a driver record, not a file descriptor,
+ *        so the port's own settings can be restored.
+ *
+ * @param sd: Pointer to an I2CDriver structure.
  */
-void flush_and_close_port(int fd) {
+void flush_and_close_port(I2CDriver *sd) {
 
-    if (fd != -1) {
+    if (sd->port != -1) {
         // Drain the FIFOs -- alternative to `tcflush(fd, TCIOFLUSH)`;
-        if (tcdrain(fd) == -1) {
+        if (tcdrain(sd->port) == -1) {
             print_error("Could not flush the port. %s (%d).\n", strerror(errno), errno);
         }
         
         // Set the port back to how we found it
-        if (tcsetattr(fd, TCSANOW, &original_settings) == -1) {
+        if (tcsetattr(sd->port, TCSANOW, &sd->original_settings) == -1) {
             print_error("Could not reset port - %s (%d)", strerror(errno), errno);
         }
         
         // Close the port
-        close(fd);
+        close(sd->port);
+        sd->port = -1;
+        sd->connected = false;
         
 #ifdef DEBUG
         print_log("Port closed");
 #endif
     }
+
+    // FROM 1.2.0
+    if (sd->trace != NULL) {
+        i2c_trace_close(sd->trace);
+        sd->trace = NULL;
+    }
 }
 
 
@@ -246,22 +542,51 @@ void flush_and_close_port(int fd) {
 
 /**
  * @brief Connect to the target I2C host.
- *        Always check the I2CDriver record that
- *        the `connected` field is `true`.
+ *        FROM 1.2.0 -- Called by `i2c_open()`, which
+ *        returns NULL if the connection wasn't made.
  *
  * @param sd:          Pointer to an I2CDriver structure.
  * @param device_path: The device path as a string.
+ *
+ * @retval Whether the connection was made (`true`) or not (`false`).
  */
-void i2c_connect(I2CDriver *sd, const char* device_path) {
+static bool i2c_connect(I2CDriver *sd, const char* device_path) {
 
     // Mark that we're not connected
     sd->connected = false;
+    sd->rx_start = 0;
+    sd->rx_count = 0;
+    sd->capabilities = 0;
+    sd->is_pipelined = false;
+    sd->acks_pending = 0;
+    sd->failed_op = 0;
+    sd->tx_window = 0;
+    sd->tx_in_flight = 0;
+    sd->tx_iov_count = 0;
+    sd->tx_headers_count = 0;
+    sd->bus = 0;
+    sd->sda_pin = -1;
+    sd->scl_pin = -1;
 
     // Open and get the serial port or bail
-    sd->port = openSerialPort(device_path);
+    sd->port = openSerialPort(sd, device_path);
     if (sd->port == -1) {
         print_error("Could not open port to device %s", device_path);
-        return;
+        return false;
+    }
+
+    // FROM 1.2.0
+    // Trace the connection if asked to by the environment,
+    // unless the caller has already set up a trace. Each handle
+    // gets its own file, named for the process and the handle,
+    // so handles and processes don't overwrite each other's traces
+    const char* trace_path = getenv(I2C_TRACE_ENV_VAR);
+    if (sd->trace == NULL && trace_path != NULL && trace_path[0] != '\0') {
+        static uint32_t trace_count = 0;
+        char handle_trace_path[PATH_MAX];
+        uint32_t index = __atomic_fetch_add(&trace_count, 1, __ATOMIC_RELAXED);
+        snprintf(handle_trace_path, sizeof(handle_trace_path), "%s.%d.%u", trace_path, (int)getpid(), index);
+        sd->trace = i2c_trace_open(handle_trace_path, 0);
     }
     
 #ifdef DEBUG
@@ -271,476 +596,1627 @@ void i2c_connect(I2CDriver *sd, const char* device_path) {
     // Perform a basic communications check
     send_command(sd, '!');
     uint8_t rx[4] = {0};
-    size_t result = readFromSerialPort(sd->port, rx, 4);
+    size_t result = readFromSerialPort(sd, rx, 4);
     if (result == -1 || ((rx[0] != 'O') && (rx[1] != 'K'))) {
         print_error("No response from device %s", device_path);
-        return;
+        return false;
     }
 
+    // FROM 1.2.0
+    // Find out what the bus host can do
+    board_get_capabilities(sd);
+
     // Got this far? We're good to go
     sd->connected = true;
+    return true;
 }
 
 
 /**
- * @brief Check for an ACK byte.
- *        Note that we use this for a write count on
- *        write operations.
+ * @brief Allocate a driver record and connect it to a bus host.
+ *        This is the entry point for code using the driver as a
+ *        library: each handle has its own port and port settings.
+ *        FROM 1.2.0
  *
- * @param sd: Pointer to an I2CDriver structure.
+ * @param device_path: The device path as a string.
  *
- * @retval The op was ACK'd (1) or not (0).
+ * @retval A handle for the connection, or NULL on error.
  */
-static bool i2c_ack(I2CDriver *sd) {
+I2CDriver* i2c_open(const char* device_path) {
 
-    uint8_t read_buffer[1] = {0};
-    if (readFromSerialPort(sd->port, read_buffer, 1) != 1) return false;
-    bool ackd = ((read_buffer[0] & ACK) == ACK);
-    
-#ifdef DEBUG
-    print_log((ackd ? "ACK" : "ERR"));
-#endif
-    
-    return ackd;
+    return i2c_open_traced(device_path, NULL);
 }
 
 
 /**
- * @brief Get status info from the USB host.
+ * @brief Allocate a driver record, and connect it to a bus host with
+ *        its traffic traced to the specified file. Unlike a trace
+ *        requested by the environment, the file is used as named.
+ *        FROM 1.2.0
  *
- * @param sd:       Pointer to an I2CDriver structure.
- * @param do_print: Should we output the results to stderr?
+ * @param device_path: The device path as a string.
+ * @param trace_path:  The trace file's path, or NULL for no trace.
+ *
+ * @retval A handle for the connection, or NULL on error.
  */
-static void i2c_get_info(I2CDriver *sd, bool do_print) {
-
-    uint8_t read_buffer[HOST_INFO_BUFFER_MAX_B] = {0};
-    send_command(sd, '?');
-    size_t result = readFromSerialPort(sd->port, read_buffer, 0);
-    if (result == -1) {
-        print_error("Could not read I2C information from device");
-        return;
-    }
+I2CDriver* i2c_open_traced(const char* device_path, const char* trace_path) {
 
-#ifdef DEBUG
-    print_log("Received raw info string: %s", read_buffer);
-#endif
+    I2CDriver* sd = calloc(1, sizeof(I2CDriver));
+    if (sd == NULL) return NULL;
 
-    // Data string is, for example,
-    // "1.1.100.110.1.1.0.200.A1B23C4D5E6F0A1B.QTPY-RP2040"
-    int is_ready = 0;
-    int has_started = 0;
-    int frequency = 100;
-    int address = 0xFF;
-    int major = 0;
-    int minor = 0;
-    int patch = 0;
-    int build = 0;
-    int bus = 0;
-    int sda_pin = -1;
-    int scl_pin = -1;
-    char string_data[67] = {0};
-    char model[25] = {0};
-    char pid[17] = {0};
+    sd->port = -1;
+    if (trace_path != NULL) {
+        sd->trace = i2c_trace_open(trace_path, 0);
+        if (sd->trace == NULL) {
+            free(sd);
+            return NULL;
+        }
+    }
 
-    // Extract the data
-    sscanf((char*)read_buffer, "%i.%i.%i.%i.%i.%i.%i.%i.%i.%i.%i.%s",
-        &is_ready,
-        &has_started,
-        &bus,
-        &sda_pin,
-        &scl_pin,
-        &frequency,
-        &address,
-        &major,
-        &minor,
-        &patch,
-        &build,
-        string_data
-    );
+    if (!i2c_connect(sd, device_path)) {
+        i2c_close(sd);
+        return NULL;
+    }
 
-    // Store certain values in the I2C driver record
-    // NOTE This involves separately extracting the substrings
-    //      from the read `string_data` as sscanf() doesn't
-    //      separate them properly
-    strncpy(pid, string_data, 16);
-    strcpy(model, &string_data[17]);
-    sd->speed = frequency;
+    return sd;
+}
 
-    if (do_print) {
-        print_log("   I2C host device: %s", model);
-        print_log( "  I2C host version: %i.%i.%i (%i)", major, minor, patch, build);
-        print_log("       I2C host ID: %s", pid);
-        print_log("     Using I2C bus: %s", bus == 0 ? "i2c0" : "i2c1");
-        print_log(" I2C bus frequency: %ikHz", frequency);
-        print_log(" Pins used for I2C: GP%i (SDA), GP%i (SCL)", sda_pin, scl_pin);
-        print_log("    I2C is enabled: %s", is_ready == 1 ? "YES" : "NO");
-        print_log("     I2C is active: %s", has_started == 1 ? "YES" : "NO");
 
-        // Check for a 'no device' I2C address
-        if (address == 0xFF) {
-            print_log("Target I2C address: NONE");
-        } else {
-            print_log("Target I2C address: 0x%02X", address);
-        }
+/**
+ * @brief Close a connection made with `i2c_open()` and free its handle.
+ *        FROM 1.2.0
+ *
+ * @param sd: The handle.
+ */
+void i2c_close(I2CDriver *sd) {
 
-    }
+    if (sd == NULL) return;
+    flush_and_close_port(sd);
+    i2c_stats_destroy(sd->stats);
+    free(sd);
 }
 
 
 /**
- * @brief Scan the I2C bus and list devices.
+ * @brief Get a connection's file descriptor, eg. to watch it with
+ *        `epoll()` or `poll()`. Don't close it: call `i2c_close()`.
+ *        FROM 1.2.0
  *
  * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval The file descriptor, or -1 if the port isn't open.
  */
-void i2c_scan(I2CDriver *sd) {
+int i2c_get_fd(I2CDriver *sd) {
 
-    char scan_buffer[SCAN_BUFFER_MAX_B] = {0};
-    uint8_t device_list[CONNECTED_DEVICES_MAX_B] = {0};
-    uint32_t device_count = 0;
+    return sd->port;
+}
 
-    // Request scan from bus host
-    send_command(sd, 'd');
-    size_t result = readFromSerialPort(sd->port, (uint8_t*)scan_buffer, 0);
-    if (result == -1) {
-        print_error("Could not read scan data from device");
-        return;
-    }
 
-    // If we receive Z(ero), there are no connected devices
-    if (scan_buffer[0] != 'Z') {
-        // Extract device address hex strings and generate
-        // integer values. For example:
-        // source = "12.71.A0."
-        // dest   = [18, 113, 160]
+/**
+ * @brief Get the bus host's details and I2C bus settings,
+ *        as of the last call to `i2c_get_info()`.
+ *        FROM 1.2.0
+ *
+ * @param sd:   Pointer to an I2CDriver structure.
+ * @param info: The record to fill.
+ */
+void i2c_get_host_info(I2CDriver *sd, I2CHostInfo* info) {
+
+    strcpy(info->model, sd->host_model);
+    strcpy(info->version, sd->host_version);
+    info->bus = sd->bus;
+    info->sda_pin = sd->sda_pin;
+    info->scl_pin = sd->scl_pin;
+    info->speed = sd->speed;
+    info->capabilities = sd->capabilities;
+}
 
-#ifdef DEBUG
-        print_log("Buffer: %lu bytes, %lu items", strlen(scan_buffer), strlen(scan_buffer) / 3);
-#endif
 
-        for (uint32_t i = 0 ; i < strlen(scan_buffer) ; i += 3) {
+/**
+ * @brief Get the bus host's feature flags, eg. `CAPABILITY_PIPELINE`.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval The flags.
+ */
+uint8_t i2c_get_capabilities(I2CDriver *sd) {
 
-            uint8_t value[2] = {0};
-            uint32_t count = 0;
-            
-            // Get two hex chars and store in 'value'; break on a .
-            while(1) {
-                uint8_t token = scan_buffer[i + count];
-                if (token == 0x2E) break;
-                value[count] = token;
-                count++;
-            }
+    return sd->capabilities;
+}
 
-            device_list[device_count] = (uint8_t)strtol((char *)value, NULL, 16);
-            device_count++;
-        }
-    }
 
-    // Output the device list as a table (even with no devices)
+/**
+ * @brief Get the command byte of the op that caused the last
+ *        transaction or pipeline to fail.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval The command byte, or 0 if the bus host reported no error.
+ */
+uint8_t i2c_get_failed_op(I2CDriver *sd) {
 
-    fprintf(stderr, "   0 1 2 3 4 5 6 7 8 9 A B C D E F");
+    return sd->failed_op;
+}
+
+
+/**
+ * @brief Pause between commands, for bus hosts running older firmware.
+ *        FROM 1.2.0
+ *
+ * @param sd:         Pointer to an I2CDriver structure.
+ * @param min_gap_us: The pause in microseconds, or 0 for none.
+ */
+void i2c_set_min_gap(I2CDriver *sd, uint32_t min_gap_us) {
+
+    sd->min_gap_us = min_gap_us;
+}
+
+
+/**
+ * @brief Choose whether commands read and write raw bytes, or hex.
+ *        FROM 1.2.0
+ *
+ * @param sd:        Pointer to an I2CDriver structure.
+ * @param binary_io: Set to `true` for raw bytes.
+ */
+void i2c_set_binary_io(I2CDriver *sd, bool binary_io) {
+
+    sd->binary_io = binary_io;
+}
+
+
+/**
+ * @brief Start gathering response latencies, if we're not already.
+ *        The statistics are freed by `i2c_close()`.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval The statistics, or NULL on error.
+ */
+I2CStats* i2c_enable_stats(I2CDriver *sd) {
+
+    if (sd->stats == NULL) sd->stats = i2c_stats_create();
+    return sd->stats;
+}
+
+
+/**
+ * @brief Get the response latencies gathered so far.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval The statistics, or NULL if they're not being gathered.
+ */
+I2CStats* i2c_get_stats(I2CDriver *sd) {
+
+    return sd->stats;
+}
+
+
+/**
+ * @brief Check for an ACK byte.
+ *        Note that we use this for a write count on
+ *        write operations.
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval The op was ACK'd (1) or not (0).
+ */
+static bool i2c_ack(I2CDriver *sd) {
+
+    // FROM 1.2.0
+    // Collect any outstanding pipelined ACKs first
+    if (sd->acks_pending > 0) i2c_pipeline_drain(sd);
+
+    uint8_t read_buffer[1] = {0};
+    if (readFromSerialPort(sd, read_buffer, 1) != 1) return false;
+    record_latency(sd, 0);
+    bool ackd = ((read_buffer[0] & ACK) == ACK);
+    trace_status(sd, ackd);
+    
+#ifdef DEBUG
+    print_log((ackd ? "ACK" : "ERR"));
+#endif
+    
+    return ackd;
+}
+
+
+/**
+ * @brief Collect the ACK for an op, or, if we are pipelining,
+ *        record that an ACK is due and return straight away.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ * @param op: The op's command or prefix byte.
+ *
+ * @retval Whether the op was ACK'd (`true`) or not (`false`).
+ *         Pipelined ops are always `true`: check the result of
+ *         `i2c_pipeline_end()`.
+ */
+static bool i2c_expect_ack(I2CDriver *sd, uint8_t op) {
+
+    if (!sd->is_pipelined) {
+        bool ackd = i2c_ack(sd);
+        if (!ackd && sd->failed_op == 0) sd->failed_op = op;
+        return ackd;
+    }
+
+    // Collect ACKs if the window is full
+    if (sd->acks_pending == I2C_PIPELINE_OPS_MAX) i2c_pipeline_drain(sd);
+    sd->pending_ops[sd->acks_pending++] = op;
+    return true;
+}
+
+
+/**
+ * @brief Read the ACKs for all pipelined ops in a single pass,
+ *        noting the first op, if any, that was not ACK'd.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval Whether all the ops were ACK'd (`true`) or not (`false`).
+ */
+static bool i2c_pipeline_drain(I2CDriver *sd) {
+
+    uint32_t count = sd->acks_pending;
+    if (count == 0) return true;
+    sd->acks_pending = 0;
+    sd->tx_in_flight = 0;
+
+    // Read the ACKs one by one, so each is traced against its own op
+    bool all_ackd = true;
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        uint8_t ack = 0;
+        if (readResponseFromSerialPort(sd, sd->pending_ops[i], &ack, 1) != 1) {
+            if (sd->failed_op == 0) sd->failed_op = sd->pending_ops[i];
+            return false;
+        }
+
+        bool ackd = ((ack & ACK) == ACK);
+        record_latency(sd, sd->pending_ops[i]);
+        trace_status(sd, ackd);
+
+#ifdef DEBUG
+        print_log("%s: %s", get_op_name(sd->pending_ops[i]), (ackd ? "ACK" : "ERR"));
+#endif
+
+        if (!ackd) {
+            if (sd->failed_op == 0) sd->failed_op = sd->pending_ops[i];
+            all_ackd = false;
+        }
+    }
+
+    return all_ackd;
+}
+
+
+/**
+ * @brief Start pipelining: ops that return an ACK will be sent
+ *        back to back, and their ACKs collected in one pass by
+ *        `i2c_pipeline_end()`. Has no effect if the bus host
+ *        firmware can't handle pipelined ops.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval Whether pipelining is in effect (`true`) or not (`false`).
+ */
+bool i2c_pipeline_begin(I2CDriver *sd) {
+
+    sd->failed_op = 0;
+    sd->is_pipelined = ((sd->capabilities & CAPABILITY_PIPELINE) != 0);
+    return sd->is_pipelined;
+}
+
+
+/**
+ * @brief Stop pipelining and collect any outstanding ACKs.
+ *        If an op was not ACK'd, its command byte is recorded
+ *        in the I2CDriver structure's `failed_op` field.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval Whether all the ops were ACK'd (`true`) or not (`false`).
+ */
+bool i2c_pipeline_end(I2CDriver *sd) {
+
+    i2c_pipeline_drain(sd);
+    sd->is_pipelined = false;
+    return (sd->failed_op == 0);
+}
+
+
+/**
+ * @brief Get status info from the USB host.
+ *
+ * @param sd:       Pointer to an I2CDriver structure.
+ * @param do_print: Should we output the results to stderr?
+ *
+ * @retval Whether the info was read (`true`) or not (`false`).
+ */
+bool i2c_get_info(I2CDriver *sd, bool do_print) {
+
+    uint8_t read_buffer[HOST_INFO_BUFFER_MAX_B] = {0};
+    send_command(sd, '?');
+    size_t result = readLineFromSerialPort(sd, read_buffer, sizeof(read_buffer));
+    if (result == -1) {
+        print_error("Could not read I2C information from device");
+        return false;
+    }
+
+    record_latency(sd, '?');
+
+#ifdef DEBUG
+    print_log("Received raw info string: %s", read_buffer);
+#endif
+
+    // Data string is, for example,
+    // "1.1.100.110.1.1.0.200.A1B23C4D5E6F0A1B.QTPY-RP2040"
+    int is_ready = 0;
+    int has_started = 0;
+    int frequency = 100;
+    int address = 0xFF;
+    int major = 0;
+    int minor = 0;
+    int patch = 0;
+    int build = 0;
+    int bus = 0;
+    int sda_pin = -1;
+    int scl_pin = -1;
+    char string_data[67] = {0};
+    char model[25] = {0};
+    char pid[17] = {0};
+
+    // Extract the data
+    sscanf((char*)read_buffer, "%i.%i.%i.%i.%i.%i.%i.%i.%i.%i.%i.%s",
+        &is_ready,
+        &has_started,
+        &bus,
+        &sda_pin,
+        &scl_pin,
+        &frequency,
+        &address,
+        &major,
+        &minor,
+        &patch,
+        &build,
+        string_data
+    );
+
+    // Store certain values in the I2C driver record
+    // NOTE This involves separately extracting the substrings
+    //      from the read `string_data` as sscanf() doesn't
+    //      separate them properly
+    strncpy(pid, string_data, 16);
+    strcpy(model, &string_data[17]);
+    sd->speed = frequency;
+    // FROM 1.2.0
+    sd->bus = (uint8_t)bus;
+    sd->sda_pin = sda_pin;
+    sd->scl_pin = scl_pin;
+    strncpy(sd->host_model, model, sizeof(sd->host_model) - 1);
+    snprintf(sd->host_version, sizeof(sd->host_version), "%i.%i.%i (%i)", major, minor, patch, build);
+
+    if (do_print) {
+        print_log("   I2C host device: %s", model);
+        print_log( "  I2C host version: %i.%i.%i (%i)", major, minor, patch, build);
+        print_log("       I2C host ID: %s", pid);
+        print_log("     Using I2C bus: %s", bus == 0 ? "i2c0" : "i2c1");
+        print_log(" I2C bus frequency: %ikHz", frequency);
+        print_log(" Pins used for I2C: GP%i (SDA), GP%i (SCL)", sda_pin, scl_pin);
+        print_log("    I2C is enabled: %s", is_ready == 1 ? "YES" : "NO");
+        print_log("     I2C is active: %s", has_started == 1 ? "YES" : "NO");
+
+        // Check for a 'no device' I2C address
+        if (address == 0xFF) {
+            print_log("Target I2C address: NONE");
+        } else {
+            print_log("Target I2C address: 0x%02X", address);
+        }
+
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Scan the I2C bus for devices.
+ *        FROM 1.2.0 -- Return the addresses, rather than print them.
+ *
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param devices:     A buffer for the addresses of the devices found.
+ * @param max_devices: The size of the buffer.
+ *
+ * @retval The number of devices found, or -1 on error.
+ */
+int i2c_scan(I2CDriver *sd, uint8_t devices[], size_t max_devices) {
+
+    return i2c_scan_range(sd, 0x00, SCAN_ADDRESS_MAX, 0, devices, max_devices);
+}
+
+
+/**
+ * @brief Scan a range of I2C addresses for devices. If the bus host
+ *        supports it, only the range is probed, and the result is
+ *        returned as a bitmap; otherwise the whole bus is scanned
+ *        and the result is filtered.
+ *        FROM 1.2.0
+ *
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param first:       The first address to probe.
+ * @param last:        The last address to probe.
+ * @param timeout_us:  The time to allow each probe, or 0 for the bus host's default.
+ * @param devices:     A buffer for the addresses of the devices found.
+ * @param max_devices: The size of the buffer.
+ *
+ * @retval The number of devices found, or -1 on error.
+ */
+int i2c_scan_range(I2CDriver *sd, uint8_t first, uint8_t last, uint32_t timeout_us, uint8_t devices[], size_t max_devices) {
+
+    if (first > last || last > SCAN_ADDRESS_MAX) {
+        print_error("I2C scan range out of range (0x00-0x%02X)", SCAN_ADDRESS_MAX);
+        return -1;
+    }
+
+    // The response must not be mistaken for ACKs still to come
+    if (sd->acks_pending > 0) i2c_pipeline_drain(sd);
+    if ((sd->capabilities & CAPABILITY_SCAN_BITMAP) == 0) return scan_list(sd, first, last, devices, max_devices);
+
+    // Request the scan: the bus host responds with ACK
+    // and the bitmap, or ERR
+    if (timeout_us > 0xFFFF) timeout_us = 0xFFFF;
+    uint8_t scan_cmd[5] = {'D', first, last, (uint8_t)(timeout_us & 0xFF), (uint8_t)(timeout_us >> 8)};
+    uint8_t ack = 0;
+    writeToSerialPort(sd, scan_cmd, sizeof(scan_cmd));
+    if (readFromSerialPort(sd, &ack, 1) != 1) {
+        print_error("Could not read scan data from device");
+        return -1;
+    }
+
+    record_latency(sd, 'D');
+    trace_status(sd, ack == ACK);
+    if (ack != ACK) {
+        print_error("I2C host could not scan the bus");
+        return -1;
+    }
+
+    uint8_t reply[SCAN_BITMAP_LENGTH_B];
+    if (readFromSerialPort(sd, reply, sizeof(reply)) != sizeof(reply)) {
+        print_error("Could not read scan data from device");
+        return -1;
+    }
+
+    // Bit (address & 7) of byte (address >> 3) is set for each
+    // device found: visit only the set bits
+    int device_count = 0;
+    for (uint32_t i = 0 ; i < SCAN_BITMAP_LENGTH_B && device_count < max_devices ; ++i) {
+        uint32_t bits = reply[i];
+        while (bits != 0 && device_count < max_devices) {
+            devices[device_count++] = (uint8_t)((i << 3) + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+
+    return device_count;
+}
+
+
+/**
+ * @brief Scan the I2C bus with the `d` command, for bus hosts
+ *        that don't support bitmap scans, and extract the
+ *        addresses in a range from the device list.
+ *        FROM 1.2.0 -- Split out from `i2c_scan()`.
+ *
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param first:       The lowest address to return.
+ * @param last:        The highest address to return.
+ * @param devices:     A buffer for the addresses of the devices found.
+ * @param max_devices: The size of the buffer.
+ *
+ * @retval The number of devices found, or -1 on error.
+ */
+static int scan_list(I2CDriver *sd, uint8_t first, uint8_t last, uint8_t devices[], size_t max_devices) {
+
+    char scan_buffer[SCAN_BUFFER_MAX_B] = {0};
+    int device_count = 0;
+
+    // Request scan from bus host
+    send_command(sd, 'd');
+    size_t result = readLineFromSerialPort(sd, (uint8_t*)scan_buffer, sizeof(scan_buffer));
+    if (result == -1) {
+        print_error("Could not read scan data from device");
+        return -1;
+    }
+
+    record_latency(sd, 'd');
+
+    // If we receive Z(ero), there are no connected devices
+    if (scan_buffer[0] != 'Z') {
+        // Extract device address hex strings and generate
+        // integer values. For example:
+        // source = "12.71.A0."
+        // dest   = [18, 113, 160]
+        size_t length = strlen(scan_buffer);
+
+#ifdef DEBUG
+        print_log("Buffer: %lu bytes, %lu items", length, length / 3);
+#endif
+
+        for (size_t i = 0 ; i + 2 < length && device_count < max_devices ; i += 3) {
+            int high = get_hex_value(scan_buffer[i]);
+            int low = get_hex_value(scan_buffer[i + 1]);
+            if (high == -1 || low == -1 || scan_buffer[i + 2] != '.') break;
+
+            uint8_t address = (uint8_t)((high << 4) | low);
+            if (address >= first && address <= last) devices[device_count++] = address;
+        }
+    }
+
+    return device_count;
+}
+
+
+/**
+ * @brief Get the value of a hex digit.
+ *        FROM 1.2.0
+ *
+ * @param digit: The digit's character.
+ *
+ * @retval The value, or -1 if the character isn't a hex digit.
+ */
+static inline int get_hex_value(char digit) {
+
+    if (digit >= '0' && digit <= '9') return digit - '0';
+    if (digit >= 'A' && digit <= 'F') return digit - 'A' + 10;
+    if (digit >= 'a' && digit <= 'f') return digit - 'a' + 10;
+    return -1;
+}
+
+
+/**
+ * @brief Tell the I2C host to Initialise the I2C bus.
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ */
+bool i2c_init(I2CDriver *sd) {
+
+    send_command(sd, 'i');
+    return i2c_ack(sd);
+};
+
+
+/**
+ * @brief Tell the I2C host to de-initialise (Kill) the I2C bus.
+ *        FROM 1.1.3
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ */
+bool i2c_deinit(I2CDriver *sd) {
+
+    send_command(sd, 'k');
+    return i2c_ack(sd);
+};
+
+
+/**
+ * @brief Tell the I2C host to set the bus speed.
+ *
+ * @param sd:    Pointer to an I2CDriver structure.
+ * @param speed: Bus frequency in 100kHz. Only 1 or 4 supported.
+ *
+ * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ */
+static bool i2c_set_speed(I2CDriver *sd, long speed) {
+
+    switch(speed) {
+        case 1:
+            send_command(sd, '1');
+            break;
+        default:
+            send_command(sd, '4');
+    }
+
+    return i2c_ack(sd);
+}
+
+
+/**
+ * @brief Choose the I2C host's target bus: 0 (i2c0) or 1 (i2c1),
+ *        and SDA and SCL pins. Firmware will return `ERR` on a
+ *        mis-setting.
+ *
+ * @param sd:      Pointer to an I2CDriver structure.
+ * @param bus_id:  The Pico SDK I2C bus ID: 0 or 1.
+ * @param sda_pin: The SDA pin GPIO number.
+ * @param scl_pin: The SCL pin GPIO number.
+ *
+ * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ */
+static bool i2c_set_bus(I2CDriver *sd, uint8_t bus_id, uint8_t sda_pin, uint8_t scl_pin) {
+    
+    if (bus_id < 0 || bus_id > 1) return false;
+    uint8_t set_bus_data[4] = {'c', (bus_id & 0x01), sda_pin, scl_pin};
+    writeToSerialPort(sd, set_bus_data, sizeof(set_bus_data));
+    return i2c_ack(sd);
+}
+
+
+/**
+ * @brief Tell the I2C host to reset the I2C bus.
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ *
+ * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ */
+static bool i2c_reset(I2CDriver *sd) {
+
+    send_command(sd, 'x');
+    return i2c_ack(sd);
+}
+
+
+/**
+ * @brief Tell the I2C host to start an I2C transaction.
+ *
+ * @param sd:      Pointer to an I2CDriver structure.
+ * @param address: The target device's I2C address.
+ * @param op:      Read (0) or write (1) I2C operation.
+ *
+ * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ */
+bool i2c_start(I2CDriver *sd, uint8_t address, uint8_t op) {
+
+    // This is a two-byte command: command + (address | op)
+    uint8_t start_data[2] = {'s', ((address << 1) | op)};
+    send_frame(sd, start_data, sizeof(start_data));
+    return i2c_expect_ack(sd, 's');
+}
+
+
+/**
+ * @brief Tell the I2C host to issue a STOP to the I2C bus.
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ */
+bool i2c_stop(I2CDriver *sd) {
+
+    send_command(sd, 'p');
+    return i2c_expect_ack(sd, 'p');
+}
+
+
+/**
+ * @brief Write data to the I2C host for transmission.
+ *
+ * @param sd:         Pointer to an I2CDriver structure.
+ * @param bytes:      The bytes to write.
+ * @param byte_count: The number of bytes to write.
+ *
+ * @retval The number of bytes received.
+ */
+size_t i2c_write(I2CDriver *sd, const uint8_t bytes[], size_t byte_count) {
+
+    // Count the bytes sent
+    int count = 0;
+    bool ack = false;
+
+    // FROM 1.2.0
+    // If the bus host supports it, write large blocks as long frames:
+    // each is a single I2C transaction with a single ACK
+    size_t long_length = get_long_frame_length(sd, byte_count);
+    size_t block_length = (long_length > 0) ? long_length : 64;
+
+    // Write the data out in blocks of 64 bytes (or long frames).
+    // FROM 1.2.0 -- Blocks are sent straight from `bytes`, not copied:
+    //               only the prefix is queued separately
+    for (size_t i = 0 ; i < byte_count ; i += block_length) {
+        // Calculate the data length for the prefix byte
+        size_t length = ((byte_count - i) < block_length) ? (byte_count - i) : block_length;
+        uint8_t write_cmd[3] = {'w', (uint8_t)(length & 0xFF), (uint8_t)((length >> 8) & 0xFF)};
+        size_t header_length = 3;
+        if (long_length == 0) {
+            write_cmd[0] = (uint8_t)(PREFIX_BYTE_WRITE + length - 1);
+            header_length = 1;
+        }
+
+        // Write out the block -- use ACK as byte count
+        if (!queue_frame(sd, write_cmd, header_length, bytes + i, length)) break;
+        ack = i2c_expect_ack(sd, write_cmd[0]);
+        if (!ack) break;
+        count += length;
+    }
+
+    // Send any blocks still queued, so `bytes` needn't outlive the call
+    if (sd->tx_iov_count > 0) flush_frames(sd);
+    return count;
+}
+
+
+/**
+ * @brief Read data from the I2C host.
+ *
+ * @param sd:         Pointer to an I2CDriver structure.
+ * @param bytes:      A buffer for the bytes to read.
+ * @param byte_count: The number of bytes to write.
+ */
+size_t i2c_read(I2CDriver *sd, uint8_t bytes[], size_t byte_count) {
+
+    // FROM 1.2.0
+    // Reads are not pipelined: the response depends on whether
+    // preceding ops succeeded, so collect their ACKs first
+    if (sd->acks_pending > 0) i2c_pipeline_drain(sd);
+
+    // FROM 1.2.0
+    // Don't issue the read if an earlier op in the pipeline failed:
+    // the bus host will not send the data we'd wait for
+    if (sd->is_pipelined && sd->failed_op != 0) return 0;
+
+    size_t bytes_read = 0;
+
+    // FROM 1.2.0
+    // If the bus host supports it, read large blocks with long frames.
+    // The bus host responds with ACK and the data, or ERR
+    size_t long_length = get_long_frame_length(sd, byte_count);
+    if (long_length > 0) {
+        while (bytes_read < byte_count) {
+            size_t length = ((byte_count - bytes_read) < long_length) ? (byte_count - bytes_read) : long_length;
+            uint8_t read_cmd[3] = {'r', (uint8_t)(length & 0xFF), (uint8_t)((length >> 8) & 0xFF)};
+            uint8_t ack = 0;
+
+            writeToSerialPort(sd, read_cmd, 3);
+            if (readFromSerialPort(sd, &ack, 1) != 1) break;
+            record_latency(sd, 'r');
+            trace_status(sd, ack == ACK);
+            if (ack != ACK) break;
+            size_t result = readFromSerialPort(sd, bytes + bytes_read, length);
+            if (result == -1) {
+                print_error("Could not read back from device");
+                break;
+            }
+
+            bytes_read += result;
+        }
+
+        return bytes_read;
+    }
+
+    while (bytes_read < byte_count) {
+        // Calculate data length for prefix byte
+        size_t length = ((byte_count - bytes_read) < 64) ? (byte_count - bytes_read) : 64;
+        uint8_t read_cmd[1] = {(uint8_t)(PREFIX_BYTE_READ + length - 1)};
+
+        writeToSerialPort(sd, read_cmd, 1);
+        size_t result = readFromSerialPort(sd, bytes + bytes_read, length);
+        if (result == -1) {
+            print_error("Could not read back from device");
+            break;
+        }
+
+        record_latency(sd, read_cmd[0]);
+
+        bytes_read += result;
+    }
+
+    return bytes_read;
+}
+
+
+/**
+ * @brief Whether the bus host can write data to a device then read
+ *        data back from it with a repeated START between the two. It
+ *        must support the transfer command, and neither count may be
+ *        more than a transfer can carry.
+ *        FROM 1.2.0
+ *
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param write_count: The number of bytes to write.
+ * @param read_count:  The number of bytes to read.
+ *
+ * @retval Whether the transfer can be made (`true`) or not (`false`).
+ */
+bool i2c_can_transfer(I2CDriver *sd, size_t write_count, size_t read_count) {
+
+    return (sd->capabilities & CAPABILITY_TRANSFER) != 0 &&
+           write_count > 0 && write_count <= I2C_TRANSFER_LENGTH_MAX_B &&
+           read_count > 0 && read_count <= I2C_TRANSFER_LENGTH_MAX_B;
+}
+
+
+/**
+ * @brief Write data to a device then read data back from it,
+ *        with a repeated START between the two, eg. to read a
+ *        register. If the bus host supports it, this is a single
+ *        command. Otherwise, the write and the read are made as
+ *        separate ops, with a STOP rather than a repeated START
+ *        between them: check with `i2c_can_transfer()` if the
+ *        device needs the repeated START.
+ *        FROM 1.2.0
+ *
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param address:     The target device's I2C address.
+ * @param write_bytes: The bytes to write.
+ * @param write_count: The number of bytes to write.
+ * @param read_bytes:  A buffer for the bytes to read.
+ * @param read_count:  The number of bytes to read.
+ *
+ * @retval Whether all the bytes were written and read (`true`) or not (`false`).
+ */
+bool i2c_transfer(I2CDriver *sd, uint8_t address, const uint8_t write_bytes[], size_t write_count, uint8_t read_bytes[], size_t read_count) {
+
+    if (!i2c_can_transfer(sd, write_count, read_count)) {
+        // Fall back to separate ops
+        bool result = i2c_start(sd, address, 0) &&
+                      i2c_write(sd, write_bytes, write_count) == write_count &&
+                      i2c_start(sd, address, 1) &&
+                      i2c_read(sd, read_bytes, read_count) == read_count;
+        i2c_stop(sd);
+        return result;
+    }
+
+    // As with reads, collect outstanding ACKs first
+    if (sd->acks_pending > 0) i2c_pipeline_drain(sd);
+
+    // Frame is: command, address, write count, read count, data
+    uint8_t transfer_cmd[4 + I2C_TRANSFER_LENGTH_MAX_B] = {'t', (uint8_t)(address << 1), (uint8_t)write_count, (uint8_t)read_count};
+    memcpy(transfer_cmd + 4, write_bytes, write_count);
+    writeToSerialPort(sd, transfer_cmd, 4 + write_count);
+
+    // Response is ACK then the data, or ERR
+    uint8_t ack = 0;
+    if (readResponseFromSerialPort(sd, 't', &ack, 1) == 1) {
+        record_latency(sd, 't');
+        trace_status(sd, ack == ACK);
+    }
+
+    if (ack != ACK) {
+        if (ack == ERR && sd->failed_op == 0) sd->failed_op = 't';
+        return false;
+    }
+    if (readResponseFromSerialPort(sd, 't', read_bytes, read_count) != read_count) {
+        print_error("Could not read back from device");
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Perform a complete I2C transaction with a device: write
+ *        any bytes, read any bytes after a repeated START, then STOP.
+ *        With no bytes to write or read, just probe the address.
+ *        FROM 1.2.0
+ *
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param address:     The target device's I2C address.
+ * @param write_bytes: The bytes to write.
+ * @param write_count: The number of bytes to write.
+ * @param read_bytes:  A buffer for the bytes to read.
+ * @param read_count:  The number of bytes to read.
+ *
+ * @retval Whether the transaction succeeded (`true`) or not (`false`). On
+ *         failure, `failed_op` is set if the bus host reported an error.
+ */
+bool i2c_transaction(I2CDriver *sd, uint8_t address, const uint8_t write_bytes[], size_t write_count, uint8_t read_bytes[], size_t read_count) {
+
+    sd->failed_op = 0;
+
+    // Write then read, eg. a register, with a repeated START
+    if (write_count > 0 && read_count > 0) {
+        return i2c_transfer(sd, address, write_bytes, write_count, read_bytes, read_count);
+    }
+
+    if (read_count > 0) {
+        bool result = i2c_start(sd, address, 1) && i2c_read(sd, read_bytes, read_count) == read_count;
+
+        // Always release the bus
+        i2c_stop(sd);
+        return result;
+    }
+
+    // Write the bytes, or probe the address if there are none
+    i2c_pipeline_begin(sd);
+    i2c_start(sd, address, 0);
+    i2c_write(sd, write_bytes, write_count);
+    i2c_stop(sd);
+    return i2c_pipeline_end(sd);
+}
+
+
+/**
+ * @brief Run a list of transactions in order, keeping as many in
+ *        flight as the bus host can buffer: each transaction's frames
+ *        are queued behind the last's, and responses are matched to
+ *        them as they arrive. Bus hosts without pipelining and long
+ *        frames, and transactions too big for the bus host's receive
+ *        buffer, are run by `i2c_transaction()` once the transactions
+ *        ahead of them have completed.
+ *        FROM 1.2.0
+ *
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param batch:       The first transaction. Others follow via `next`.
+ * @param on_complete: Called with each transaction, in order, as it completes.
+ * @param context:     Passed to `on_complete`.
+ */
+void i2c_transaction_batch(I2CDriver *sd, I2CTransaction* batch, I2CCompletion on_complete, void* context) {
+
+    I2CBatch pending = {.on_complete = on_complete, .context = context};
+    if (sd->acks_pending > 0) i2c_pipeline_drain(sd);
+    sd->tx_in_flight = 0;
+
+    while (batch != NULL) {
+        I2CTransaction* transaction = batch;
+        batch = batch->next;
+        transaction->next = NULL;
+
+        size_t length = get_transaction_length(sd, transaction);
+        if (length == 0) {
+            finish_batch(sd, &pending);
+            transaction->succeeded = i2c_transaction(sd, transaction->address,
+                                                     transaction->write_bytes, transaction->write_count,
+                                                     transaction->read_bytes, transaction->read_count);
+            on_complete(transaction, context);
+            continue;
+        }
+
+        // Wait for responses until the bus host has room for the frames
+        while (pending.count > 0 &&
+               (pending.count + I2C_TRANSACTION_STEPS_MAX > I2C_PIPELINE_OPS_MAX || sd->tx_in_flight + length > sd->tx_window)) {
+            if (!collect_batch_response(sd, &pending)) abandon_batch(sd, &pending);
+        }
+
+        if (!queue_transaction(sd, &pending, transaction)) abandon_batch(sd, &pending);
+    }
+
+    finish_batch(sd, &pending);
+}
+
+
+/**
+ * @brief Write the contents of a file, or stdin, to a device in
+ *        a single transaction. The bus host ends every frame with
+ *        a STOP, so the contents must fit in one frame: up to 4096
+ *        bytes with long frames, or 64 bytes without.
+ *        FROM 1.2.0
+ *
+ * @param sd:      Pointer to an I2CDriver structure.
+ * @param address: The target device's I2C address.
+ * @param path:    The file's path, or `-` for stdin.
+ *
+ * @retval Whether all the data was written (`true`) or not (`false`).
+ */
+static bool i2c_write_file(I2CDriver *sd, uint8_t address, const char* path) {
+
+    FILE* source = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    if (source == NULL) {
+        print_error("Could not open file %s", path);
+        return false;
+    }
+
+    // Read one byte more than a frame holds, to catch larger files
+    size_t max_length = get_long_frame_length(sd, I2C_LONG_FRAME_LENGTH_MAX_B);
+    if (max_length == 0) max_length = 64;
+    uint8_t bytes[I2C_LONG_FRAME_LENGTH_MAX_B + 1];
+    size_t length = fread(bytes, 1, max_length + 1, source);
+    if (source != stdin) fclose(source);
+
+    if (length > max_length) {
+        print_error("%s holds more than the %zu bytes the I2C host can write in one transaction",
+                    (strcmp(path, "-") == 0 ? "Input" : path), max_length);
+        return false;
+    }
+
+    i2c_pipeline_begin(sd);
+    i2c_start(sd, address, 0);
+    bool result = (i2c_write(sd, bytes, length) == length);
+    if (!i2c_pipeline_end(sd) || !result) {
+        print_warning("%s un-ACK’d", get_op_name(sd->failed_op != 0 ? sd->failed_op : 'w'));
+        return false;
+    }
+
+    return true;
+}
+
+
+#pragma mark - GPIO Functions
+
+/**
+ * @brief Set a GPIO pin.
+ *
+ * @param sd:  Pointer to an I2CDriver structure.
+ * @param pin: The state, direction and number of the target GPIO.
+ *
+ * @retval Was the command ACK'd (`true`) or not (`false`).
+ */
+static bool gpio_set_pin(I2CDriver *sd, uint8_t pin) {
+    
+    uint8_t set_pin_data[2] = {'g', pin};
+    writeToSerialPort(sd, set_pin_data, sizeof(set_pin_data));
+    return i2c_ack(sd);
+}
+
+
+/**
+ * @brief Read a GPIO pin.
+ *
+ * @param sd:  Pointer to an I2CDriver structure.
+ * @param pin: The state, direction and number of the target GPIO.
+ *
+ * @retval Was the command ACK'd (`true`) or not (`false`).
+ */
+static uint8_t gpio_get_pin(I2CDriver *sd, uint8_t pin) {
+    
+    uint8_t set_pin_data[2] = {'g', pin};
+    writeToSerialPort(sd, set_pin_data, sizeof(set_pin_data));
+    uint8_t pin_read = 0;
+    
+    // FROM 1.2.0 -- The host replies with the pin value directly,
+    //               so read it without issuing a read prefix
+    size_t result = readFromSerialPort(sd, &pin_read, 1);
+    if (result == -1) {
+        print_error("Could not read pin value from device");
+    } else {
+        record_latency(sd, 'g');
+    }
+
+    return pin_read;
+}
+
+
+#pragma mark - Board Control Functions
+
+/**
+ * @brief Control the board's LED heartbeat.
+ *
+ * @param sd:    Pointer to an I2CDriver structure.
+ * @param is_on: Whether the LED should by on (`true`) or off (`false`).
+ *
+ * @retval Was the command ACK'd (`true`) or not (`false`).
+ */
+static bool board_set_led(I2CDriver *sd, bool is_on) {
+    
+    uint8_t set_led_data[2] = {'*', (is_on ? 1 : 0)};
+    writeToSerialPort(sd, set_led_data, sizeof(set_led_data));
+    return i2c_ack(sd);
+}
+
+
+/**
+ * @brief Control the board's LED heartbeat.
+ *
+ * @param sd:    Pointer to an I2CDriver structure.
+ *
+ * @retval Was the command ACK'd (`true`) or not (`false`).
+ */
+static bool board_get_last_error(I2CDriver *sd) {
+    
+    uint8_t last_error;
+    
+    send_command(sd, '$');
+    size_t result = readFromSerialPort(sd, &last_error, 1);
+    if (result == -1) {
+        print_error("Could not read last error from device");
+        return false;
+    }
+    
+    // Check for old firmware versions: they'll ERR
+    if (last_error == ERR) {
+        print_warning("Board is on firmware pre-1.1.3 and doesn't support this feature");
+    } else {
+        print_log("Last error code recorded by board: 0x%02X", last_error);
+        
+    }
+    
+    return true;
+}
+
+
+/**
+ * @brief Ask the bus host which features its firmware supports,
+ *        and how many bytes it can receive before it must ACK.
+ *        Pre-1.2.0 firmware will ERR the request, so report none.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ */
+static void board_get_capabilities(I2CDriver *sd) {
+
+    uint8_t response[3] = {0};
+    sd->capabilities = 0;
+    sd->tx_window = 0;
+
+    send_command(sd, '#');
+    if (readFromSerialPort(sd, response, 1) != 1) return;
+    trace_status(sd, response[0] == ACK);
+    if (response[0] != ACK) return;
+    if (readFromSerialPort(sd, response, 3) != 3) return;
+
+    // Data is: capability flags, then window size (little endian)
+    sd->capabilities = response[0];
+    sd->tx_window = response[1] | (response[2] << 8);
+
+#ifdef DEBUG
+    print_log("Bus host capabilities: 0x%02X, window: %i bytes", sd->capabilities, sd->tx_window);
+#endif
+}
+
+
+/**
+ * @brief Write a frame to the serial port. When pipelining,
+ *        the frame is queued and sent along with later frames.
+ *        FROM 1.2.0
+ *
+ * @param sd:     Pointer to an I2CDriver structure.
+ * @param frame:  The frame's bytes.
+ * @param length: The frame length in bytes.
+ *
+ * @retval Whether the frame was written or queued (`true`) or not (`false`).
+ */
+static bool send_frame(I2CDriver *sd, const uint8_t* frame, size_t length) {
+
+    if (!queue_frame(sd, frame, length, NULL, 0)) return false;
+    return sd->is_pipelined ? true : flush_frames(sd);
+}
+
+
+/**
+ * @brief Queue a frame for sending. The header -- a command or data
+ *        prefix -- is copied; the data is not, so it must be left
+ *        unchanged until the frame is sent by `flush_frames()`.
+ *        When pipelining, first wait for outstanding ACKs if the frame
+ *        would overfill the bus host's receive buffer: each ACK is a
+ *        credit for the bytes of the frame that prompted it.
+ *        FROM 1.2.0
+ *
+ * @param sd:            Pointer to an I2CDriver structure.
+ * @param header:        The frame's leading bytes.
+ * @param header_length: The number of leading bytes.
+ * @param data:          The frame's data bytes, or NULL.
+ * @param data_length:   The number of data bytes.
+ *
+ * @retval Whether the frame was queued (`true`) or not (`false`).
+ */
+static bool queue_frame(I2CDriver *sd, const uint8_t* header, size_t header_length, const uint8_t* data, size_t data_length) {
+
+    if (sd->is_pipelined) {
+        if (sd->tx_in_flight + header_length + data_length > sd->tx_window) i2c_pipeline_drain(sd);
+        sd->tx_in_flight += header_length + data_length;
+    }
+
+    if (sd->trace != NULL) i2c_trace_tx(sd->trace, header[0], header_length + data_length);
+    if (sd->stats != NULL) i2c_stats_queued(sd->stats, header[0]);
+
+    // Send what's queued if there's no room for this frame
+    if (sd->tx_iov_count + 2 > I2C_TX_IOV_MAX || sd->tx_headers_count + header_length > I2C_TX_HEADERS_MAX_B) {
+        if (!flush_frames(sd)) return false;
+    }
 
-    for (int i = 0 ; i < 0x80 ; i++) {
-        if (i % 16 == 0) fprintf(stderr, "\n%02x ", i);
-        if (i < 8 || i > 0x77) {
-            fprintf(stderr, "  ");
-        } else {
-            bool found = false;
+    // Copy the header, extending the previous segment if that's
+    // also a header, so runs of commands make a single segment
+    uint8_t* dest = sd->tx_headers + sd->tx_headers_count;
+    memcpy(dest, header, header_length);
+    sd->tx_headers_count += header_length;
 
-            if (device_count > 0) {
-                for (int j = 0 ; j < 120 ; j++) {
-                    if (device_list[j] == i) {
-                        fprintf(stderr, "@ ");
-                        found = true;
-                        break;
-                    }
-                }
-            }
+    struct iovec* last = (sd->tx_iov_count > 0) ? &sd->tx_iov[sd->tx_iov_count - 1] : NULL;
+    if (last != NULL && (uint8_t*)last->iov_base + last->iov_len == dest) {
+        last->iov_len += header_length;
+    } else {
+        sd->tx_iov[sd->tx_iov_count].iov_base = dest;
+        sd->tx_iov[sd->tx_iov_count++].iov_len = header_length;
+    }
 
-            if (!found) fprintf(stderr, ". ");
-        }
+    if (data_length > 0) {
+        sd->tx_iov[sd->tx_iov_count].iov_base = (void*)data;
+        sd->tx_iov[sd->tx_iov_count++].iov_len = data_length;
     }
 
-    fprintf(stderr, "\n");
+    return true;
 }
 
 
 /**
- * @brief Tell the I2C host to Initialise the I2C bus.
+ * @brief Send all queued frames with a single write.
+ *        FROM 1.2.0
  *
  * @param sd: Pointer to an I2CDriver structure.
  *
- * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ * @retval Whether the frames were written (`true`) or not (`false`).
  */
-bool i2c_init(I2CDriver *sd) {
-
-    send_command(sd, 'i');
-    return i2c_ack(sd);
-};
+static bool flush_frames(I2CDriver *sd) {
+
+    bool result = writeVectorToSerialPort(sd->port, sd->tx_iov, sd->tx_iov_count);
+    if (sd->trace != NULL) i2c_trace_sent(sd->trace);
+    if (sd->stats != NULL) i2c_stats_sent(sd->stats);
+    sd->tx_iov_count = 0;
+    sd->tx_headers_count = 0;
+    return result;
+}
 
 
 /**
- * @brief Tell the I2C host to de-initialise (Kill) the I2C bus.
- *        FROM 1.1.3
+ * @brief Write a single-byte command to the serial port.
  *
  * @param sd: Pointer to an I2CDriver structure.
- *
- * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ * @param c:  A command character.
  */
-bool i2c_deinit(I2CDriver *sd) {
+static inline void send_command(I2CDriver* sd, char c) {
 
-    send_command(sd, 'k');
-    return i2c_ack(sd);
-};
+    send_frame(sd, (uint8_t*)&c, 1);
+}
 
 
 /**
- * @brief Tell the I2C host to set the bus speed.
- *
- * @param sd:    Pointer to an I2CDriver structure.
- * @param speed: Bus frequency in 100kHz. Only 1 or 4 supported.
+ * @brief If tracing, mark the response just read as an ACK or an ERR.
+ *        FROM 1.2.0
  *
- * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ * @param sd:   Pointer to an I2CDriver structure.
+ * @param ackd: Whether the response was an ACK.
  */
-static bool i2c_set_speed(I2CDriver *sd, long speed) {
-
-    switch(speed) {
-        case 1:
-            send_command(sd, '1');
-            break;
-        default:
-            send_command(sd, '4');
-    }
+static inline void trace_status(I2CDriver *sd, bool ackd) {
 
-    return i2c_ack(sd);
+    if (sd->trace != NULL) i2c_trace_set_status(sd->trace, ackd ? I2C_TRACE_STATUS_ACK : I2C_TRACE_STATUS_ERR);
 }
 
 
 /**
- * @brief Choose the I2C host's target bus: 0 (i2c0) or 1 (i2c1),
- *        and SDA and SCL pins. Firmware will return `ERR` on a
- *        mis-setting.
+ * @brief If gathering statistics, record the latency of the
+ *        response just read.
+ *        FROM 1.2.0
  *
  * @param sd:      Pointer to an I2CDriver structure.
- * @param bus_id:  The Pico SDK I2C bus ID: 0 or 1.
- * @param sda_pin: The SDA pin GPIO number.
- * @param scl_pin: The SCL pin GPIO number.
- *
- * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ * @param command: The command or prefix byte of the frame that
+ *                 prompted the response, or 0 for the last frame sent.
  */
-static bool i2c_set_bus(I2CDriver *sd, uint8_t bus_id, uint8_t sda_pin, uint8_t scl_pin) {
-    
-    if (bus_id < 0 || bus_id > 1) return false;
-    uint8_t set_bus_data[4] = {'c', (bus_id & 0x01), sda_pin, scl_pin};
-    writeToSerialPort(sd->port, set_bus_data, sizeof(set_bus_data));
-    return i2c_ack(sd);
+static inline void record_latency(I2CDriver *sd, uint8_t command) {
+
+    if (sd->stats != NULL) i2c_stats_record(sd->stats, command);
 }
 
 
 /**
- * @brief Tell the I2C host to reset the I2C bus.
+ * @brief Determine the data length of the long frames to use for
+ *        a write or read. These are only worth using when the
+ *        transfer won't fit in a standard 64-byte frame.
+ *        FROM 1.2.0
  *
- * @param sd: Pointer to an I2CDriver structure.
+ * @param sd:         Pointer to an I2CDriver structure.
+ * @param byte_count: The number of bytes to write or read.
  *
- * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ * @retval The maximum data length per frame, or 0 to use standard frames.
  */
-static bool i2c_reset(I2CDriver *sd) {
+static size_t get_long_frame_length(I2CDriver *sd, size_t byte_count) {
 
-    send_command(sd, 'x');
-    return i2c_ack(sd);
+    if ((sd->capabilities & CAPABILITY_LONG_FRAMES) == 0 || byte_count <= 64) return 0;
+
+    // Frames must also fit the bus host's receive buffer,
+    // less room for the command and length bytes
+    size_t length = I2C_LONG_FRAME_LENGTH_MAX_B;
+    if (sd->tx_window > 3 && sd->tx_window - 3 < length) length = sd->tx_window - 3;
+    return length;
 }
 
 
 /**
- * @brief Tell the I2C host to start an I2C transaction.
+ * @brief Determine how many bytes of frames a transaction will take
+ *        if it's run by `i2c_transaction_batch()`.
+ *        FROM 1.2.0
  *
- * @param sd:      Pointer to an I2CDriver structure.
- * @param address: The target device's I2C address.
- * @param op:      Read (0) or write (1) I2C operation.
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param transaction: The transaction.
  *
- * @retval Whether the command was ACK'd (`true`) or not (`false`).
+ * @retval The frames' length, or 0 if the transaction can't be pipelined.
  */
-bool i2c_start(I2CDriver *sd, uint8_t address, uint8_t op) {
+static size_t get_transaction_length(I2CDriver *sd, const I2CTransaction* transaction) {
 
-    // This is a two-byte command: command + (address | op)
-    uint8_t start_data[2] = {'s', ((address << 1) | op)};
-    writeToSerialPort(sd->port, start_data, sizeof(start_data));
-    return i2c_ack(sd);
+    // Responses are only self-describing -- ACK then any data, or ERR --
+    // with long frames, so we can't otherwise tell one from the next
+    uint8_t needed = CAPABILITY_PIPELINE | CAPABILITY_LONG_FRAMES;
+    if ((sd->capabilities & needed) != needed) return 0;
+    if (transaction->write_count > I2C_LONG_FRAME_LENGTH_MAX_B || transaction->read_count > I2C_LONG_FRAME_LENGTH_MAX_B) return 0;
+
+    size_t length = 0;
+    if (i2c_can_transfer(sd, transaction->write_count, transaction->read_count)) {
+        length = 4 + transaction->write_count;
+    } else {
+        if (transaction->write_count > 0 || transaction->read_count == 0) length += 2;
+        if (transaction->write_count > 0) length += 3 + transaction->write_count;
+        if (transaction->read_count > 0) length += 5;
+        length += 1;
+    }
+
+    return length <= sd->tx_window ? length : 0;
 }
 
 
 /**
- * @brief Tell the I2C host to issue a STOP to the I2C bus.
+ * @brief Queue a transaction's frames, as `i2cmanager.c` sends them,
+ *        and note the responses they will prompt.
+ *        FROM 1.2.0
  *
- * @param sd: Pointer to an I2CDriver structure.
+ * @param sd:          Pointer to an I2CDriver structure.
+ * @param batch:       The responses awaited.
+ * @param transaction: The transaction.
+ *
+ * @retval Whether the frames were queued (`true`) or not (`false`).
  */
-bool i2c_stop(I2CDriver *sd) {
+static bool queue_transaction(I2CDriver *sd, I2CBatch* batch, I2CTransaction* transaction) {
+
+    uint8_t address = (uint8_t)(transaction->address << 1);
+    size_t write_count = transaction->write_count;
+    size_t read_count = transaction->read_count;
+    bool result = true;
+    transaction->succeeded = true;
+
+    if (i2c_can_transfer(sd, write_count, read_count)) {
+        // A single write-then-read command
+        uint8_t transfer_cmd[4] = {'t', address, (uint8_t)write_count, (uint8_t)read_count};
+        result = queue_frame(sd, transfer_cmd, 4, transaction->write_bytes, write_count);
+        add_batch_step(sd, batch, transaction, 't', 4 + write_count, transaction->read_bytes, read_count);
+    } else {
+        // START then write the bytes, or just START to probe the address
+        if (write_count > 0 || read_count == 0) {
+            uint8_t start_cmd[2] = {'s', address};
+            result &= queue_frame(sd, start_cmd, 2, NULL, 0);
+            add_batch_step(sd, batch, transaction, 's', 2, NULL, 0);
+        }
 
-    send_command(sd, 'p');
-    return i2c_ack(sd);
+        if (write_count > 0) {
+            uint8_t write_cmd[3] = {'w', write_count & 0xFF, (write_count >> 8) & 0xFF};
+            result &= queue_frame(sd, write_cmd, 3, transaction->write_bytes, write_count);
+            add_batch_step(sd, batch, transaction, 'w', 3 + write_count, NULL, 0);
+        }
+
+        if (read_count > 0) {
+            uint8_t start_cmd[2] = {'s', address | 0x01};
+            uint8_t read_cmd[3] = {'r', read_count & 0xFF, (read_count >> 8) & 0xFF};
+            result &= queue_frame(sd, start_cmd, 2, NULL, 0);
+            add_batch_step(sd, batch, transaction, 's', 2, NULL, 0);
+            result &= queue_frame(sd, read_cmd, 3, NULL, 0);
+            add_batch_step(sd, batch, transaction, 'r', 3, transaction->read_bytes, read_count);
+        }
+
+        // Finish with a STOP
+        uint8_t stop_cmd = 'p';
+        result &= queue_frame(sd, &stop_cmd, 1, NULL, 0);
+        add_batch_step(sd, batch, transaction, 'p', 1, NULL, 0);
+    }
+
+    batch->steps[(batch->first + batch->count - 1) % I2C_PIPELINE_OPS_MAX].is_last = true;
+    return result;
 }
 
 
 /**
- * @brief Write data to the I2C host for transmission.
- *
- * @param sd:         Pointer to an I2CDriver structure.
- * @param bytes:      The bytes to write.
- * @param byte_count: The number of bytes to write.
+ * @brief Note a response that a queued frame will prompt,
+ *        and take credit for the frame's bytes.
+ *        FROM 1.2.0
  *
- * @retval The number of bytes received.
+ * @param sd:           Pointer to an I2CDriver structure.
+ * @param batch:        The responses awaited.
+ * @param transaction:  The transaction the frame belongs to.
+ * @param command:      The frame's command byte.
+ * @param frame_length: The frame's length in bytes.
+ * @param data:         A buffer for data following an ACK, or NULL.
+ * @param data_count:   The number of data bytes following an ACK.
  */
-size_t i2c_write(I2CDriver *sd, const uint8_t bytes[], size_t byte_count) {
+static void add_batch_step(I2CDriver *sd, I2CBatch* batch, I2CTransaction* transaction, uint8_t command, size_t frame_length, uint8_t* data, size_t data_count) {
+
+    I2CBatchStep* step = &batch->steps[(batch->first + batch->count) % I2C_PIPELINE_OPS_MAX];
+    step->transaction = transaction;
+    step->command = command;
+    step->frame_length = (uint32_t)frame_length;
+    step->data = data;
+    step->data_count = data_count;
+    step->is_last = false;
+    batch->count++;
+    sd->tx_in_flight += (uint32_t)frame_length;
+}
 
-    // Count the bytes sent
-    int count = 0;
-    bool ack = false;
 
-    // Write the data out in blocks of 64 bytes
-    for (size_t i = 0 ; i < byte_count ; i += 64) {
-        // Calculate the data length for the prefix byte
-        size_t length = ((byte_count - i) < 64) ? (byte_count - i) : 64;
-        uint8_t write_cmd[65] = {(uint8_t)(PREFIX_BYTE_WRITE + length - 1)};
+/**
+ * @brief Read the response to the oldest frame awaiting one, and
+ *        complete its transaction if that was the final frame.
+ *        FROM 1.2.0
+ *
+ * @param sd:    Pointer to an I2CDriver structure.
+ * @param batch: The responses awaited.
+ *
+ * @retval Whether a response was read (`true`) or we lost track of them (`false`).
+ */
+static bool collect_batch_response(I2CDriver *sd, I2CBatch* batch) {
 
-        // Write a block of bytes to the send buffer
-        memcpy(write_cmd + 1, bytes + i, length);
+    I2CBatchStep step = batch->steps[batch->first];
+    uint8_t ack = 0;
+    if (readResponseFromSerialPort(sd, step.command, &ack, 1) != 1) return false;
+    if (ack != ACK && ack != ERR) {
+        print_error("Unexpected response 0x%02X to %s", ack, get_op_name(step.command));
+        return false;
+    }
 
-        // Write out the block -- use ACK as byte count
-        writeToSerialPort(sd->port, write_cmd, 1 + length);
-        ack = i2c_ack(sd);
-        if (!ack) break;
-        count += length;
+    record_latency(sd, step.command);
+    trace_status(sd, ack == ACK);
+    sd->tx_in_flight = (sd->tx_in_flight > step.frame_length) ? sd->tx_in_flight - step.frame_length : 0;
+
+    if (ack == ERR) {
+        step.transaction->succeeded = false;
+    } else if (step.data_count > 0 && readResponseFromSerialPort(sd, step.command, step.data, step.data_count) != step.data_count) {
+        return false;
     }
 
-    return count;
+    batch->first = (batch->first + 1) % I2C_PIPELINE_OPS_MAX;
+    batch->count--;
+    if (step.is_last) batch->on_complete(step.transaction, batch->context);
+    return true;
 }
 
 
 /**
- * @brief Read data from the I2C host.
+ * @brief Collect the responses to all the frames in flight.
+ *        FROM 1.2.0
  *
- * @param sd:         Pointer to an I2CDriver structure.
- * @param bytes:      A buffer for the bytes to read.
- * @param byte_count: The number of bytes to write.
+ * @param sd:    Pointer to an I2CDriver structure.
+ * @param batch: The responses awaited.
  */
-void i2c_read(I2CDriver *sd, uint8_t bytes[], size_t byte_count) {
-
-    for (size_t i = 0 ; i < byte_count ; i += 64) {
-        // Calculate data length for prefix byte
-        size_t length = ((byte_count - i) < 64) ? (byte_count - i) : 64;
-        uint8_t read_cmd[1] = {(uint8_t)(PREFIX_BYTE_READ + length - 1)};
-
-        writeToSerialPort(sd->port, read_cmd, 1);
-        size_t result = readFromSerialPort(sd->port, bytes + i, length);
-        if (result == -1) {
-            print_error("Could not read back from device");
-        } else {
-            for (size_t i = 0 ; i < result ; ++i) {
-                fprintf(stdout, "%02X", bytes[i]);
-            }
+static void finish_batch(I2CDriver *sd, I2CBatch* batch) {
 
-            fprintf(stdout, "\n");
-        }
+    while (batch->count > 0) {
+        if (!collect_batch_response(sd, batch)) abandon_batch(sd, batch);
     }
 }
 
 
-#pragma mark - GPIO Functions
-
 /**
- * @brief Set a GPIO pin.
- *
- * @param sd:  Pointer to an I2CDriver structure.
- * @param pin: The state, direction and number of the target GPIO.
+ * @brief Fail the transactions in flight when their responses are
+ *        late or garbled, and drop whatever arrives, so the next
+ *        transaction starts afresh.
+ *        FROM 1.2.0
  *
- * @retval Was the command ACK'd (`true`) or not (`false`).
+ * @param sd:    Pointer to an I2CDriver structure.
+ * @param batch: The responses awaited.
  */
-static bool gpio_set_pin(I2CDriver *sd, uint8_t pin) {
-    
-    uint8_t set_pin_data[2] = {'g', pin};
-    writeToSerialPort(sd->port, set_pin_data, sizeof(set_pin_data));
-    return i2c_ack(sd);
+static void abandon_batch(I2CDriver *sd, I2CBatch* batch) {
+
+    tcflush(sd->port, TCIFLUSH);
+    sd->rx_start = 0;
+    sd->rx_count = 0;
+    sd->tx_in_flight = 0;
+
+    while (batch->count > 0) {
+        I2CBatchStep* step = &batch->steps[batch->first];
+        batch->first = (batch->first + 1) % I2C_PIPELINE_OPS_MAX;
+        batch->count--;
+        step->transaction->succeeded = false;
+        if (step->is_last) batch->on_complete(step->transaction, batch->context);
+    }
 }
 
 
 /**
- * @brief Read a GPIO pin.
+ * @brief Convert a comma-separated list of byte values, eg.
+ *        `0x05,0xFF`, into bytes.
+ *        FROM 1.2.0
  *
- * @param sd:  Pointer to an I2CDriver structure.
- * @param pin: The state, direction and number of the target GPIO.
+ * @param token:     The list as a string.
+ * @param bytes:     A buffer for the bytes.
+ * @param max_bytes: The size of the buffer.
  *
- * @retval Was the command ACK'd (`true`) or not (`false`).
+ * @retval The number of bytes, or 0 if the list is invalid.
  */
-static uint8_t gpio_get_pin(I2CDriver *sd, uint8_t pin) {
-    
-    uint8_t set_pin_data[2] = {'g', pin};
-    writeToSerialPort(sd->port, set_pin_data, sizeof(set_pin_data));
-    uint8_t pin_read = 0;
-    i2c_read(sd, &pin_read, 1);
-    return pin_read;
+static size_t parse_bytes(const char* token, uint8_t* bytes, size_t max_bytes) {
+
+    size_t num_bytes = 0;
+    char* endptr = (char*)token;
+
+    while (num_bytes < max_bytes) {
+        bytes[num_bytes++] = (uint8_t)strtol(endptr, &endptr, 0);
+        if (*endptr == '\0') break;
+        if (*endptr != ',') {
+            print_error("Invalid bytes: %s\n", token);
+            return 0;
+        }
+
+        endptr++;
+    }
+
+    return num_bytes;
 }
 
 
-#pragma mark - Board Control Functions
+#pragma mark - User Feedback Functions
+
 
 /**
- * @brief Control the board's LED heartbeat.
+ * @brief Get a human-readable name for an op.
+ *        FROM 1.2.0
  *
- * @param sd:    Pointer to an I2CDriver structure.
- * @param is_on: Whether the LED should by on (`true`) or off (`false`).
+ * @param op: The op's command or prefix byte.
  *
- * @retval Was the command ACK'd (`true`) or not (`false`).
+ * @retval The op's name.
  */
-static bool board_set_led(I2CDriver *sd, bool is_on) {
-    
-    uint8_t set_led_data[2] = {'*', (is_on ? 1 : 0)};
-    writeToSerialPort(sd->port, set_led_data, sizeof(set_led_data));
-    return i2c_ack(sd);
+static inline const char* get_op_name(uint8_t op) {
+
+    if (op >= PREFIX_BYTE_WRITE) return "I2C write";
+    if (op >= PREFIX_BYTE_READ) return "I2C read";
+    if (op == 's') return "I2C start";
+    if (op == 'w') return "I2C write";
+    if (op == 'p') return "I2C stop";
+    return "Command";
 }
 
 
 /**
- * @brief Control the board's LED heartbeat.
+ * @brief Write data read from a device to stdout, either as
+ *        raw bytes or as a hex string, in a single write.
+ *        FROM 1.2.0
  *
- * @param sd:    Pointer to an I2CDriver structure.
- *
- * @retval Was the command ACK'd (`true`) or not (`false`).
+ * @param sd:         Pointer to an I2CDriver structure.
+ * @param bytes:      The bytes to output.
+ * @param byte_count: The number of bytes to output.
  */
-static bool board_get_last_error(I2CDriver *sd) {
-    
-    uint8_t last_error;
-    
-    send_command(sd, '$');
-    size_t result = readFromSerialPort(sd->port, &last_error, 1);
-    if (result == -1) {
-        print_error("Could not read last error from device");
-        return false;
+static void output_data(I2CDriver *sd, const uint8_t* bytes, size_t byte_count) {
+
+    if (sd->binary_io) {
+        fwrite(bytes, 1, byte_count, stdout);
+        return;
     }
-    
-    // Check for old firmware versions: they'll ERR
-    if (last_error == ERR) {
-        print_warning("Board is on firmware pre-1.1.3 and doesn't support this feature");
-    } else {
-        print_log("Last error code recorded by board: 0x%02X", last_error);
-        
+
+    static const char hex_chars[] = "0123456789ABCDEF";
+    char hex[2 * I2C_LONG_FRAME_LENGTH_MAX_B];
+
+    while (byte_count > 0) {
+        size_t length = byte_count < I2C_LONG_FRAME_LENGTH_MAX_B ? byte_count : I2C_LONG_FRAME_LENGTH_MAX_B;
+        for (size_t i = 0 ; i < length ; ++i) {
+            hex[2 * i] = hex_chars[bytes[i] >> 4];
+            hex[2 * i + 1] = hex_chars[bytes[i] & 0x0F];
+        }
+
+        fwrite(hex, 1, 2 * length, stdout);
+        bytes += length;
+        byte_count -= length;
     }
-    
-    return true;
 }
 
 
 /**
- * @brief Write a single-byte command to the serial port.
+ * @brief Output a list of devices found on the bus as a table.
+ *        FROM 1.2.0 -- Split out from `i2c_scan()`.
  *
- * @param sd: Pointer to an I2CDriver structure.
- * @param c:  A command character.
+ * @param devices:      The devices' addresses.
+ * @param device_count: The number of devices.
  */
-static inline void send_command(I2CDriver* sd, char c) {
+static void print_scan_table(const uint8_t* devices, int device_count) {
 
-    writeToSerialPort(sd->port, (uint8_t*)&c, 1);
-}
+    // FROM 1.2.0 -- Mark the devices found, rather than search
+    //               the list for every cell
+    bool is_present[0x80] = {false};
+    for (int i = 0 ; i < device_count ; ++i) is_present[devices[i] & 0x7F] = true;
 
+    // Output the device list as a table (even with no devices)
+    fprintf(stderr, "   0 1 2 3 4 5 6 7 8 9 A B C D E F");
 
-#pragma mark - User Feedback Functions
+    for (int i = 0 ; i < 0x80 ; i++) {
+        if (i % 16 == 0) fprintf(stderr, "\n%02x ", i);
+        if (i < 8 || i > 0x77) {
+            fprintf(stderr, "  ");
+        } else {
+            fprintf(stderr, is_present[i] ? "@ " : ". ");
+        }
+    }
+
+    fprintf(stderr, "\n");
+}
 
 
 /**
@@ -766,12 +2242,14 @@ static inline void print_bad_command_help(char* command) {
  *
  * @retval The driver exit code, 0 on success, 1 on failure.
  */
-int process_commands(I2CDriver *sd, int argc, char *argv[], uint32_t delta) {
+int process_commands(I2CDriver *sd, int argc, char *argv[], int delta) {
 
-    // Set a 10ms period for intra-command delay period
+    // FROM 1.2.0
+    // Commands are paced by the bus host's responses, but older
+    // firmware may need an additional, user-specified gap
     struct timespec pause;
-    pause.tv_sec = 0.010;
-    pause.tv_nsec = 0.010 * 1000000;
+    pause.tv_sec = sd->min_gap_us / 1000000;
+    pause.tv_nsec = (sd->min_gap_us % 1000000) * 1000;
 
     // Process args one by one
     for (int i = delta ; i < argc ; i++) {
@@ -989,11 +2467,22 @@ int process_commands(I2CDriver *sd, int argc, char *argv[], uint32_t delta) {
                         if (i < argc - 1) {
                             token = argv[++i];
                             size_t num_bytes = strtol(token, NULL, 0);
-                            uint8_t bytes[8192];
+                            uint8_t bytes[I2C_LONG_FRAME_LENGTH_MAX_B];
+                            size_t bytes_read = 0;
 
+                            // FROM 1.2.0
+                            // Read and output the data block by block
                             i2c_start(sd, address, 1);
-                            i2c_read(sd, bytes, num_bytes);
+                            while (bytes_read < num_bytes) {
+                                size_t length = (num_bytes - bytes_read) < sizeof(bytes) ? (num_bytes - bytes_read) : sizeof(bytes);
+                                size_t result = i2c_read(sd, bytes, length);
+                                output_data(sd, bytes, result);
+                                bytes_read += result;
+                                if (result < length) break;
+                            }
+
                             i2c_stop(sd);
+                            if (bytes_read > 0 && !sd->binary_io) fprintf(stdout, "\n");
                             break;
                         } else {
                             print_error("No I2C address given");
@@ -1007,9 +2496,59 @@ int process_commands(I2CDriver *sd, int argc, char *argv[], uint32_t delta) {
 
             case 'S':
             case 's':   // LIST DEVICES ON BUS
-                i2c_scan(sd);
+                {
+                    // FROM 1.2.0
+                    // Take an optional address range
+                    long first = 0x00;
+                    long last = SCAN_ADDRESS_MAX;
+                    if (i < argc - 2 && isdigit(argv[i + 1][0]) && isdigit(argv[i + 2][0])) {
+                        first = strtol(argv[++i], NULL, 0);
+                        last = strtol(argv[++i], NULL, 0);
+                        if (first < 0 || first > last || last > SCAN_ADDRESS_MAX) {
+                            print_error("I2C scan range out of range (0x00-0x%02X)", SCAN_ADDRESS_MAX);
+                            return EXIT_ERR;
+                        }
+                    }
+
+                    uint8_t devices[CONNECTED_DEVICES_MAX_B];
+                    int device_count = i2c_scan_range(sd, (uint8_t)first, (uint8_t)last, 0, devices, sizeof(devices));
+                    if (device_count == -1) return EXIT_ERR;
+                    print_scan_table(devices, device_count);
+                }
                 break;
 
+            // FROM 1.2.0
+            case 'T':
+            case 't':   // WRITE THEN READ WITH A REPEATED START
+                {
+                    if (i < argc - 3) {
+                        long address = strtol(argv[++i], NULL, 0);
+                        char* token = argv[++i];
+                        uint8_t write_bytes[I2C_TRANSFER_LENGTH_MAX_B];
+                        size_t write_count = parse_bytes(token, write_bytes, sizeof(write_bytes));
+                        if (write_count == 0) return EXIT_ERR;
+
+                        size_t read_count = strtol(argv[++i], NULL, 0);
+                        if (read_count == 0 || read_count > I2C_TRANSFER_LENGTH_MAX_B) {
+                            print_error("Read count out of range (1-%i)", I2C_TRANSFER_LENGTH_MAX_B);
+                            return EXIT_ERR;
+                        }
+
+                        uint8_t read_bytes[I2C_TRANSFER_LENGTH_MAX_B];
+                        if (!i2c_transfer(sd, (uint8_t)address, write_bytes, write_count, read_bytes, read_count)) {
+                            print_warning("I2C transfer un-ACK’d");
+                            break;
+                        }
+
+                        output_data(sd, read_bytes, read_count);
+                        if (!sd->binary_io) fprintf(stdout, "\n");
+                        break;
+                    }
+
+                    print_error("Incomplete transfer data given");
+                    return EXIT_ERR;
+                }
+
             case 'W':
             case 'w':   // WRITE TO THE I2C BUS
                 {
@@ -1021,23 +2560,23 @@ int process_commands(I2CDriver *sd, int argc, char *argv[], uint32_t delta) {
                         // Get the bytes to write if we can
                         if (i < argc - 1) {
                             token = argv[++i];
-                            size_t num_bytes = 0;
-                            uint8_t bytes[8192];
-                            char* endptr = token;
-
-                            while (num_bytes < sizeof(bytes)) {
-                                bytes[num_bytes++] = (uint8_t)strtol(endptr, &endptr, 0);
-                                if (*endptr == '\0') break;
-                                if (*endptr != ',') {
-                                    print_error("Invalid bytes: %s\n", token);
-                                    return EXIT_ERR;
-                                }
 
-                                endptr++;
+                            // FROM 1.2.0
+                            // In binary mode, stream the bytes from a file or stdin
+                            if (sd->binary_io) {
+                                if (!i2c_write_file(sd, (uint8_t)address, token)) return EXIT_ERR;
+                                break;
                             }
 
+                            uint8_t bytes[8192];
+                            size_t num_bytes = parse_bytes(token, bytes, sizeof(bytes));
+                            if (num_bytes == 0) return EXIT_ERR;
+
+                            // FROM 1.2.0 -- send START and data back to back
+                            i2c_pipeline_begin(sd);
                             i2c_start(sd, (uint8_t)address, 0);
                             i2c_write(sd, bytes, num_bytes);
+                            if (!i2c_pipeline_end(sd)) print_warning("%s un-ACK’d", get_op_name(sd->failed_op));
                             break;
                         } else {
                             print_error("No I2C address given");
@@ -1059,7 +2598,7 @@ int process_commands(I2CDriver *sd, int argc, char *argv[], uint32_t delta) {
                 // Initialize the I2C host's I2C bus
                 if (!(i2c_init(sd))) {
                     print_error("Could not initialise I2C");
-                    flush_and_close_port(sd->port);
+                    flush_and_close_port(sd);
                     return EXIT_ERR;
                 }
 
@@ -1070,8 +2609,8 @@ int process_commands(I2CDriver *sd, int argc, char *argv[], uint32_t delta) {
                 return EXIT_ERR;
         }
 
-        // Pause for the UART's breath
-        nanosleep(&pause, &pause);
+        // Pause for the UART's breath, if requested
+        if (sd->min_gap_us > 0) nanosleep(&pause, NULL);
     }
 
     return 0;
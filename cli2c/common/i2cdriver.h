@@ -13,6 +13,11 @@
 /*
  * INCLUDES
  */
+// FROM 1.2.0 -- for ppoll()
+#if defined(BUILD_FOR_LINUX) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -23,6 +28,7 @@
 #include <inttypes.h>
 #include <errno.h>
 #include <time.h>
+#include <ctype.h>
 #include <assert.h>
 #include <memory.h>
 #include <fcntl.h>
@@ -30,6 +36,12 @@
 #include <sys/ioctl.h>
 // FROM 1.1.2
 #include <limits.h>
+// FROM 1.2.0
+#include <poll.h>
+#include <sys/select.h>
+#include <sys/uio.h>
+#include "i2ctrace.h"
+#include "i2cstats.h"
 
 #ifndef BUILD_FOR_LINUX
 #include <IOKit/serial/ioss.h>
@@ -51,32 +63,82 @@
 #define HOST_INFO_BUFFER_MAX_B          129
 #define CONNECTED_DEVICES_MAX_B         120
 #define SCAN_BUFFER_MAX_B               512
+// FROM 1.2.0
+#define SCAN_ADDRESS_MAX                0x77
+#define SCAN_BITMAP_LENGTH_B            16
 
 #define ACK                             0x0F
 #define ERR                             0xF0
 
-// FROM 1.1.2
-#define READ_BUS_HOST_TIMEOUT_S         5
+// FROM 1.2.0
+#define READ_BUS_HOST_TIMEOUT_US        5000000
+#define SERIAL_RX_BUFFER_MAX_B          1024
+#define I2C_PIPELINE_OPS_MAX            64
+#define I2C_TX_IOV_MAX                  64
+#define I2C_TX_HEADERS_MAX_B            512
+#define I2C_TRANSACTION_STEPS_MAX       5
+
+// FROM 1.2.0
+// Bus host features, reported by the `#` command
+#define CAPABILITY_PIPELINE             0x01
+#define CAPABILITY_TRANSFER             0x02
+#define CAPABILITY_LONG_FRAMES          0x04
+#define CAPABILITY_SCAN_BITMAP          0x08
+
+// FROM 1.2.0
+#define I2C_TRANSFER_LENGTH_MAX_B       64
+#define I2C_LONG_FRAME_LENGTH_MAX_B     4096
 
 
 /*
  * STRUCTURES
  */
+// FROM 1.2.0
+// A connection to a bus host. Its fields are private to the driver:
+// get one with `i2c_open()`, and use the functions below
+typedef struct I2CDriver I2CDriver;
+
+// FROM 1.2.0
+// The bus host's details and I2C bus settings, set by `i2c_get_info()`
 typedef struct {
-    bool            connected;          // Set to true when connected
-    int             port;               // OS file descriptor for host
+    char            model[25];          // Bus host board, eg. "QTPY-RP2040"
+    char            version[24];        // Bus host firmware version and build
+    uint8_t         bus;                // I2C bus in use (0 or 1)
+    int             sda_pin;            // SDA GPIO
+    int             scl_pin;            // SCL GPIO
     unsigned int    speed;              // I2C line speed (in kHz)
-} I2CDriver;
+    uint8_t         capabilities;       // Bus host feature flags
+} I2CHostInfo;
+
+// FROM 1.2.0
+typedef struct I2CTransaction I2CTransaction;
+
+// Called when a transaction completes
+typedef void (*I2CCompletion)(I2CTransaction* transaction, void* context);
+
+// A transaction: write any bytes, read any bytes after a repeated START,
+// then STOP. The caller owns the record and its buffers, which must be
+// left alone until the transaction completes
+struct I2CTransaction {
+    uint8_t             address;        // The target device's I2C address
+    const uint8_t*      write_bytes;    // The bytes to write
+    size_t              write_count;    // The number of bytes to write
+    uint8_t*            read_bytes;     // A buffer for the bytes to read
+    size_t              read_count;     // The number of bytes to read
+    I2CCompletion       callback;       // Optional: if NULL, collect with `i2c_async_next_completed()`
+    void*               context;        // Passed to `callback`
+    bool                succeeded;      // Set on completion
+    I2CTransaction*     next;           // Private
+};
 
 
 /*
  * PROTOTYPES
  */
 // Serial Port Control Functions
-void            flush_and_close_port(int fd);
+void            flush_and_close_port(I2CDriver *sd);
 
 // I2C Driver Functions
-void            i2c_connect(I2CDriver *sd, const char* portname);
 bool            i2c_init(I2CDriver *sd);
 // FROM 1.1.3
 bool            i2c_deinit(I2CDriver *sd);
@@ -85,10 +147,32 @@ bool            i2c_start(I2CDriver *sd, uint8_t address, uint8_t op);
 bool            i2c_stop(I2CDriver *sd);
 
 size_t          i2c_write(I2CDriver *sd, const uint8_t bytes[], size_t nn);
-void            i2c_read(I2CDriver *sd, uint8_t bytes[], size_t nn);
+size_t          i2c_read(I2CDriver *sd, uint8_t bytes[], size_t nn);
+
+// FROM 1.2.0
+bool            i2c_pipeline_begin(I2CDriver *sd);
+bool            i2c_pipeline_end(I2CDriver *sd);
+bool            i2c_get_info(I2CDriver *sd, bool do_print);
+int             i2c_scan(I2CDriver *sd, uint8_t devices[], size_t max_devices);
+int             i2c_scan_range(I2CDriver *sd, uint8_t first, uint8_t last, uint32_t timeout_us, uint8_t devices[], size_t max_devices);
+I2CDriver*      i2c_open(const char* portname);
+I2CDriver*      i2c_open_traced(const char* portname, const char* trace_path);
+void            i2c_close(I2CDriver *sd);
+bool            i2c_can_transfer(I2CDriver *sd, size_t write_count, size_t read_count);
+bool            i2c_transfer(I2CDriver *sd, uint8_t address, const uint8_t write_bytes[], size_t write_count, uint8_t read_bytes[], size_t read_count);
+bool            i2c_transaction(I2CDriver *sd, uint8_t address, const uint8_t write_bytes[], size_t write_count, uint8_t read_bytes[], size_t read_count);
+void            i2c_transaction_batch(I2CDriver *sd, I2CTransaction* batch, I2CCompletion on_complete, void* context);
+int             i2c_get_fd(I2CDriver *sd);
+void            i2c_get_host_info(I2CDriver *sd, I2CHostInfo* info);
+uint8_t         i2c_get_capabilities(I2CDriver *sd);
+uint8_t         i2c_get_failed_op(I2CDriver *sd);
+void            i2c_set_min_gap(I2CDriver *sd, uint32_t min_gap_us);
+void            i2c_set_binary_io(I2CDriver *sd, bool binary_io);
+I2CStats*       i2c_enable_stats(I2CDriver *sd);
+I2CStats*       i2c_get_stats(I2CDriver *sd);
 
 // Command Parsing and Processing
-int             process_commands(I2CDriver *sd, int argc, char *argv[], uint32_t delta);
+int             process_commands(I2CDriver *sd, int argc, char *argv[], int delta);
 
 
 #endif  // I2C_DRIVER_H
@@ -0,0 +1,500 @@
+/*
+ * Generic macOS I2C driver - Multi-Host Manager (Linux only)
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#include "i2cmanager.h"
+#include "utils.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static I2CBusHost*  get_host(I2CManager* manager, const char* name);
+static void         start_next(I2CManager* manager, I2CBusHost* host);
+static bool         send_transaction(I2CBusHost* host, I2CTransaction* transaction);
+static void         process_bytes(I2CManager* manager, I2CBusHost* host, const uint8_t* bytes, size_t count);
+static void         complete(I2CManager* manager, I2CBusHost* host, bool succeeded);
+static void         finish(I2CManager* manager, I2CBusHost* host, bool succeeded);
+static void         fail_all(I2CManager* manager, I2CBusHost* host);
+static void         add_step(I2CBusHost* host, size_t data_count);
+static inline uint64_t get_time_us(void);
+
+
+/**
+ * @brief Create a manager with no bus hosts.
+ *
+ * @retval The manager, or NULL on error.
+ */
+I2CManager* i2c_manager_create(void) {
+
+    I2CManager* manager = calloc(1, sizeof(I2CManager));
+    if (manager == NULL) return NULL;
+
+    manager->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (manager->epoll_fd == -1) {
+        print_error("Could not create epoll set - %s (%d)", strerror(errno), errno);
+        free(manager);
+        return NULL;
+    }
+
+    return manager;
+}
+
+
+/**
+ * @brief Disconnect all the manager's bus hosts and free the manager.
+ *        Transactions not yet completed are abandoned to their owners.
+ *
+ * @param manager: The manager.
+ */
+void i2c_manager_destroy(I2CManager* manager) {
+
+    if (manager == NULL) return;
+
+    for (uint32_t i = 0 ; i < manager->host_count ; ++i) {
+        i2c_close(manager->hosts[i]->sd);
+        free(manager->hosts[i]);
+    }
+
+    close(manager->epoll_fd);
+    free(manager);
+}
+
+
+/**
+ * @brief Connect to a bus host, initialise its I2C bus, and
+ *        make it available by name.
+ *
+ * @param manager:     The manager.
+ * @param name:        The logical name of the host's bus, eg. `rack1`.
+ * @param device_path: The host's device path.
+ *
+ * @retval Whether the host was added (`true`) or not (`false`).
+ */
+bool i2c_manager_add_host(I2CManager* manager, const char* name, const char* device_path) {
+
+    if (manager->host_count == I2C_MANAGER_HOSTS_MAX || strlen(name) >= I2C_BUS_NAME_MAX_B) {
+        print_error("Could not add bus %s", name);
+        return false;
+    }
+
+    if (get_host(manager, name) != NULL) {
+        print_error("Bus %s already added", name);
+        return false;
+    }
+
+    I2CBusHost* host = calloc(1, sizeof(I2CBusHost));
+    if (host == NULL) return false;
+    strcpy(host->name, name);
+    host->sd = i2c_open(device_path);
+
+    if (host->sd == NULL || !i2c_init(host->sd)) {
+        i2c_close(host->sd);
+        free(host);
+        return false;
+    }
+
+    i2c_get_info(host->sd, false);
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = host;
+    if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_ADD, i2c_get_fd(host->sd), &event) == -1) {
+        print_error("Could not watch %s - %s (%d)", device_path, strerror(errno), errno);
+        i2c_close(host->sd);
+        free(host);
+        return false;
+    }
+
+    manager->hosts[manager->host_count++] = host;
+    return true;
+}
+
+
+/**
+ * @brief Queue a transaction for the named bus. Returns at once:
+ *        the transaction runs as `i2c_manager_run()` is called.
+ *
+ * @param manager:     The manager.
+ * @param name:        The logical name of the bus.
+ * @param transaction: The transaction. Write and read counts are
+ *                     limited to `I2C_LONG_FRAME_LENGTH_MAX_B`.
+ *
+ * @retval Whether the transaction was queued (`true`) or not (`false`).
+ */
+bool i2c_manager_submit(I2CManager* manager, const char* name, I2CTransaction* transaction) {
+
+    I2CBusHost* host = get_host(manager, name);
+    if (host == NULL) {
+        print_error("Unknown bus %s", name);
+        return false;
+    }
+
+    // FROM 1.2.0
+    if (host->is_dead) {
+        print_error("Bus %s is disconnected", name);
+        return false;
+    }
+
+    if (transaction->write_count > I2C_LONG_FRAME_LENGTH_MAX_B || transaction->read_count > I2C_LONG_FRAME_LENGTH_MAX_B) {
+        print_error("Transaction too large for bus %s", name);
+        return false;
+    }
+
+    transaction->next = NULL;
+    transaction->succeeded = false;
+    if (host->queue_tail != NULL) {
+        host->queue_tail->next = transaction;
+    } else {
+        host->queue_head = transaction;
+    }
+
+    host->queue_tail = transaction;
+    manager->pending++;
+    start_next(manager, host);
+    return true;
+}
+
+
+/**
+ * @brief Wait for responses from any bus host, and process them.
+ *        Transactions are completed, and their callbacks called,
+ *        as their final responses arrive. Each bus runs its own
+ *        transactions in order; different buses run in parallel.
+ *
+ * @param manager:    The manager.
+ * @param timeout_ms: The longest time to wait, or -1 to wait until
+ *                    there's a response.
+ *
+ * @retval The number of transactions not yet completed, or -1 on error.
+ */
+int i2c_manager_run(I2CManager* manager, int timeout_ms) {
+
+    if (manager->pending == 0) return 0;
+
+    // Don't wait past the earliest deadline
+    uint64_t now = get_time_us();
+    for (uint32_t i = 0 ; i < manager->host_count ; ++i) {
+        I2CBusHost* host = manager->hosts[i];
+        if (host->current == NULL) continue;
+
+        int wait_ms = (host->deadline_us > now) ? (int)((host->deadline_us - now + 999) / 1000) : 0;
+        if (timeout_ms < 0 || wait_ms < timeout_ms) timeout_ms = wait_ms;
+    }
+
+    struct epoll_event events[I2C_MANAGER_HOSTS_MAX];
+    int count = epoll_wait(manager->epoll_fd, events, I2C_MANAGER_HOSTS_MAX, timeout_ms);
+    if (count == -1) {
+        if (errno == EINTR) return manager->pending;
+        print_error("Could not wait for bus hosts - %s (%d)", strerror(errno), errno);
+        return -1;
+    }
+
+    for (int i = 0 ; i < count ; ++i) {
+        I2CBusHost* host = (I2CBusHost*)events[i].data.ptr;
+        uint8_t buffer[SERIAL_RX_BUFFER_MAX_B];
+        ssize_t result = read(i2c_get_fd(host->sd), buffer, sizeof(buffer));
+        if (result > 0) {
+            process_bytes(manager, host, buffer, result);
+        } else if ((events[i].events & (EPOLLERR | EPOLLHUP)) != 0) {
+            // The host has gone: stop watching it, and fail its transactions
+            // now rather than at their deadlines. Later submissions for it
+            // are refused
+            print_warning("Bus %s disconnected", host->name);
+            epoll_ctl(manager->epoll_fd, EPOLL_CTL_DEL, i2c_get_fd(host->sd), NULL);
+            host->is_dead = true;
+            fail_all(manager, host);
+        }
+    }
+
+    // Fail transactions whose hosts have gone quiet, and discard
+    // anything they send late so it's not taken as a later response
+    now = get_time_us();
+    for (uint32_t i = 0 ; i < manager->host_count ; ++i) {
+        I2CBusHost* host = manager->hosts[i];
+        if (host->current != NULL && now >= host->deadline_us) {
+            print_warning("Bus %s timed out", host->name);
+            tcflush(i2c_get_fd(host->sd), TCIFLUSH);
+            complete(manager, host, false);
+        }
+    }
+
+    return manager->pending;
+}
+
+
+/**
+ * @brief Find a bus host by its bus's name.
+ *
+ * @param manager: The manager.
+ * @param name:    The logical name of the bus.
+ *
+ * @retval The host, or NULL if there's no bus with that name.
+ */
+static I2CBusHost* get_host(I2CManager* manager, const char* name) {
+
+    for (uint32_t i = 0 ; i < manager->host_count ; ++i) {
+        if (strcmp(manager->hosts[i]->name, name) == 0) return manager->hosts[i];
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief If a bus host is idle, send it its next transaction.
+ *        Hosts whose firmware can't take long frames are driven
+ *        synchronously instead.
+ *
+ * @param manager: The manager.
+ * @param host:    The bus host.
+ */
+static void start_next(I2CManager* manager, I2CBusHost* host) {
+
+    while (host->current == NULL && host->queue_head != NULL) {
+        I2CTransaction* transaction = host->queue_head;
+        host->queue_head = transaction->next;
+        if (host->queue_head == NULL) host->queue_tail = NULL;
+        transaction->next = NULL;
+        host->current = transaction;
+
+        if ((i2c_get_capabilities(host->sd) & CAPABILITY_LONG_FRAMES) == 0) {
+            bool result = i2c_transaction(host->sd, transaction->address,
+                                          transaction->write_bytes, transaction->write_count,
+                                          transaction->read_bytes, transaction->read_count);
+            finish(manager, host, result);
+            continue;
+        }
+
+        if (!send_transaction(host, transaction)) finish(manager, host, false);
+    }
+}
+
+
+/**
+ * @brief Write all of a transaction's frames to its bus host, and
+ *        record the responses they'll prompt. Every response is an
+ *        ACK or ERR, optionally followed by data, so the responses
+ *        can be parsed as they arrive.
+ *
+ * @param host:        The bus host.
+ * @param transaction: The transaction.
+ *
+ * @retval Whether the frames were written (`true`) or not (`false`).
+ */
+static bool send_transaction(I2CBusHost* host, I2CTransaction* transaction) {
+
+    uint8_t headers[16];
+    size_t header_count = 0;
+    struct iovec iov[3];
+    int iov_count = 0;
+    uint8_t address = (uint8_t)(transaction->address << 1);
+
+    host->step_count = 0;
+    host->step = 0;
+    host->is_step_acked = false;
+    host->is_failed = false;
+    host->deadline_us = get_time_us() + READ_BUS_HOST_TIMEOUT_US;
+
+    if (i2c_can_transfer(host->sd, transaction->write_count, transaction->read_count)) {
+        // A single write-then-read command
+        uint8_t transfer_cmd[4] = {'t', address, (uint8_t)transaction->write_count, (uint8_t)transaction->read_count};
+        memcpy(headers, transfer_cmd, 4);
+        header_count = 4;
+        iov[iov_count].iov_base = headers;
+        iov[iov_count++].iov_len = header_count;
+        iov[iov_count].iov_base = (void*)transaction->write_bytes;
+        iov[iov_count++].iov_len = transaction->write_count;
+        add_step(host, transaction->read_count);
+    } else {
+        // START then write the bytes, or just START to probe the address
+        if (transaction->write_count > 0 || transaction->read_count == 0) {
+            headers[header_count++] = 's';
+            headers[header_count++] = address;
+            add_step(host, 0);
+        }
+
+        if (transaction->write_count > 0) {
+            headers[header_count++] = 'w';
+            headers[header_count++] = transaction->write_count & 0xFF;
+            headers[header_count++] = (transaction->write_count >> 8) & 0xFF;
+            add_step(host, 0);
+            iov[iov_count].iov_base = headers;
+            iov[iov_count++].iov_len = header_count;
+            iov[iov_count].iov_base = (void*)transaction->write_bytes;
+            iov[iov_count++].iov_len = transaction->write_count;
+        }
+
+        size_t tail_start = header_count;
+        if (transaction->read_count > 0) {
+            headers[header_count++] = 's';
+            headers[header_count++] = address | 0x01;
+            headers[header_count++] = 'r';
+            headers[header_count++] = transaction->read_count & 0xFF;
+            headers[header_count++] = (transaction->read_count >> 8) & 0xFF;
+            add_step(host, 0);
+            add_step(host, transaction->read_count);
+        }
+
+        // Finish with a STOP
+        headers[header_count++] = 'p';
+        add_step(host, 0);
+
+        if (iov_count == 0) tail_start = 0;
+        iov[iov_count].iov_base = headers + tail_start;
+        iov[iov_count++].iov_len = header_count - tail_start;
+    }
+
+    // Write it all out
+    int index = 0;
+    while (index < iov_count) {
+        ssize_t written = writev(i2c_get_fd(host->sd), &iov[index], iov_count - index);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            print_error("Could not write to bus %s - %s (%d)", host->name, strerror(errno), errno);
+            return false;
+        }
+
+        while (index < iov_count && (size_t)written >= iov[index].iov_len) {
+            written -= iov[index].iov_len;
+            index++;
+        }
+
+        if (index < iov_count) {
+            iov[index].iov_base = (uint8_t*)iov[index].iov_base + written;
+            iov[index].iov_len -= written;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Match bytes received from a bus host against the responses
+ *        its current transaction is expected to prompt.
+ *
+ * @param manager: The manager.
+ * @param host:    The bus host.
+ * @param bytes:   The bytes received.
+ * @param count:   The number of bytes received.
+ */
+static void process_bytes(I2CManager* manager, I2CBusHost* host, const uint8_t* bytes, size_t count) {
+
+    size_t index = 0;
+    while (index < count && host->current != NULL) {
+        I2CResponseStep* step = &host->steps[host->step];
+        bool is_step_done = false;
+
+        if (!host->is_step_acked) {
+            uint8_t response = bytes[index++];
+            if (response == ACK && step->data_count > 0) {
+                // The data follows
+                host->is_step_acked = true;
+                host->data_received = 0;
+            } else {
+                if (response != ACK) host->is_failed = true;
+                is_step_done = true;
+            }
+        } else {
+            size_t length = step->data_count - host->data_received;
+            if (length > count - index) length = count - index;
+            memcpy(host->current->read_bytes + host->data_received, bytes + index, length);
+            host->data_received += length;
+            index += length;
+            is_step_done = (host->data_received == step->data_count);
+        }
+
+        if (is_step_done) {
+            host->is_step_acked = false;
+            host->step++;
+            if (host->step == host->step_count) complete(manager, host, !host->is_failed);
+        }
+    }
+}
+
+
+/**
+ * @brief Complete a bus host's current transaction, then
+ *        start its next one, if it has one.
+ *
+ * @param manager:   The manager.
+ * @param host:      The bus host.
+ * @param succeeded: Whether the transaction succeeded.
+ */
+static void complete(I2CManager* manager, I2CBusHost* host, bool succeeded) {
+
+    finish(manager, host, succeeded);
+    start_next(manager, host);
+}
+
+
+/**
+ * @brief Complete a bus host's current transaction, but don't start
+ *        the next one. `start_next()` uses this so that it can loop
+ *        through synchronous transactions rather than recurse.
+ *
+ * @param manager:   The manager.
+ * @param host:      The bus host.
+ * @param succeeded: Whether the transaction succeeded.
+ */
+static void finish(I2CManager* manager, I2CBusHost* host, bool succeeded) {
+
+    I2CTransaction* transaction = host->current;
+    host->current = NULL;
+    transaction->succeeded = succeeded;
+    manager->pending--;
+
+    if (transaction->callback != NULL) transaction->callback(transaction, transaction->context);
+}
+
+
+/**
+ * @brief Fail a dead bus host's current transaction and every
+ *        transaction queued for it.
+ *
+ * @param manager: The manager.
+ * @param host:    The bus host.
+ */
+static void fail_all(I2CManager* manager, I2CBusHost* host) {
+
+    if (host->current != NULL) finish(manager, host, false);
+
+    while (host->queue_head != NULL) {
+        host->current = host->queue_head;
+        host->queue_head = host->current->next;
+        host->current->next = NULL;
+        finish(manager, host, false);
+    }
+
+    host->queue_tail = NULL;
+}
+
+
+/**
+ * @brief Record a response a bus host's current transaction will prompt.
+ *
+ * @param host:       The bus host.
+ * @param data_count: The number of data bytes that follow the ACK.
+ */
+static void add_step(I2CBusHost* host, size_t data_count) {
+
+    host->steps[host->step_count++].data_count = data_count;
+}
+
+
+/**
+ * @brief Get the monotonic time in microseconds.
+ *
+ * @retval The time.
+ */
+static inline uint64_t get_time_us(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
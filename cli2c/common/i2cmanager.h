@@ -0,0 +1,71 @@
+/*
+ * Generic macOS I2C driver - Multi-Host Manager (Linux only)
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#ifndef _I2C_MANAGER_H
+#define _I2C_MANAGER_H
+
+
+/*
+ * INCLUDES
+ */
+#include <sys/epoll.h>
+#include "i2cdriver.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define I2C_MANAGER_HOSTS_MAX           64
+#define I2C_BUS_NAME_MAX_B              32
+#define I2C_MANAGER_STEPS_MAX           5
+
+
+/*
+ * STRUCTURES
+ */
+// A response the manager expects from a bus host: an ACK,
+// or an ACK followed by `data_count` bytes of data
+typedef struct {
+    size_t              data_count;
+} I2CResponseStep;
+
+typedef struct {
+    char                name[I2C_BUS_NAME_MAX_B];   // The logical bus name
+    I2CDriver*          sd;                 // The host's connection, from `i2c_open()`
+    I2CTransaction*     queue_head;         // Transactions waiting to run, oldest first
+    I2CTransaction*     queue_tail;
+    I2CTransaction*     current;            // The transaction in progress, or NULL
+    I2CResponseStep     steps[I2C_MANAGER_STEPS_MAX];   // Responses `current` will prompt
+    uint32_t            step_count;
+    uint32_t            step;               // The response being received
+    bool                is_step_acked;      // Set when the step's ACK has arrived
+    size_t              data_received;      // Data bytes of the step received so far
+    bool                is_failed;          // Set if any response was an ERR
+    bool                is_dead;            // Set when the host disconnects
+    uint64_t            deadline_us;        // When to give up on `current`
+} I2CBusHost;
+
+typedef struct {
+    int                 epoll_fd;           // Watches every host's port
+    I2CBusHost*         hosts[I2C_MANAGER_HOSTS_MAX];
+    uint32_t            host_count;
+    uint32_t            pending;            // Transactions submitted but not completed
+} I2CManager;
+
+
+/*
+ * PROTOTYPES
+ */
+I2CManager*     i2c_manager_create(void);
+void            i2c_manager_destroy(I2CManager* manager);
+bool            i2c_manager_add_host(I2CManager* manager, const char* name, const char* device_path);
+bool            i2c_manager_submit(I2CManager* manager, const char* name, I2CTransaction* transaction);
+int             i2c_manager_run(I2CManager* manager, int timeout_ms);
+
+
+#endif  // _I2C_MANAGER_H
@@ -0,0 +1,384 @@
+/*
+ * Generic macOS I2C driver - Register Shadow Cache
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#include "i2cregcache.h"
+#include "utils.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static I2CRegBank*  get_bank(I2CRegCache* cache, uint8_t address);
+static bool         check_range(uint8_t address, uint8_t reg, size_t count);
+static bool         flush_bank(I2CRegCache* cache, uint8_t address);
+static bool         write_burst(I2CRegCache* cache, uint8_t address, uint32_t reg, const uint8_t values[], size_t count);
+static inline bool  is_known(const I2CRegBank* bank, uint32_t reg);
+
+
+/**
+ * @brief Create a shadow cache for the registers of devices on a
+ *        bus host's bus. All registers start out volatile: mark
+ *        those that only change when written with
+ *        `i2c_regcache_set_cacheable()`. The cache should be used
+ *        on the thread that uses the connection.
+ *
+ * @param sd: Pointer to a connected I2CDriver structure.
+ *
+ * @retval The cache, or NULL on error.
+ */
+I2CRegCache* i2c_regcache_create(I2CDriver *sd) {
+
+    I2CRegCache* cache = calloc(1, sizeof(I2CRegCache));
+    if (cache != NULL) cache->sd = sd;
+    return cache;
+}
+
+
+/**
+ * @brief Send any writes being held, then free the cache.
+ *
+ * @param cache: The cache.
+ */
+void i2c_regcache_destroy(I2CRegCache* cache) {
+
+    if (cache == NULL) return;
+    i2c_regcache_flush(cache);
+
+    for (uint32_t i = 0 ; i < I2C_REGCACHE_ADDRESSES ; ++i) {
+        free(cache->banks[i]);
+    }
+
+    free(cache);
+}
+
+
+/**
+ * @brief Mark a run of a device's registers as cacheable -- they
+ *        change only when written, so they can be read from the
+ *        cache and writes of the values they hold can be dropped --
+ *        or as volatile, so they are always read from the device.
+ *
+ * @param cache:        The cache.
+ * @param address:      The device's I2C address.
+ * @param reg:          The first register.
+ * @param count:        The number of registers.
+ * @param is_cacheable: Whether the registers are cacheable (`true`) or volatile (`false`).
+ *
+ * @retval Whether the registers were marked (`true`) or not (`false`).
+ */
+bool i2c_regcache_set_cacheable(I2CRegCache* cache, uint8_t address, uint8_t reg, size_t count, bool is_cacheable) {
+
+    if (!check_range(address, reg, count)) return false;
+    I2CRegBank* bank = get_bank(cache, address);
+    if (bank == NULL) return false;
+
+    for (size_t i = reg ; i < reg + count ; ++i) {
+        if (is_cacheable) {
+            bank->flags[i] |= I2C_REGCACHE_CACHEABLE;
+        } else {
+            // A volatile register's last known value is of no use
+            bank->flags[i] &= ~(I2C_REGCACHE_CACHEABLE | I2C_REGCACHE_VALID);
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Read a run of a device's registers. If they are all
+ *        cacheable and their values known, they are read from the
+ *        cache; otherwise, any writes held for the device are sent,
+ *        then the registers are read in a single transaction.
+ *
+ * @param cache:   The cache.
+ * @param address: The device's I2C address.
+ * @param reg:     The first register.
+ * @param values:  A buffer for the registers' values.
+ * @param count:   The number of registers to read.
+ *
+ * @retval Whether the registers were read (`true`) or not (`false`).
+ */
+bool i2c_regcache_read(I2CRegCache* cache, uint8_t address, uint8_t reg, uint8_t values[], size_t count) {
+
+    if (!check_range(address, reg, count)) return false;
+    I2CRegBank* bank = get_bank(cache, address);
+    if (bank == NULL) return false;
+
+    size_t known = 0;
+    while (known < count && is_known(bank, reg + known)) known++;
+    if (known == count) {
+        memcpy(values, &bank->values[reg], count);
+        cache->reads_saved++;
+        return true;
+    }
+
+    // Writes held for the device must reach it before the read
+    if (bank->dirty_count > 0 && !flush_bank(cache, address)) return false;
+
+    cache->transactions++;
+    if (!i2c_transaction(cache->sd, address, &reg, 1, values, count)) return false;
+
+    for (size_t i = 0 ; i < count ; ++i) {
+        if (bank->flags[reg + i] & I2C_REGCACHE_CACHEABLE) {
+            bank->values[reg + i] = values[i];
+            bank->flags[reg + i] |= I2C_REGCACHE_VALID;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Write a run of a device's registers. Cacheable registers
+ *        that already hold the values written are skipped. The rest
+ *        are sent now, as few bursts as possible, or, if the cache's
+ *        `is_combining` is set, held until `i2c_regcache_flush()` or
+ *        a read from the device, so that writes to adjacent registers
+ *        can be merged. Bursts assume the device auto-increments its
+ *        register pointer, and held writes are sent in register order.
+ *        Volatile registers are never held: every write to one is
+ *        sent at once, after any writes already held for the device.
+ *
+ * @param cache:   The cache.
+ * @param address: The device's I2C address.
+ * @param reg:     The first register.
+ * @param values:  The registers' new values.
+ * @param count:   The number of registers to write.
+ *
+ * @retval Whether the registers were written (`true`) or not (`false`).
+ */
+bool i2c_regcache_write(I2CRegCache* cache, uint8_t address, uint8_t reg, const uint8_t values[], size_t count) {
+
+    if (!check_range(address, reg, count)) return false;
+    I2CRegBank* bank = get_bank(cache, address);
+    if (bank == NULL) return false;
+
+    size_t i = 0;
+    while (i < count) {
+        uint8_t* flags = &bank->flags[reg + i];
+        if ((*flags & I2C_REGCACHE_CACHEABLE) == 0) {
+            // Writing a volatile register may have side effects, so each
+            // write is sent now, in order. Held writes must reach the
+            // device first
+            size_t run = 1;
+            while (i + run < count && (bank->flags[reg + i + run] & I2C_REGCACHE_CACHEABLE) == 0) run++;
+            if (bank->dirty_count > 0 && !flush_bank(cache, address)) return false;
+            if (!write_burst(cache, address, reg + i, &values[i], run)) return false;
+            i += run;
+            continue;
+        }
+
+        if ((*flags & I2C_REGCACHE_DIRTY) == 0) {
+            if (is_known(bank, reg + i) && bank->values[reg + i] == values[i]) {
+                cache->writes_saved++;
+                i++;
+                continue;
+            }
+
+            *flags |= I2C_REGCACHE_DIRTY;
+            bank->dirty_count++;
+        }
+
+        bank->values[reg + i] = values[i];
+        *flags |= I2C_REGCACHE_VALID;
+        i++;
+    }
+
+    if (cache->is_combining || bank->dirty_count == 0) return true;
+    return flush_bank(cache, address);
+}
+
+
+/**
+ * @brief Send all the writes being held.
+ *
+ * @param cache: The cache.
+ *
+ * @retval Whether all the writes were ACK'd (`true`) or not (`false`).
+ */
+bool i2c_regcache_flush(I2CRegCache* cache) {
+
+    bool result = true;
+    for (uint32_t i = 0 ; i < I2C_REGCACHE_ADDRESSES ; ++i) {
+        if (cache->banks[i] != NULL && cache->banks[i]->dirty_count > 0) {
+            if (!flush_bank(cache, (uint8_t)i)) result = false;
+        }
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief Forget the register values known for a device, eg. after
+ *        it has been reset. Writes being held are kept.
+ *
+ * @param cache:   The cache.
+ * @param address: The device's I2C address.
+ */
+void i2c_regcache_invalidate(I2CRegCache* cache, uint8_t address) {
+
+    if (address >= I2C_REGCACHE_ADDRESSES || cache->banks[address] == NULL) return;
+    I2CRegBank* bank = cache->banks[address];
+
+    for (uint32_t i = 0 ; i < I2C_REGCACHE_REGISTERS ; ++i) {
+        if ((bank->flags[i] & I2C_REGCACHE_DIRTY) == 0) bank->flags[i] &= ~I2C_REGCACHE_VALID;
+    }
+}
+
+
+/**
+ * @brief Get a device's bank of registers, creating it if needed.
+ *
+ * @param cache:   The cache.
+ * @param address: The device's I2C address.
+ *
+ * @retval The bank, or NULL on error.
+ */
+static I2CRegBank* get_bank(I2CRegCache* cache, uint8_t address) {
+
+    if (cache->banks[address] == NULL) {
+        cache->banks[address] = calloc(1, sizeof(I2CRegBank));
+        if (cache->banks[address] == NULL) print_error("Could not allocate register cache");
+    }
+
+    return cache->banks[address];
+}
+
+
+/**
+ * @brief Check a device address and a run of registers.
+ *
+ * @param address: The device's I2C address.
+ * @param reg:     The first register.
+ * @param count:   The number of registers.
+ *
+ * @retval Whether the values are in range (`true`) or not (`false`).
+ */
+static bool check_range(uint8_t address, uint8_t reg, size_t count) {
+
+    if (address >= I2C_REGCACHE_ADDRESSES) {
+        print_error("I2C address out of range: 0x%02X", address);
+        return false;
+    }
+
+    if (count == 0 || reg + count > I2C_REGCACHE_REGISTERS) {
+        print_error("Register range out of range: 0x%02X + %zu", reg, count);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Send the writes held for a device. Each run of dirty
+ *        registers, bridged across short gaps of registers whose
+ *        values are known, is written with `write_burst()`.
+ *
+ * @param cache:   The cache.
+ * @param address: The device's I2C address.
+ *
+ * @retval Whether all the writes were ACK'd (`true`) or not (`false`).
+ */
+static bool flush_bank(I2CRegCache* cache, uint8_t address) {
+
+    I2CRegBank* bank = cache->banks[address];
+    bool result = true;
+    uint32_t reg = 0;
+
+    while (bank->dirty_count > 0 && reg < I2C_REGCACHE_REGISTERS) {
+        // Find the next dirty register
+        if ((bank->flags[reg] & I2C_REGCACHE_DIRTY) == 0) {
+            reg++;
+            continue;
+        }
+
+        // Find the end of the run, bridging gaps where we can
+        uint32_t first = reg;
+        uint32_t last = reg;
+        for (uint32_t next = reg + 1 ; next < I2C_REGCACHE_REGISTERS && next <= last + I2C_REGCACHE_GAP_MAX + 1 ; ++next) {
+            if (bank->flags[next] & I2C_REGCACHE_DIRTY) {
+                last = next;
+            } else if (!is_known(bank, next)) {
+                break;
+            }
+        }
+
+        bool is_ok = write_burst(cache, address, first, &bank->values[first], last - first + 1);
+        if (!is_ok) result = false;
+
+        for (uint32_t i = first ; i <= last ; ++i) {
+            if (bank->flags[i] & I2C_REGCACHE_DIRTY) {
+                bank->flags[i] &= ~I2C_REGCACHE_DIRTY;
+                bank->dirty_count--;
+            }
+
+            // After a failure, we can't tell what the device holds
+            if (!is_ok) bank->flags[i] &= ~I2C_REGCACHE_VALID;
+        }
+
+        reg = last + 1;
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief Write values to a run of a device's registers: the first
+ *        register's number, then the values. Bus hosts without long
+ *        frames end each write frame with a STOP, so for them the run
+ *        is split into bursts that each fit one frame and start with
+ *        their own register number.
+ *
+ * @param cache:   The cache.
+ * @param address: The device's I2C address.
+ * @param reg:     The first register.
+ * @param values:  The registers' new values.
+ * @param count:   The number of registers to write.
+ *
+ * @retval Whether all the bursts were ACK'd (`true`) or not (`false`).
+ */
+static bool write_burst(I2CRegCache* cache, uint8_t address, uint32_t reg, const uint8_t values[], size_t count) {
+
+    size_t burst_max = I2C_REGCACHE_REGISTERS;
+    if ((i2c_get_capabilities(cache->sd) & CAPABILITY_LONG_FRAMES) == 0) burst_max = I2C_REGCACHE_BURST_MAX_B;
+
+    uint8_t burst[I2C_REGCACHE_REGISTERS + 1];
+    bool result = true;
+    for (size_t done = 0 ; done < count ; ) {
+        size_t length = count - done;
+        if (length > burst_max) length = burst_max;
+
+        burst[0] = (uint8_t)(reg + done);
+        memcpy(&burst[1], &values[done], length);
+
+        cache->transactions++;
+        if (!i2c_transaction(cache->sd, address, burst, length + 1, NULL, 0)) result = false;
+        done += length;
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief Whether the cache holds a register's current value.
+ *
+ * @param bank: The device's bank of registers.
+ * @param reg:  The register.
+ *
+ * @retval Whether the value is known (`true`) or not (`false`).
+ */
+static inline bool is_known(const I2CRegBank* bank, uint32_t reg) {
+
+    return (bank->flags[reg] & (I2C_REGCACHE_CACHEABLE | I2C_REGCACHE_VALID)) == (I2C_REGCACHE_CACHEABLE | I2C_REGCACHE_VALID);
+}
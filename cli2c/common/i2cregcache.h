@@ -0,0 +1,69 @@
+/*
+ * Generic macOS I2C driver - Register Shadow Cache
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#ifndef _I2C_REGCACHE_H
+#define _I2C_REGCACHE_H
+
+
+/*
+ * INCLUDES
+ */
+#include "i2cdriver.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define I2C_REGCACHE_REGISTERS          256
+#define I2C_REGCACHE_ADDRESSES          128
+// Bridge gaps of up to this many known, cacheable registers
+// between pending writes, to send them as one burst
+#define I2C_REGCACHE_GAP_MAX            4
+// A burst's register number and values must fit one write frame
+// on bus hosts without long frames
+#define I2C_REGCACHE_BURST_MAX_B        (I2C_TRANSFER_LENGTH_MAX_B - 1)
+
+// Register flags
+#define I2C_REGCACHE_CACHEABLE          0x01    // The register only changes when written
+#define I2C_REGCACHE_VALID              0x02    // `values` holds the register's value
+#define I2C_REGCACHE_DIRTY              0x04    // `values` holds a write not yet sent
+
+
+/*
+ * STRUCTURES
+ */
+// The shadow of one device's 8-bit register space
+typedef struct {
+    uint8_t             values[I2C_REGCACHE_REGISTERS];
+    uint8_t             flags[I2C_REGCACHE_REGISTERS];
+    uint32_t            dirty_count;    // Registers with I2C_REGCACHE_DIRTY set
+} I2CRegBank;
+
+typedef struct {
+    I2CDriver*          sd;             // The connection to the devices' bus host
+    I2CRegBank*         banks[I2C_REGCACHE_ADDRESSES];  // By device address: allocated on first use
+    bool                is_combining;   // Set to hold writes until `i2c_regcache_flush()`
+    uint64_t            transactions;   // Bus transactions made
+    uint64_t            reads_saved;    // Reads served from the cache
+    uint64_t            writes_saved;   // Register writes dropped as redundant
+} I2CRegCache;
+
+
+/*
+ * PROTOTYPES
+ */
+I2CRegCache*    i2c_regcache_create(I2CDriver *sd);
+void            i2c_regcache_destroy(I2CRegCache* cache);
+bool            i2c_regcache_set_cacheable(I2CRegCache* cache, uint8_t address, uint8_t reg, size_t count, bool is_cacheable);
+bool            i2c_regcache_read(I2CRegCache* cache, uint8_t address, uint8_t reg, uint8_t values[], size_t count);
+bool            i2c_regcache_write(I2CRegCache* cache, uint8_t address, uint8_t reg, const uint8_t values[], size_t count);
+bool            i2c_regcache_flush(I2CRegCache* cache);
+void            i2c_regcache_invalidate(I2CRegCache* cache, uint8_t address);
+
+
+#endif  // _I2C_REGCACHE_H
@@ -0,0 +1,239 @@
+/*
+ * Generic macOS I2C driver - Latency Statistics
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+#include "i2cstats.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static inline uint32_t  get_class(uint8_t command);
+static inline uint32_t  get_bucket(uint32_t value_us);
+static inline uint32_t  get_bucket_top(uint32_t bucket);
+static inline uint64_t  get_time_us(void);
+
+
+/*
+ * GLOBALS
+ */
+static const char* class_names[I2C_STATS_CLASSES] = {
+    "start", "stop", "write", "read", "transfer", "scan", "info", "gpio", "other"
+};
+
+
+/**
+ * @brief Create an empty set of histograms.
+ *
+ * @retval The statistics record, or NULL on error.
+ */
+I2CStats* i2c_stats_create(void) {
+
+    return calloc(1, sizeof(I2CStats));
+}
+
+
+/**
+ * @brief Free a set of histograms.
+ *
+ * @param stats: The statistics record.
+ */
+void i2c_stats_destroy(I2CStats* stats) {
+
+    free(stats);
+}
+
+
+/**
+ * @brief Note a frame queued for the bus host: a response
+ *        not otherwise attributed is credited to it.
+ *
+ * @param stats:   The statistics record.
+ * @param command: The frame's command or prefix byte.
+ */
+void i2c_stats_queued(I2CStats* stats, uint8_t command) {
+
+    stats->last_command = command;
+}
+
+
+/**
+ * @brief Note that queued frames have been written to the port:
+ *        latencies are measured from this point.
+ *
+ * @param stats: The statistics record.
+ */
+void i2c_stats_sent(I2CStats* stats) {
+
+    stats->last_tx_us = get_time_us();
+}
+
+
+/**
+ * @brief Record the time from the last write to the port to now,
+ *        ie. the latency of a response that has just been read.
+ *
+ * @param stats:   The statistics record.
+ * @param command: The command or prefix byte of the frame that
+ *                 prompted the response, or 0 for the last frame.
+ */
+void i2c_stats_record(I2CStats* stats, uint8_t command) {
+
+    uint64_t now_us = get_time_us();
+    uint64_t latency_us = (now_us > stats->last_tx_us) ? now_us - stats->last_tx_us : 0;
+    if (latency_us > UINT32_MAX) latency_us = UINT32_MAX;
+
+    i2c_stats_add(&stats->histograms[get_class(command != 0 ? command : stats->last_command)], (uint32_t)latency_us);
+}
+
+
+/**
+ * @brief Add a latency to a histogram.
+ *
+ * @param histogram:  The histogram.
+ * @param latency_us: The latency in microseconds.
+ */
+void i2c_stats_add(I2CHistogram* histogram, uint32_t latency_us) {
+
+    histogram->count++;
+    histogram->total_us += latency_us;
+    if (latency_us > histogram->max_us) histogram->max_us = latency_us;
+    histogram->buckets[get_bucket(latency_us)]++;
+}
+
+
+/**
+ * @brief Get the latency below which a given percentage of
+ *        recorded latencies fall, to the histogram's precision.
+ *
+ * @param histogram:  The histogram.
+ * @param percentile: The percentage, eg. 99.0.
+ *
+ * @retval The latency in microseconds.
+ */
+uint32_t i2c_stats_percentile(const I2CHistogram* histogram, double percentile) {
+
+    if (histogram->count == 0) return 0;
+
+    uint64_t target = (uint64_t)(histogram->count * percentile / 100.0 + 0.5);
+    if (target == 0) target = 1;
+
+    uint64_t total = 0;
+    for (uint32_t i = 0 ; i < I2C_STATS_BUCKETS ; ++i) {
+        total += histogram->buckets[i];
+        if (total >= target) {
+            uint32_t top = get_bucket_top(i);
+            return (top < histogram->max_us) ? top : histogram->max_us;
+        }
+    }
+
+    return histogram->max_us;
+}
+
+
+/**
+ * @brief Output a table of counts and latencies for each
+ *        class of command that has been recorded.
+ *
+ * @param stats: The statistics record.
+ * @param out:   The stream to write to.
+ */
+void i2c_stats_print(const I2CStats* stats, FILE* out) {
+
+    fprintf(out, "Command        Count    Mean (us)     p50 (us)     p99 (us)     Max (us)\n");
+    for (uint32_t i = 0 ; i < I2C_STATS_CLASSES ; ++i) {
+        const I2CHistogram* histogram = &stats->histograms[i];
+        if (histogram->count == 0) continue;
+
+        fprintf(out, "%-10s %9" PRIu64 " %12" PRIu64 " %12u %12u %12u\n",
+                class_names[i], histogram->count, histogram->total_us / histogram->count,
+                i2c_stats_percentile(histogram, 50.0), i2c_stats_percentile(histogram, 99.0),
+                histogram->max_us);
+    }
+}
+
+
+/**
+ * @brief Map a command or prefix byte to its class.
+ *
+ * @param command: The command or prefix byte.
+ *
+ * @retval The class, `I2C_STATS_*`.
+ */
+static inline uint32_t get_class(uint8_t command) {
+
+    if (command >= 0xC0) return I2C_STATS_WRITE;
+    if (command >= 0x80) return I2C_STATS_READ;
+
+    switch (command) {
+        case 's': return I2C_STATS_START;
+        case 'p': return I2C_STATS_STOP;
+        case 'w': return I2C_STATS_WRITE;
+        case 'r': return I2C_STATS_READ;
+        case 't': return I2C_STATS_TRANSFER;
+        case 'd':
+        case 'D': return I2C_STATS_SCAN;
+        case '?': return I2C_STATS_INFO;
+        case 'g': return I2C_STATS_GPIO;
+        default:  return I2C_STATS_OTHER;
+    }
+}
+
+
+/**
+ * @brief Find the bucket that counts a latency. Values below 16
+ *        get a bucket each; above that, each power of two is split
+ *        into 16 equal buckets.
+ *
+ * @param value_us: The latency in microseconds.
+ *
+ * @retval The bucket index.
+ */
+static inline uint32_t get_bucket(uint32_t value_us) {
+
+    if (value_us < I2C_STATS_SUB_BUCKETS) return value_us;
+
+    uint32_t exponent = 31 - __builtin_clz(value_us);
+    uint32_t sub_bucket = (value_us >> (exponent - I2C_STATS_SUB_BUCKET_BITS)) & (I2C_STATS_SUB_BUCKETS - 1);
+    return (exponent - I2C_STATS_SUB_BUCKET_BITS + 1) * I2C_STATS_SUB_BUCKETS + sub_bucket;
+}
+
+
+/**
+ * @brief Get the largest latency a bucket counts.
+ *
+ * @param bucket: The bucket index.
+ *
+ * @retval The latency in microseconds.
+ */
+static inline uint32_t get_bucket_top(uint32_t bucket) {
+
+    if (bucket < I2C_STATS_SUB_BUCKETS) return bucket;
+
+    uint32_t exponent = bucket / I2C_STATS_SUB_BUCKETS + I2C_STATS_SUB_BUCKET_BITS - 1;
+    uint32_t sub_bucket = bucket % I2C_STATS_SUB_BUCKETS;
+    uint32_t shift = exponent - I2C_STATS_SUB_BUCKET_BITS;
+    uint64_t bottom = (uint64_t)(I2C_STATS_SUB_BUCKETS + sub_bucket) << shift;
+    uint64_t top = bottom + ((uint64_t)1 << shift) - 1;
+    return (top > UINT32_MAX) ? UINT32_MAX : (uint32_t)top;
+}
+
+
+/**
+ * @brief Get the monotonic time in microseconds.
+ *
+ * @retval The time.
+ */
+static inline uint64_t get_time_us(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
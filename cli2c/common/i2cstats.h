@@ -0,0 +1,76 @@
+/*
+ * Generic macOS I2C driver - Latency Statistics
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#ifndef _I2C_STATS_H
+#define _I2C_STATS_H
+
+
+/*
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*
+ * CONSTANTS
+ */
+// Histogram buckets are log-linear: 16 per power of two, so each
+// bucket is within 1/16 (~6%) of the values it counts. 464 buckets
+// cover latencies of 0 to 2^32 microseconds
+#define I2C_STATS_SUB_BUCKET_BITS       4
+#define I2C_STATS_SUB_BUCKETS           (1 << I2C_STATS_SUB_BUCKET_BITS)
+#define I2C_STATS_BUCKETS               ((32 - I2C_STATS_SUB_BUCKET_BITS + 1) * I2C_STATS_SUB_BUCKETS)
+
+// Command classes
+enum {
+    I2C_STATS_START = 0,                // `s`
+    I2C_STATS_STOP,                     // `p`
+    I2C_STATS_WRITE,                    // Write prefixes and `w`
+    I2C_STATS_READ,                     // Read prefixes and `r`
+    I2C_STATS_TRANSFER,                 // `t`
+    I2C_STATS_SCAN,                     // `d` and `D`
+    I2C_STATS_INFO,                     // `?`
+    I2C_STATS_GPIO,                     // `g`
+    I2C_STATS_OTHER,                    // Everything else
+    I2C_STATS_CLASSES
+};
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint64_t            count;
+    uint64_t            total_us;
+    uint32_t            max_us;
+    uint32_t            buckets[I2C_STATS_BUCKETS];
+} I2CHistogram;
+
+typedef struct {
+    I2CHistogram        histograms[I2C_STATS_CLASSES];
+    uint64_t            last_tx_us;     // When bytes were last written to the port
+    uint8_t             last_command;   // The last frame's command or prefix byte
+} I2CStats;
+
+
+/*
+ * PROTOTYPES
+ */
+I2CStats*       i2c_stats_create(void);
+void            i2c_stats_destroy(I2CStats* stats);
+void            i2c_stats_queued(I2CStats* stats, uint8_t command);
+void            i2c_stats_sent(I2CStats* stats);
+void            i2c_stats_record(I2CStats* stats, uint8_t command);
+void            i2c_stats_add(I2CHistogram* histogram, uint32_t latency_us);
+uint32_t        i2c_stats_percentile(const I2CHistogram* histogram, double percentile);
+void            i2c_stats_print(const I2CStats* stats, FILE* out);
+
+
+#endif  // _I2C_STATS_H
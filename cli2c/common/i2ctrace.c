@@ -0,0 +1,299 @@
+/*
+ * Generic macOS I2C driver - Transaction Tracing
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "i2ctrace.h"
+#include "utils.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static I2CTraceRecord*      next_record(I2CTrace* trace, uint64_t now_us);
+static const char*          get_command_name(uint8_t command, char* name);
+static inline uint64_t      get_time_us(void);
+
+
+/**
+ * @brief Create a trace file and map it into memory. Records are
+ *        written straight to the mapping, so tracing costs a clock
+ *        read and a 24-byte store per frame; once the file is full,
+ *        the oldest records are overwritten.
+ *
+ * @param path:     The trace file's path. Any existing file is replaced.
+ * @param capacity: The number of records to keep, or 0 for the default.
+ *
+ * @retval The trace, or NULL on error.
+ */
+I2CTrace* i2c_trace_open(const char* path, uint32_t capacity) {
+
+    if (capacity == 0) capacity = I2C_TRACE_RECORDS_DEFAULT;
+    size_t map_size = sizeof(I2CTraceHeader) + (size_t)capacity * sizeof(I2CTraceRecord);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        print_error("Could not open trace file %s - %s (%d)", path, strerror(errno), errno);
+        return NULL;
+    }
+
+    if (ftruncate(fd, map_size) == -1) {
+        print_error("Could not size trace file %s - %s (%d)", path, strerror(errno), errno);
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        print_error("Could not map trace file %s - %s (%d)", path, strerror(errno), errno);
+        close(fd);
+        return NULL;
+    }
+
+    I2CTrace* trace = calloc(1, sizeof(I2CTrace));
+    if (trace == NULL) {
+        munmap(map, map_size);
+        close(fd);
+        return NULL;
+    }
+
+    trace->fd = fd;
+    trace->map_size = map_size;
+    trace->header = (I2CTraceHeader*)map;
+    trace->records = (I2CTraceRecord*)((uint8_t*)map + sizeof(I2CTraceHeader));
+
+    memcpy(trace->header->magic, I2C_TRACE_MAGIC, sizeof(trace->header->magic));
+    trace->header->version = I2C_TRACE_VERSION;
+    trace->header->record_size = sizeof(I2CTraceRecord);
+    trace->header->capacity = capacity;
+    trace->header->start_us = get_time_us();
+    return trace;
+}
+
+
+/**
+ * @brief Unmap and close a trace file.
+ *
+ * @param trace: The trace.
+ */
+void i2c_trace_close(I2CTrace* trace) {
+
+    if (trace == NULL) return;
+    msync(trace->header, trace->map_size, MS_ASYNC);
+    munmap(trace->header, trace->map_size);
+    close(trace->fd);
+    free(trace);
+}
+
+
+/**
+ * @brief Record a frame queued for the bus host.
+ *
+ * @param trace:   The trace.
+ * @param command: The frame's command or prefix byte.
+ * @param length:  The frame's length in bytes.
+ */
+void i2c_trace_tx(I2CTrace* trace, uint8_t command, size_t length) {
+
+    I2CTraceRecord* record = next_record(trace, get_time_us());
+    record->direction = I2C_TRACE_DIR_TX;
+    record->command = command;
+    record->length = (uint16_t)length;
+    trace->last_command = command;
+}
+
+
+/**
+ * @brief Note that queued frames have been written to the port:
+ *        response latencies are measured from this point.
+ *
+ * @param trace: The trace.
+ */
+void i2c_trace_sent(I2CTrace* trace) {
+
+    trace->last_tx_us = get_time_us();
+}
+
+
+/**
+ * @brief Record a response read from the bus host.
+ *
+ * @param trace:   The trace.
+ * @param command: The command or prefix byte of the frame that
+ *                 prompted the response, or 0 for the last frame queued.
+ * @param length:  The number of bytes read.
+ * @param status:  I2C_TRACE_STATUS_NONE, or I2C_TRACE_STATUS_TIMEOUT.
+ */
+void i2c_trace_rx(I2CTrace* trace, uint8_t command, size_t length, uint8_t status) {
+
+    uint64_t now_us = get_time_us();
+    I2CTraceRecord* record = next_record(trace, now_us);
+    record->direction = I2C_TRACE_DIR_RX;
+    record->command = (command != 0) ? command : trace->last_command;
+    record->length = (uint16_t)length;
+    record->status = status;
+    record->latency_us = (trace->last_tx_us > 0 && now_us > trace->last_tx_us) ? (uint32_t)(now_us - trace->last_tx_us) : 0;
+}
+
+
+/**
+ * @brief Mark the last response recorded as an ACK or ERR, once
+ *        the driver has interpreted it.
+ *
+ * @param trace:  The trace.
+ * @param status: I2C_TRACE_STATUS_ACK or I2C_TRACE_STATUS_ERR.
+ */
+void i2c_trace_set_status(I2CTrace* trace, uint8_t status) {
+
+    uint64_t count = trace->header->count;
+    if (count == 0) return;
+    I2CTraceRecord* record = &trace->records[(count - 1) % trace->header->capacity];
+    if (record->direction == I2C_TRACE_DIR_RX) record->status = status;
+}
+
+
+/**
+ * @brief Write a trace file's records as Chrome trace JSON, for
+ *        viewing in Perfetto or `chrome://tracing`. Frames sent are
+ *        instant events; responses are spans covering their latency.
+ *
+ * @param path: The trace file's path.
+ * @param out:  The stream to write the JSON to.
+ *
+ * @retval Whether the trace was exported (`true`) or not (`false`).
+ */
+bool i2c_trace_export(const char* path, FILE* out) {
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        print_error("Could not open trace file %s - %s (%d)", path, strerror(errno), errno);
+        return false;
+    }
+
+    struct stat info;
+    I2CTraceHeader header;
+    if (fstat(fd, &info) == -1 || read(fd, &header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, I2C_TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != I2C_TRACE_VERSION || header.record_size != sizeof(I2CTraceRecord) ||
+        header.capacity == 0 ||
+        (size_t)info.st_size < sizeof(I2CTraceHeader) + (size_t)header.capacity * sizeof(I2CTraceRecord)) {
+        print_error("%s is not a trace file", path);
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        print_error("Could not map trace file %s - %s (%d)", path, strerror(errno), errno);
+        return false;
+    }
+
+    static const char* status_names[] = {"none", "ACK", "ERR", "timeout"};
+    const I2CTraceRecord* records = (const I2CTraceRecord*)((uint8_t*)map + sizeof(I2CTraceHeader));
+    uint64_t first = (header.count > header.capacity) ? header.count - header.capacity : 0;
+    char name[16];
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Frames sent\"}},\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"Responses\"}}");
+
+    for (uint64_t i = first ; i < header.count ; ++i) {
+        const I2CTraceRecord* record = &records[i % header.capacity];
+        get_command_name(record->command, name);
+
+        if (record->direction == I2C_TRACE_DIR_TX) {
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"tx\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%" PRIu64 ",\"pid\":1,\"tid\":1,\"args\":{\"length\":%u}}",
+                    name, record->timestamp_us, record->length);
+        } else {
+            uint64_t start_us = (record->timestamp_us > record->latency_us) ? record->timestamp_us - record->latency_us : 0;
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"rx\",\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%u,\"pid\":1,\"tid\":2,\"args\":{\"length\":%u,\"status\":\"%s\"}}",
+                    name, start_us, record->latency_us, record->length, status_names[record->status & 0x03]);
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+    munmap(map, info.st_size);
+    return true;
+}
+
+
+/**
+ * @brief Claim the next record slot, overwriting the oldest
+ *        record if the trace is full.
+ *
+ * @param trace:  The trace.
+ * @param now_us: The current monotonic time.
+ *
+ * @retval The cleared record, with its timestamp set.
+ */
+static I2CTraceRecord* next_record(I2CTrace* trace, uint64_t now_us) {
+
+    I2CTraceRecord* record = &trace->records[trace->header->count % trace->header->capacity];
+    memset(record, 0, sizeof(I2CTraceRecord));
+    record->timestamp_us = now_us - trace->header->start_us;
+    trace->header->count++;
+    return record;
+}
+
+
+/**
+ * @brief Name a frame by its command or prefix byte.
+ *
+ * @param command: The command or prefix byte.
+ * @param name:    A buffer of at least 16 bytes for the name.
+ *
+ * @retval The name.
+ */
+static const char* get_command_name(uint8_t command, char* name) {
+
+    if (command >= 0xC0) {
+        sprintf(name, "write %u", command - 0xC0 + 1);
+    } else if (command >= 0x80) {
+        sprintf(name, "read %u", command - 0x80 + 1);
+    } else {
+        switch (command) {
+            case 's': return strcpy(name, "start");
+            case 'p': return strcpy(name, "stop");
+            case 'w': return strcpy(name, "long write");
+            case 'r': return strcpy(name, "long read");
+            case 't': return strcpy(name, "transfer");
+            case 'd': return strcpy(name, "scan");
+            case 'D': return strcpy(name, "bitmap scan");
+            case '?': return strcpy(name, "info");
+            case 0:   return strcpy(name, "none");
+            default:
+                if (command >= 0x20 && command < 0x7F && command != '"' && command != '\\') {
+                    sprintf(name, "cmd %c", command);
+                } else {
+                    sprintf(name, "cmd 0x%02X", command);
+                }
+        }
+    }
+
+    return name;
+}
+
+
+/**
+ * @brief Get the monotonic time in microseconds.
+ *
+ * @retval The time.
+ */
+static inline uint64_t get_time_us(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
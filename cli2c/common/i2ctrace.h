@@ -0,0 +1,92 @@
+/*
+ * Generic macOS I2C driver - Transaction Tracing
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#ifndef _I2C_TRACE_H
+#define _I2C_TRACE_H
+
+
+/*
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+
+/*
+ * CONSTANTS
+ */
+// Set this environment variable to a file path to trace every connection.
+// Each connection writes `{path}.{pid}.{index}`
+#define I2C_TRACE_ENV_VAR               "CLI2C_TRACE"
+
+#define I2C_TRACE_MAGIC                 "CLI2CTRC"
+#define I2C_TRACE_VERSION               1
+#define I2C_TRACE_RECORDS_DEFAULT       65536
+
+// Record directions
+#define I2C_TRACE_DIR_TX                0
+#define I2C_TRACE_DIR_RX                1
+
+// Record status values
+#define I2C_TRACE_STATUS_NONE           0       // TX, or RX that isn't an ACK
+#define I2C_TRACE_STATUS_ACK            1
+#define I2C_TRACE_STATUS_ERR            2
+#define I2C_TRACE_STATUS_TIMEOUT        3
+
+
+/*
+ * STRUCTURES
+ */
+// One frame sent to, or one response read from, the bus host: 24 bytes
+typedef struct {
+    uint64_t            timestamp_us;   // Microseconds since the trace was opened
+    uint32_t            latency_us;     // RX only: microseconds since the last write to the port
+    uint16_t            length;         // Bytes in the frame or response
+    uint8_t             direction;      // I2C_TRACE_DIR_*
+    uint8_t             command;        // The frame's command or prefix byte. RX: that of the frame responded to
+    uint8_t             status;         // I2C_TRACE_STATUS_*
+    uint8_t             reserved[7];
+} I2CTraceRecord;
+
+// The start of a trace file, followed by `capacity` records: 64 bytes
+typedef struct {
+    char                magic[8];       // I2C_TRACE_MAGIC, unterminated
+    uint32_t            version;        // I2C_TRACE_VERSION
+    uint32_t            record_size;    // sizeof(I2CTraceRecord)
+    uint32_t            capacity;       // The number of record slots
+    uint32_t            reserved0;
+    uint64_t            count;          // Records ever written: the next goes in slot `count % capacity`
+    uint64_t            start_us;       // Monotonic time when the trace was opened
+    uint8_t             reserved[24];
+} I2CTraceHeader;
+
+typedef struct {
+    int                 fd;
+    I2CTraceHeader*     header;         // The mapped file
+    I2CTraceRecord*     records;
+    size_t              map_size;
+    uint64_t            last_tx_us;     // When bytes were last written to the port
+    uint8_t             last_command;   // The last frame's command or prefix byte
+} I2CTrace;
+
+
+/*
+ * PROTOTYPES
+ */
+I2CTrace*       i2c_trace_open(const char* path, uint32_t capacity);
+void            i2c_trace_close(I2CTrace* trace);
+void            i2c_trace_tx(I2CTrace* trace, uint8_t command, size_t length);
+void            i2c_trace_sent(I2CTrace* trace);
+void            i2c_trace_rx(I2CTrace* trace, uint8_t command, size_t length, uint8_t status);
+void            i2c_trace_set_status(I2CTrace* trace, uint8_t status);
+bool            i2c_trace_export(const char* path, FILE* out);
+
+
+#endif  // _I2C_TRACE_H
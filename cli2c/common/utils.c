@@ -7,10 +7,25 @@
  *
  */
 #include "utils.h"
+#include <sys/stat.h>
 
 
-// Declared in each app's main.c
-extern I2CDriver i2c;
+/*
+ * STATIC PROTOTYPES
+ */
+// FROM 1.2.0
+static int split_line(char* line, char* args[], int max_args);
+static bool parse_frame_line(char* line, uint8_t* frame, size_t frame_size);
+static bool wait_for_input(int fd, int64_t wait_us);
+
+
+/*
+ * GLOBALS
+ */
+// FROM 1.2.0
+// Set by the host app, rather than reached into
+static I2CDriver* ctrl_c_driver = NULL;
+static LogHandler log_handler = NULL;
 
 
 /**
@@ -82,24 +97,392 @@ void print_output(uint32_t type, char* format_string, va_list args) {
     }
 
     // Write the formatted text to the message
-    vsnprintf(&buffer[delta], sizeof(buffer) - delta + 1, format_string, args);
+    vsnprintf(&buffer[delta], sizeof(buffer) - delta, format_string, args);
+
+    // FROM 1.2.0 -- Pass it to the host's handler, if it has one
+    if (log_handler != NULL) {
+        log_handler(type, buffer);
+        return;
+    }
 
     // Print it all out
     fprintf(stderr, "%s\n", buffer);
 }
 
 
+/**
+ * @brief Route messages to a function of the host's choosing,
+ *        rather than to stderr, eg. when the driver is used as a
+ *        library. Pass NULL to restore the default.
+ *        FROM 1.2.0
+ *
+ * @param handler: The function to call with each message.
+ */
+void set_log_handler(LogHandler handler) {
+
+    log_handler = handler;
+}
+
+
 /**
  * @brief Callback for Ctrl-C.
  */
 void ctrl_c_handler(int dummy) {
 
-    if (i2c.port != -1) flush_and_close_port(i2c.port);
+    if (ctrl_c_driver != NULL) flush_and_close_port(ctrl_c_driver);
     fprintf(stderr, "\n");
     exit(EXIT_OK);
 }
 
 
+/**
+ * @brief Listen for Ctrl-C, and close the specified
+ *        connection's port when it's received.
+ *        FROM 1.2.0
+ *
+ * @param sd: Pointer to an I2CDriver structure.
+ */
+void set_ctrl_c_handler(I2CDriver* sd) {
+
+    ctrl_c_driver = sd;
+    signal(SIGINT, ctrl_c_handler);
+}
+
+
+/**
+ * @brief Run commands read line by line from a script file or stdin,
+ *        all over the current connection. Each line is processed
+ *        as if its contents were passed as command line arguments.
+ *        Lines starting with `#` are ignored.
+ *        FROM 1.2.0
+ *
+ * @param sd:      Pointer to an I2CDriver structure.
+ * @param path:    Path to the script file, or `NULL` for stdin.
+ * @param handler: The app's command processor.
+ *
+ * @retval The exit code: 0 if every line succeeded, otherwise 1.
+ */
+int process_script(I2CDriver* sd, const char* path, CommandHandler handler) {
+
+    FILE* source = stdin;
+    if (path != NULL) {
+        source = fopen(path, "r");
+        if (source == NULL) {
+            print_error("Could not open script %s - %s (%d)", path, strerror(errno), errno);
+            return EXIT_ERR;
+        }
+    }
+
+    char* line = NULL;
+    size_t line_size = 0;
+    int result = EXIT_OK;
+
+    while (getline(&line, &line_size, source) != -1) {
+        char* args[SCRIPT_ARGS_MAX];
+        int arg_count = split_line(line, args, SCRIPT_ARGS_MAX);
+        if (arg_count == 0) continue;
+
+        if (arg_count < 0) {
+            print_error("Too many arguments in script line");
+            result = EXIT_ERR;
+            continue;
+        }
+
+        if (handler(sd, arg_count, args, 0) != EXIT_OK) result = EXIT_ERR;
+
+        // Make each line's output available to the caller right away
+        fflush(stdout);
+    }
+
+    free(line);
+    if (source != stdin) fclose(source);
+    return result;
+}
+
+
+/**
+ * @brief Display frames read from stdin at a fixed rate, all over
+ *        the current connection. Frames are paced off monotonic
+ *        deadlines. If frames arrive from a pipe faster than they can
+ *        be shown, only the latest is shown and the rest are dropped;
+ *        frames redirected from a file are all shown, in turn. Frames
+ *        are raw bytes or, if `is_binary` is false, lines of text.
+ *        Lines that are empty or start with `#` are ignored.
+ *        FROM 1.2.0
+ *
+ * @param sd:         Pointer to an I2CDriver structure.
+ * @param frame_size: The number of bytes in a frame.
+ * @param fps:        The frame rate, or 0 to show frames as fast as the bus allows.
+ * @param is_binary:  Whether frames are raw bytes (`true`) or lines of text.
+ * @param parser:     The app's line reader, or NULL for lines of comma-separated
+ *                    values, eg. `0x3C,0x42,0xA9,0x85,0x85,0xA9,0x42,0x3C`.
+ * @param handler:    The app's frame renderer.
+ *
+ * @retval The exit code: 0 if every frame was shown, otherwise 1.
+ */
+int process_stream(I2CDriver* sd, size_t frame_size, uint32_t fps, bool is_binary, FrameParser parser, FrameHandler handler) {
+
+    if (frame_size == 0 || frame_size > STREAM_FRAME_MAX_B) {
+        print_error("Stream frame size out of range (1-%i)", STREAM_FRAME_MAX_B);
+        return EXIT_ERR;
+    }
+
+    struct stat info;
+    bool is_file = (fstat(STDIN_FILENO, &info) == 0 && S_ISREG(info.st_mode));
+
+    uint8_t read_buffer[STREAM_READ_BUFFER_B];
+    size_t read_start = 0;
+    size_t read_count = 0;
+    char line[STREAM_LINE_MAX_B];
+    size_t line_length = 0;
+    uint8_t frame[STREAM_FRAME_MAX_B];
+    size_t frame_length = 0;
+    uint8_t latest[STREAM_FRAME_MAX_B];
+    bool has_frame = false;
+    bool is_eof = false;
+    uint64_t frames_read = 0;
+    uint64_t frames_shown = 0;
+    uint64_t frames_late = 0;
+    uint64_t period_us = (fps > 0) ? 1000000 / fps : 0;
+    uint64_t deadline_us = get_monotonic_us();
+    int result = EXIT_OK;
+    if (parser == NULL) parser = parse_frame_line;
+
+    while (1) {
+        // Extract frames from the input read so far: the latest
+        // replaces any not yet shown -- unless it's from a file
+        while (read_start < read_count && !(is_file && has_frame)) {
+            uint8_t byte = read_buffer[read_start++];
+            if (is_binary) {
+                frame[frame_length++] = byte;
+                if (frame_length < frame_size) continue;
+                frame_length = 0;
+            } else {
+                if (byte != '\n') {
+                    if (line_length < sizeof(line) - 1) line[line_length++] = (char)byte;
+                    continue;
+                }
+
+                // Trim the line, and skip blanks and comments
+                while (line_length > 0 && isspace((unsigned char)line[line_length - 1])) line_length--;
+                line[line_length] = '\0';
+                line_length = 0;
+
+                char* start = line;
+                while (*start == ' ' || *start == '\t') start++;
+                if (*start == '\0' || *start == '#') continue;
+                if (!parser(start, frame, frame_size)) continue;
+            }
+
+            memcpy(latest, frame, frame_size);
+            has_frame = true;
+            frames_read++;
+        }
+
+        // Read more input: wait indefinitely if there's no frame to
+        // show, otherwise until the frame is due. Once it is, take
+        // any input already waiting, so the newest frame is shown
+        if (read_start == read_count && !is_eof && !(is_file && has_frame)) {
+            uint64_t now_us = get_monotonic_us();
+            int64_t wait_us = !has_frame ? -1 : (deadline_us > now_us ? (int64_t)(deadline_us - now_us) : 0);
+            if (wait_for_input(STDIN_FILENO, wait_us)) {
+                ssize_t count = read(STDIN_FILENO, read_buffer, sizeof(read_buffer));
+                if (count == -1 && errno == EINTR) continue;
+                if (count <= 0) {
+                    is_eof = true;
+                } else {
+                    read_start = 0;
+                    read_count = (size_t)count;
+                }
+
+                continue;
+            }
+        }
+
+        if (!has_frame) {
+            if (is_eof) break;
+            continue;
+        }
+
+        // With no input to wait for, sleep until the frame is due
+        uint64_t now_us = get_monotonic_us();
+        if (now_us < deadline_us) {
+            sleep_until_us(deadline_us);
+            continue;
+        }
+
+        // Show the frame, and set when the next one is due. This is
+        // paced off the last deadline, not the time now, so the rate
+        // doesn't drift. If showing the frame overran one or more
+        // periods, skip them rather than rush to catch up
+        if (!handler(sd, latest)) result = EXIT_ERR;
+        has_frame = false;
+        frames_shown++;
+
+        if (period_us > 0) {
+            deadline_us += period_us;
+            now_us = get_monotonic_us();
+            if (now_us > deadline_us) {
+                deadline_us += ((now_us - deadline_us) / period_us + 1) * period_us;
+                frames_late++;
+            }
+        }
+    }
+
+    print_log("Frames: %" PRIu64 " read, %" PRIu64 " shown, %" PRIu64 " dropped, %" PRIu64 " late",
+              frames_read, frames_shown, frames_read - frames_shown, frames_late);
+    return result;
+}
+
+
+/**
+ * @brief Parse a line of comma-separated values into a frame.
+ *        Short frames are padded with zeros.
+ *        FROM 1.2.0
+ *
+ * @param line:       The line.
+ * @param frame:      A buffer for the frame.
+ * @param frame_size: The number of bytes in a frame.
+ *
+ * @retval Whether the line holds a frame (`true`) or not (`false`).
+ */
+static bool parse_frame_line(char* line, uint8_t* frame, size_t frame_size) {
+
+    char* cursor = line;
+    size_t length = 0;
+    memset(frame, 0, frame_size);
+    while (length < frame_size) {
+        char* endptr = cursor;
+        frame[length++] = (uint8_t)strtol(cursor, &endptr, 0);
+        if (endptr == cursor) break;
+        cursor = endptr;
+        while (*cursor == ' ' || *cursor == '\t') cursor++;
+        if (*cursor != ',') break;
+        cursor++;
+    }
+
+    if (*cursor != '\0') {
+        print_warning("Invalid frame: %s", line);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Wait for a file descriptor to become readable.
+ *        FROM 1.2.0
+ *
+ * @param fd:      The file descriptor.
+ * @param wait_us: The maximum time to wait, or -1 to wait indefinitely.
+ *
+ * @retval Whether the descriptor is readable (`true`) or the time ran out (`false`).
+ */
+static bool wait_for_input(int fd, int64_t wait_us) {
+
+    int result;
+#ifdef BUILD_FOR_LINUX
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    struct timespec timeout = {.tv_sec = wait_us / 1000000, .tv_nsec = (wait_us % 1000000) * 1000};
+    result = ppoll(&pfd, 1, (wait_us < 0 ? NULL : &timeout), NULL);
+#else
+    fd_set read_set;
+    FD_ZERO(&read_set);
+    FD_SET(fd, &read_set);
+    struct timeval timeout = {.tv_sec = wait_us / 1000000, .tv_usec = wait_us % 1000000};
+    result = select(fd + 1, &read_set, NULL, NULL, (wait_us < 0 ? NULL : &timeout));
+#endif
+
+    // Treat errors other than signals as input, so that the
+    // caller's read() reports them
+    if (result == -1 && errno == EINTR) return false;
+    return (result != 0);
+}
+
+
+/**
+ * @brief Get the monotonic time, as used by `sleep_until_us()`.
+ *        FROM 1.2.0
+ *
+ * @retval The time in microseconds.
+ */
+uint64_t get_monotonic_us(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+
+/**
+ * @brief Sleep until an absolute monotonic time. Sleeping to a
+ *        deadline, rather than for a period, means time spent
+ *        between sleeps doesn't accumulate as drift.
+ *        FROM 1.2.0
+ *
+ * @param deadline_us: The time to wake, from `get_monotonic_us()`.
+ */
+void sleep_until_us(uint64_t deadline_us) {
+
+#ifdef BUILD_FOR_LINUX
+    struct timespec deadline = {.tv_sec = deadline_us / 1000000, .tv_nsec = (deadline_us % 1000000) * 1000};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+#else
+    // NOTE macOS has no clock_nanosleep(), so sleep for the time
+    //      remaining, and again if woken early
+    uint64_t now_us = get_monotonic_us();
+    while (now_us < deadline_us) {
+        struct timespec pause = {.tv_sec = (deadline_us - now_us) / 1000000, .tv_nsec = ((deadline_us - now_us) % 1000000) * 1000};
+        nanosleep(&pause, NULL);
+        now_us = get_monotonic_us();
+    }
+#endif
+}
+
+
+/**
+ * @brief Split a line into whitespace-separated arguments, in place.
+ *        Arguments may be wrapped in single or double quotes.
+ *        FROM 1.2.0
+ *
+ * @param line:     The line to split. It will be modified.
+ * @param args:     An array to hold pointers to the arguments.
+ * @param max_args: The size of the array.
+ *
+ * @retval The number of arguments, or -1 if there are too many.
+ */
+static int split_line(char* line, char* args[], int max_args) {
+
+    int arg_count = 0;
+    char* cursor = line;
+
+    while (1) {
+        // Skip leading whitespace, and stop at the end of the line
+        // or at the start of a comment line
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n') cursor++;
+        if (*cursor == '\0' || (*cursor == '#' && arg_count == 0)) break;
+        if (arg_count == max_args) return -1;
+
+        // Mark the start of the argument
+        char quote = '\0';
+        if (*cursor == '"' || *cursor == '\'') quote = *cursor++;
+        args[arg_count++] = cursor;
+
+        // Find its end
+        while (*cursor != '\0') {
+            if (quote != '\0' ? (*cursor == quote) : (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n')) break;
+            cursor++;
+        }
+
+        if (*cursor == '\0') break;
+        *cursor++ = '\0';
+    }
+
+    return arg_count;
+}
+
+
 /**
  * @brief Convert a string to lowercase.
  *
@@ -13,8 +13,9 @@
 /*
  * INCLUDES
  */
-#include <signal.h>
+// FROM 1.2.0 -- i2cdriver.h first, for its feature macros
 #include "i2cdriver.h"
+#include <signal.h>
 
 
 /*
@@ -25,6 +26,33 @@
 #define LOG_TYPE_ERROR              1
 #define LOG_TYPE_WARNING            2
 
+// FROM 1.2.0
+#define SCRIPT_ARGS_MAX             256
+#define STREAM_FPS_DEFAULT          25
+#define STREAM_FRAME_MAX_B          64
+#define STREAM_LINE_MAX_B           1024
+#define STREAM_READ_BUFFER_B        4096
+
+
+/*
+ * STRUCTURES
+ */
+// FROM 1.2.0
+// An app's command processor, eg. `process_commands()`
+typedef int (*CommandHandler)(I2CDriver* sd, int argc, char* argv[], int delta);
+
+// FROM 1.2.0
+// A receiver for messages, eg. in code using the driver as a library
+typedef void (*LogHandler)(uint32_t type, const char* message);
+
+// FROM 1.2.0
+// An app's frame renderer: display one frame from a stream
+typedef bool (*FrameHandler)(I2CDriver* sd, const uint8_t* frame);
+
+// FROM 1.2.0
+// An app's stream reader: convert one line of text into a frame
+typedef bool (*FrameParser)(char* line, uint8_t* frame, size_t frame_size);
+
 
 /*
  * PROTOTYPES
@@ -34,7 +62,15 @@ void    print_error(char* format_string, ...);
 void    print_log(char* format_string, ...);
 void    print_output(uint32_t type, char* format_string, va_list args);
 void    ctrl_c_handler(int dummy);
+// FROM 1.2.0
+void    set_ctrl_c_handler(I2CDriver* sd);
+void    set_log_handler(LogHandler handler);
 void    lower(char* s);
+// FROM 1.2.0
+int     process_script(I2CDriver* sd, const char* path, CommandHandler handler);
+int     process_stream(I2CDriver* sd, size_t frame_size, uint32_t fps, bool is_binary, FrameParser parser, FrameHandler handler);
+uint64_t get_monotonic_us(void);
+void    sleep_until_us(uint64_t deadline_us);
 
 
 #endif  // _UTILS_H
@@ -0,0 +1,783 @@
+/*
+ * HT16K33 8x8 matrix driver - Fonts
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static HT16K33Font* parse_font(uint8_t* data, size_t length, const char* path);
+static bool         parse_bdf(char* text, uint8_t glyphs[][HT16K33_FONT_WIDTH_MAX], uint8_t* widths, uint8_t* height);
+static bool         parse_psf(const uint8_t* data, size_t length, uint8_t glyphs[][HT16K33_FONT_WIDTH_MAX], uint8_t* widths, uint8_t* height);
+static void         map_psf_glyphs(const uint8_t* table, const uint8_t* end, uint32_t count, bool is_psf2, int32_t* map);
+static void         trim_glyph(const uint8_t* columns, uint32_t count, uint8_t* glyph, uint8_t* width);
+static HT16K33Font* pack_font(uint8_t glyphs[][HT16K33_FONT_WIDTH_MAX], const uint8_t* widths, uint8_t height);
+static HT16K33Font* alloc_font(uint32_t count, uint32_t column_count, uint16_t** offsets, uint8_t** widths, uint8_t** columns);
+static uint8_t*     read_file(const char* path, size_t* length);
+static bool         get_cache_path(const char* path, char* cache_path, size_t size);
+static HT16K33Font* read_cache(const char* cache_path, const struct stat* info);
+static void         write_cache(const char* cache_path, const struct stat* info, const HT16K33Font* font);
+static inline uint32_t get_u32(const uint8_t* data);
+
+
+/*
+ * GLOBALS
+ */
+// The built-in font: Ascii 32-127. Columns run from the left of each
+// glyph, with bit 0 the bottom row. The tables were generated from the
+// font's source glyphs, so keep them in step if the glyphs change
+static const uint8_t DEFAULT_COLUMNS[] = {
+    0x00,                               // space
+    0xFA,                               // !
+    0xC0, 0x00, 0xC0,                   // "
+    0x24, 0x7E, 0x24, 0x7E, 0x24,       // #
+    0x24, 0xD4, 0x56, 0x48,             // $
+    0xC6, 0xC8, 0x10, 0x26, 0xC6,       // %
+    0x6C, 0x92, 0x6A, 0x04, 0x0A,       // &
+    0xC0,                               // '
+    0x7C, 0x82,                         // (
+    0x82, 0x7C,                         // )
+    0x10, 0x7C, 0x38, 0x7C, 0x10,       // *
+    0x10, 0x10, 0x7C, 0x10, 0x10,       // +
+    0x06, 0x07,                         // ,
+    0x10, 0x10, 0x10, 0x10,             // -
+    0x06, 0x06,                         // .
+    0x04, 0x08, 0x10, 0x20, 0x40,       // /
+    0x7C, 0x8A, 0x92, 0xA2, 0x7C,       // 0
+    0x42, 0xFE, 0x02,                   // 1
+    0x46, 0x8A, 0x92, 0x92, 0x62,       // 2
+    0x44, 0x92, 0x92, 0x92, 0x6C,       // 3
+    0x18, 0x28, 0x48, 0xFE, 0x08,       // 4
+    0xF4, 0x92, 0x92, 0x92, 0x8C,       // 5
+    0x3C, 0x52, 0x92, 0x92, 0x8C,       // 6
+    0x80, 0x8E, 0x90, 0xA0, 0xC0,       // 7
+    0x6C, 0x92, 0x92, 0x92, 0x6C,       // 8
+    0x60, 0x92, 0x92, 0x94, 0x78,       // 9
+    0x36, 0x36,                         // :
+    0x36, 0x37,                         // ;
+    0x10, 0x28, 0x44, 0x82,             // <
+    0x24, 0x24, 0x24, 0x24, 0x24,       // =
+    0x82, 0x44, 0x28, 0x10,             // >
+    0x60, 0x80, 0x9A, 0x90, 0x60,       // ?
+    0x7C, 0x82, 0xBA, 0xAA, 0x78,       // @
+    0x7E, 0x90, 0x90, 0x90, 0x7E,       // A
+    0xFE, 0x92, 0x92, 0x92, 0x6C,       // B
+    0x7C, 0x82, 0x82, 0x82, 0x44,       // C
+    0xFE, 0x82, 0x82, 0x82, 0x7C,       // D
+    0xFE, 0x92, 0x92, 0x92, 0x82,       // E
+    0xFE, 0x90, 0x90, 0x90, 0x80,       // F
+    0x7C, 0x82, 0x92, 0x92, 0x5C,       // G
+    0xFE, 0x10, 0x10, 0x10, 0xFE,       // H
+    0x82, 0xFE, 0x82,                   // I
+    0x0C, 0x02, 0x02, 0x02, 0xFC,       // J
+    0xFE, 0x10, 0x28, 0x44, 0x82,       // K
+    0xFE, 0x02, 0x02, 0x02,             // L
+    0xFE, 0x40, 0x20, 0x40, 0xFE,       // M
+    0xFE, 0x40, 0x20, 0x10, 0xFE,       // N
+    0x7C, 0x82, 0x82, 0x82, 0x7C,       // O
+    0xFE, 0x90, 0x90, 0x90, 0x60,       // P
+    0x7C, 0x82, 0x92, 0x8C, 0x7A,       // Q
+    0xFE, 0x90, 0x90, 0x98, 0x66,       // R
+    0x64, 0x92, 0x92, 0x92, 0x4C,       // S
+    0x80, 0x80, 0xFE, 0x80, 0x80,       // T
+    0xFC, 0x02, 0x02, 0x02, 0xFC,       // U
+    0xF8, 0x04, 0x02, 0x04, 0xF8,       // V
+    0xFC, 0x02, 0x3C, 0x02, 0xFC,       // W
+    0xC6, 0x28, 0x10, 0x28, 0xC6,       // X
+    0xE0, 0x10, 0x0E, 0x10, 0xE0,       // Y
+    0x86, 0x8A, 0x92, 0xA2, 0xC2,       // Z
+    0xFE, 0x82, 0x82,                   // [
+    0x40, 0x20, 0x10, 0x08, 0x04,       // backslash
+    0x82, 0x82, 0xFE,                   // ]
+    0x20, 0x40, 0x80, 0x40, 0x20,       // ^
+    0x02, 0x02, 0x02, 0x02, 0x02,       // _
+    0xC0, 0xE0,                         // `
+    0x04, 0x2A, 0x2A, 0x1E,             // a
+    0xFE, 0x22, 0x22, 0x1C,             // b
+    0x1C, 0x22, 0x22, 0x22,             // c
+    0x1C, 0x22, 0x22, 0xFC,             // d
+    0x1C, 0x2A, 0x2A, 0x10,             // e
+    0x10, 0x7E, 0x90, 0x80,             // f
+    0x18, 0x25, 0x25, 0x3E,             // g
+    0xFE, 0x20, 0x20, 0x1E,             // h
+    0xBC, 0x02,                         // i
+    0x02, 0x01, 0x21, 0xBE,             // j
+    0xFE, 0x08, 0x14, 0x22,             // k
+    0xFC, 0x02,                         // l
+    0x3E, 0x20, 0x18, 0x20, 0x1E,       // m
+    0x3E, 0x20, 0x20, 0x20, 0x1E,       // n
+    0x1C, 0x22, 0x22, 0x1C,             // o
+    0x3F, 0x22, 0x22, 0x1C,             // p
+    0x1C, 0x22, 0x22, 0x3F,             // q
+    0x22, 0x1E, 0x20, 0x10,             // r
+    0x12, 0x2A, 0x2A, 0x04,             // s
+    0x20, 0x7C, 0x22, 0x04,             // t
+    0x3C, 0x02, 0x02, 0x3E,             // u
+    0x38, 0x04, 0x02, 0x04, 0x38,       // v
+    0x3C, 0x06, 0x0C, 0x06, 0x3C,       // w
+    0x22, 0x14, 0x08, 0x14, 0x22,       // x
+    0x39, 0x05, 0x06, 0x3C,             // y
+    0x26, 0x2A, 0x2A, 0x32,             // z
+    0x10, 0x7C, 0x82, 0x82,             // {
+    0xEE,                               // |
+    0x82, 0x82, 0x7C, 0x10,             // }
+    0x40, 0x80, 0x40, 0x80,             // ~
+    0x60, 0x90, 0x90, 0x60,             // degrees sign
+};
+
+static const uint8_t DEFAULT_WIDTHS[] = {
+    1, 1, 3, 5, 4, 5, 5, 1, 2, 2, 5, 5, 2, 4, 2, 5,
+    5, 3, 5, 5, 5, 5, 5, 5, 5, 5, 2, 2, 4, 5, 4, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 3, 5, 5, 4, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 3, 5, 3, 5, 5,
+    2, 4, 4, 4, 4, 4, 4, 4, 4, 2, 4, 4, 2, 5, 5, 4,
+    4, 4, 4, 4, 4, 4, 5, 5, 5, 4, 4, 4, 1, 4, 4, 4,
+};
+
+static const uint16_t DEFAULT_OFFSETS[] = {
+      0,   1,   2,   5,  10,  14,  19,  24,  25,  27,  29,  34,
+     39,  41,  45,  47,  52,  57,  60,  65,  70,  75,  80,  85,
+     90,  95, 100, 102, 104, 108, 113, 117, 122, 127, 132, 137,
+    142, 147, 152, 157, 162, 167, 170, 175, 180, 184, 189, 194,
+    199, 204, 209, 214, 219, 224, 229, 234, 239, 244, 249, 254,
+    257, 262, 265, 270, 275, 277, 281, 285, 289, 293, 297, 301,
+    305, 309, 311, 315, 319, 321, 326, 331, 335, 339, 343, 347,
+    351, 355, 359, 364, 369, 374, 378, 382, 386, 387, 391, 395,
+};
+
+static const HT16K33Font DEFAULT_FONT = {
+    DEFAULT_COLUMNS, DEFAULT_OFFSETS, DEFAULT_WIDTHS,
+    sizeof(DEFAULT_WIDTHS), HT16K33_FONT_FIRST_CHAR, HT16K33_FONT_HEIGHT_MAX
+};
+
+
+/**
+ * @brief Get the built-in font.
+ *
+ * @retval The font.
+ */
+const HT16K33Font* HT16K33_font_get_default(void) {
+
+    return &DEFAULT_FONT;
+}
+
+
+/**
+ * @brief Load a BDF or PSF (1 or 2) font. Its glyphs are trimmed to
+ *        their lit columns, so the font is shown proportionally, and
+ *        must be no taller than a matrix. The first load packs the font
+ *        into a file in the user's cache directory, which later loads
+ *        read for as long as the font file is unchanged.
+ *
+ * @param path: The font file's path.
+ *
+ * @retval The font, or NULL on error. Free with `HT16K33_font_free()`.
+ */
+HT16K33Font* HT16K33_font_load(const char* path) {
+
+    struct stat info;
+    if (stat(path, &info) != 0 || !S_ISREG(info.st_mode)) {
+        print_error("Could not open font %s", path);
+        return NULL;
+    }
+
+    char cache_path[PATH_MAX];
+    bool has_cache = get_cache_path(path, cache_path, sizeof(cache_path));
+    if (has_cache) {
+        HT16K33Font* font = read_cache(cache_path, &info);
+        if (font != NULL) return font;
+    }
+
+    size_t length = 0;
+    uint8_t* data = read_file(path, &length);
+    if (data == NULL) return NULL;
+
+    HT16K33Font* font = parse_font(data, length, path);
+    free(data);
+
+    if (font != NULL && has_cache) write_cache(cache_path, &info, font);
+    return font;
+}
+
+
+/**
+ * @brief Free a loaded font.
+ *
+ * @param font: The font. The built-in font is ignored.
+ */
+void HT16K33_font_free(HT16K33Font* font) {
+
+    if (font != &DEFAULT_FONT) free(font);
+}
+
+
+/**
+ * @brief Look up a character's glyph.
+ *
+ * @param font:    The font.
+ * @param code:    The character code.
+ * @param columns: Set to the glyph's first column.
+ *
+ * @retval The glyph's width in columns, or 0 if the font has no glyph for the character.
+ */
+uint8_t HT16K33_font_get_glyph(const HT16K33Font* font, uint8_t code, const uint8_t** columns) {
+
+    if (code < font->first || code - font->first >= font->count) return 0;
+    uint32_t index = code - font->first;
+    *columns = &font->columns[font->offsets[index]];
+    return font->widths[index];
+}
+
+
+#pragma mark - Font Parsing
+
+/**
+ * @brief Parse a font file's contents.
+ *
+ * @param data:   The file's contents, followed by a zero byte.
+ * @param length: The length of the contents, not counting the zero.
+ * @param path:   The file's path, for messages.
+ *
+ * @retval The font, or NULL on error.
+ */
+static HT16K33Font* parse_font(uint8_t* data, size_t length, const char* path) {
+
+    uint8_t glyphs[HT16K33_FONT_CHARS][HT16K33_FONT_WIDTH_MAX] = {{0}};
+    uint8_t widths[HT16K33_FONT_CHARS] = {0};
+    uint8_t height = 0;
+    bool is_parsed = false;
+
+    if (length > 4 && (memcmp(data, "\x72\xB5\x4A\x86", 4) == 0 || memcmp(data, "\x36\x04", 2) == 0)) {
+        is_parsed = parse_psf(data, length, glyphs, widths, &height);
+    } else if (length > 9 && strncmp((char*)data, "STARTFONT", 9) == 0) {
+        is_parsed = parse_bdf((char*)data, glyphs, widths, &height);
+    } else if (length > 2 && data[0] == 0x1F && data[1] == 0x8B) {
+        print_error("Font %s is compressed: decompress it first", path);
+        return NULL;
+    } else {
+        print_error("Font %s is not a BDF or PSF font", path);
+        return NULL;
+    }
+
+    if (!is_parsed) return NULL;
+    return pack_font(glyphs, widths, height);
+}
+
+
+/**
+ * @brief Parse a BDF font. Glyphs sit on the font's baseline, with its
+ *        lowest descender at the bottom of the matrix.
+ *
+ * @param text:   The font file's contents. This is modified.
+ * @param glyphs: Buffers for each character's glyph.
+ * @param widths: Set to each character's width, or 0 for no glyph.
+ * @param height: Set to the font's height.
+ *
+ * @retval Whether the font was parsed (`true`) or not (`false`).
+ */
+static bool parse_bdf(char* text, uint8_t glyphs[][HT16K33_FONT_WIDTH_MAX], uint8_t* widths, uint8_t* height) {
+
+    int ascent = -1, descent = -1;
+    int box_width = 0, box_height = 0, box_x = 0, box_y = 0;
+    int encoding = -1, width = 0, rows = 0, y_offset = 0;
+    int row = -1;
+    int font_height = 0;
+    uint8_t columns[HT16K33_FONT_SOURCE_WIDTH_MAX];
+    char* save = NULL;
+
+    for (char* line = strtok_r(text, "\n", &save) ; line != NULL ; line = strtok_r(NULL, "\n", &save)) {
+        if (row >= 0) {
+            if (strncmp(line, "ENDCHAR", 7) == 0) {
+                if (encoding >= HT16K33_FONT_FIRST_CHAR && encoding <= HT16K33_FONT_LAST_CHAR) {
+                    uint32_t index = encoding - HT16K33_FONT_FIRST_CHAR;
+                    trim_glyph(columns, width, glyphs[index], &widths[index]);
+                }
+
+                row = -1;
+                continue;
+            }
+
+            // A row of pixels, leftmost in the top bit: set the
+            // bit for the row's height above the lowest descender
+            uint32_t bits = (uint32_t)strtoul(line, NULL, 16);
+            uint32_t top = (((width + 7) >> 3) << 3) - 1;
+            int bit = y_offset + (rows - 1 - row) + descent;
+            if (bit >= 0 && bit < font_height) {
+                for (int i = 0 ; i < width ; ++i) {
+                    if ((bits >> (top - i)) & 0x01) columns[i] |= (1 << bit);
+                }
+            }
+
+            row++;
+        } else if (strncmp(line, "STARTCHAR", 9) == 0) {
+            encoding = -1;
+            width = rows = y_offset = 0;
+        } else if (sscanf(line, "FONTBOUNDINGBOX %d %d %d %d", &box_width, &box_height, &box_x, &box_y) == 4) {
+            continue;
+        } else if (sscanf(line, "FONT_ASCENT %d", &ascent) == 1) {
+            continue;
+        } else if (sscanf(line, "FONT_DESCENT %d", &descent) == 1) {
+            continue;
+        } else if (sscanf(line, "ENCODING %d", &encoding) == 1) {
+            continue;
+        } else if (sscanf(line, "BBX %d %d %*d %d", &width, &rows, &y_offset) == 3) {
+            continue;
+        } else if (strncmp(line, "BITMAP", 6) == 0) {
+            // Size the font from its header, before the first glyph
+            if (font_height == 0) {
+                if (ascent < 0 || descent < 0) {
+                    ascent = box_height + box_y;
+                    descent = -box_y;
+                }
+
+                font_height = ascent + descent;
+                if (font_height < 1 || font_height > HT16K33_FONT_HEIGHT_MAX) {
+                    print_error("Font is %i rows tall: matrices take fonts of up to %i", font_height, HT16K33_FONT_HEIGHT_MAX);
+                    return false;
+                }
+            }
+
+            if (width < 0 || width > HT16K33_FONT_SOURCE_WIDTH_MAX || rows < 0) {
+                print_error("Font glyph %i is too large", encoding);
+                return false;
+            }
+
+            memset(columns, 0, sizeof(columns));
+            row = 0;
+        }
+    }
+
+    if (font_height == 0) {
+        print_error("Font has no glyphs");
+        return false;
+    }
+
+    *height = (uint8_t)font_height;
+    return true;
+}
+
+
+/**
+ * @brief Parse a PSF 1 or PSF 2 font, using its Unicode table, if it
+ *        has one, to find each character's glyph.
+ *
+ * @param data:   The font file's contents.
+ * @param length: The length of the contents.
+ * @param glyphs: Buffers for each character's glyph.
+ * @param widths: Set to each character's width, or 0 for no glyph.
+ * @param height: Set to the font's height.
+ *
+ * @retval Whether the font was parsed (`true`) or not (`false`).
+ */
+static bool parse_psf(const uint8_t* data, size_t length, uint8_t glyphs[][HT16K33_FONT_WIDTH_MAX], uint8_t* widths, uint8_t* height) {
+
+    uint32_t header_size, count, glyph_size, rows, width;
+    bool has_table, is_psf2 = (data[0] == 0x72);
+
+    if (is_psf2) {
+        if (length < 32) {
+            print_error("Font is truncated");
+            return false;
+        }
+
+        header_size = get_u32(&data[8]);
+        has_table = (get_u32(&data[12]) & 0x01) != 0;
+        count = get_u32(&data[16]);
+        glyph_size = get_u32(&data[20]);
+        rows = get_u32(&data[24]);
+        width = get_u32(&data[28]);
+    } else {
+        header_size = 4;
+        has_table = (data[2] & 0x06) != 0;
+        count = (data[2] & 0x01) ? 512 : 256;
+        glyph_size = data[3];
+        rows = data[3];
+        width = 8;
+    }
+
+    if (rows < 1 || rows > HT16K33_FONT_HEIGHT_MAX) {
+        print_error("Font is %u rows tall: matrices take fonts of up to %i", rows, HT16K33_FONT_HEIGHT_MAX);
+        return false;
+    }
+
+    uint32_t row_bytes = (width + 7) >> 3;
+    if (width > HT16K33_FONT_SOURCE_WIDTH_MAX || glyph_size < rows * row_bytes ||
+        (uint64_t)header_size + (uint64_t)count * glyph_size > length) {
+        print_error("Font is malformed");
+        return false;
+    }
+
+    // Map characters to glyphs: by the table, or one to one
+    int32_t map[HT16K33_FONT_LAST_CHAR + 1];
+    for (uint32_t i = 0 ; i <= HT16K33_FONT_LAST_CHAR ; ++i) map[i] = (!has_table && i < count) ? (int32_t)i : -1;
+    if (has_table) map_psf_glyphs(&data[header_size + count * glyph_size], &data[length], count, is_psf2, map);
+
+    for (uint32_t code = HT16K33_FONT_FIRST_CHAR ; code <= HT16K33_FONT_LAST_CHAR ; ++code) {
+        if (map[code] < 0) continue;
+
+        // Rows run top to bottom, leftmost pixel in each byte's top bit
+        const uint8_t* glyph = &data[header_size + map[code] * glyph_size];
+        uint8_t columns[HT16K33_FONT_SOURCE_WIDTH_MAX] = {0};
+        for (uint32_t y = 0 ; y < rows ; ++y) {
+            for (uint32_t x = 0 ; x < width ; ++x) {
+                if (glyph[y * row_bytes + (x >> 3)] & (0x80 >> (x & 0x07))) columns[x] |= (1 << (rows - 1 - y));
+            }
+        }
+
+        uint32_t index = code - HT16K33_FONT_FIRST_CHAR;
+        trim_glyph(columns, width, glyphs[index], &widths[index]);
+    }
+
+    *height = (uint8_t)rows;
+    return true;
+}
+
+
+/**
+ * @brief Read a PSF font's Unicode table: for each glyph in turn, the
+ *        characters it shows, then any sequences of combining
+ *        characters, which are skipped. PSF 1 lists them as 16-bit
+ *        values and PSF 2 as UTF-8.
+ *
+ * @param table:   The start of the table.
+ * @param end:     The end of the font file.
+ * @param count:   The number of glyphs.
+ * @param is_psf2: Whether the font is PSF 2 (`true`) or PSF 1.
+ * @param map:     The glyph for each character code, or -1.
+ */
+static void map_psf_glyphs(const uint8_t* table, const uint8_t* end, uint32_t count, bool is_psf2, int32_t* map) {
+
+    uint32_t glyph = 0;
+    bool is_sequence = false;
+
+    while (glyph < count && table < end) {
+        uint32_t code;
+        if (is_psf2) {
+            code = *table++;
+            if (code == 0xFF) {
+                glyph++;
+                is_sequence = false;
+                continue;
+            }
+
+            if (code == 0xFE) {
+                is_sequence = true;
+                continue;
+            }
+
+            // Decode two-byte UTF-8; longer forms are out of range
+            if ((code & 0xE0) == 0xC0 && table < end) {
+                code = ((code & 0x1F) << 6) | (*table++ & 0x3F);
+            } else if (code >= 0x80) {
+                while (table < end && (*table & 0xC0) == 0x80) table++;
+                continue;
+            }
+        } else {
+            if (table + 1 >= end) break;
+            code = table[0] | (table[1] << 8);
+            table += 2;
+            if (code == 0xFFFF) {
+                glyph++;
+                is_sequence = false;
+                continue;
+            }
+
+            if (code == 0xFFFE) {
+                is_sequence = true;
+                continue;
+            }
+        }
+
+        if (!is_sequence && code <= HT16K33_FONT_LAST_CHAR && map[code] < 0) map[code] = (int32_t)glyph;
+    }
+}
+
+
+/**
+ * @brief Trim a glyph to its lit columns. A blank glyph, eg. space,
+ *        keeps one column.
+ *
+ * @param columns: The glyph's columns.
+ * @param count:   The number of columns.
+ * @param glyph:   A buffer for the trimmed glyph.
+ * @param width:   Set to the trimmed glyph's width.
+ */
+static void trim_glyph(const uint8_t* columns, uint32_t count, uint8_t* glyph, uint8_t* width) {
+
+    uint32_t first = 0;
+    uint32_t last = count;
+    while (first < count && columns[first] == 0) first++;
+    while (last > first && columns[last - 1] == 0) last--;
+
+    if (first == last) {
+        glyph[0] = 0x00;
+        *width = 1;
+        return;
+    }
+
+    if (last - first > HT16K33_FONT_WIDTH_MAX) last = first + HT16K33_FONT_WIDTH_MAX;
+    memcpy(glyph, &columns[first], last - first);
+    *width = (uint8_t)(last - first);
+}
+
+
+/**
+ * @brief Pack parsed glyphs into a font.
+ *
+ * @param glyphs: Each character's glyph.
+ * @param widths: Each character's width, or 0 for no glyph.
+ * @param height: The font's height.
+ *
+ * @retval The font, or NULL on error.
+ */
+static HT16K33Font* pack_font(uint8_t glyphs[][HT16K33_FONT_WIDTH_MAX], const uint8_t* widths, uint8_t height) {
+
+    uint32_t column_count = 0;
+    for (uint32_t i = 0 ; i < HT16K33_FONT_CHARS ; ++i) column_count += widths[i];
+
+    uint16_t* font_offsets;
+    uint8_t* font_widths;
+    uint8_t* font_columns;
+    HT16K33Font* font = alloc_font(HT16K33_FONT_CHARS, column_count, &font_offsets, &font_widths, &font_columns);
+    if (font == NULL) return NULL;
+
+    uint32_t offset = 0;
+    for (uint32_t i = 0 ; i < HT16K33_FONT_CHARS ; ++i) {
+        font_offsets[i] = (uint16_t)offset;
+        font_widths[i] = widths[i];
+        memcpy(&font_columns[offset], glyphs[i], widths[i]);
+        offset += widths[i];
+    }
+
+    font->height = height;
+    return font;
+}
+
+
+/**
+ * @brief Allocate a font as a single block: the structure, then its
+ *        offsets, widths and columns.
+ *
+ * @param count:        The number of characters.
+ * @param column_count: The number of columns across all the glyphs.
+ * @param offsets:      Set to the font's offsets, to fill in.
+ * @param widths:       Set to the font's widths, to fill in.
+ * @param columns:      Set to the font's columns, to fill in.
+ *
+ * @retval The font, or NULL on error.
+ */
+static HT16K33Font* alloc_font(uint32_t count, uint32_t column_count, uint16_t** offsets, uint8_t** widths, uint8_t** columns) {
+
+    HT16K33Font* font = calloc(1, sizeof(HT16K33Font) + count * sizeof(uint16_t) + count + column_count);
+    if (font == NULL) {
+        print_error("Could not allocate font");
+        return NULL;
+    }
+
+    *offsets = (uint16_t*)&font[1];
+    *widths = (uint8_t*)&(*offsets)[count];
+    *columns = &(*widths)[count];
+
+    font->offsets = *offsets;
+    font->widths = *widths;
+    font->columns = *columns;
+    font->count = (uint16_t)count;
+    font->first = HT16K33_FONT_FIRST_CHAR;
+    return font;
+}
+
+
+/**
+ * @brief Read a whole file, adding a zero byte so text can be parsed in place.
+ *
+ * @param path:   The file's path.
+ * @param length: Set to the file's length.
+ *
+ * @retval The file's contents, or NULL on error. Free with `free()`.
+ */
+static uint8_t* read_file(const char* path, size_t* length) {
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        print_error("Could not open font %s", path);
+        return NULL;
+    }
+
+    uint8_t* data = malloc(HT16K33_FONT_FILE_MAX_B + 1);
+    size_t count = (data != NULL) ? fread(data, 1, HT16K33_FONT_FILE_MAX_B + 1, file) : 0;
+    fclose(file);
+
+    if (data == NULL || count == 0 || count > HT16K33_FONT_FILE_MAX_B) {
+        print_error("Could not read font %s", path);
+        free(data);
+        return NULL;
+    }
+
+    data[count] = 0;
+    *length = count;
+    return data;
+}
+
+
+#pragma mark - Font Cache
+
+/**
+ * @brief Get the path of a font's cached form, creating the cache
+ *        directory if needed. The name carries a hash of the font's
+ *        full path, to tell apart fonts of the same name.
+ *
+ * @param path:       The font file's path.
+ * @param cache_path: A buffer for the path.
+ * @param size:       The size of the buffer.
+ *
+ * @retval Whether the font can be cached (`true`) or not (`false`).
+ */
+static bool get_cache_path(const char* path, char* cache_path, size_t size) {
+
+    char full_path[PATH_MAX];
+    const char* home = getenv("HOME");
+    if (realpath(path, full_path) == NULL || home == NULL) return false;
+
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char* c = full_path ; *c != '\0' ; ++c) {
+        hash ^= (uint8_t)*c;
+        hash *= 16777619u;
+    }
+
+    const char* name = strrchr(full_path, '/');
+    name = (name != NULL) ? name + 1 : full_path;
+
+    char directory[PATH_MAX];
+    int result;
+#ifdef BUILD_FOR_LINUX
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home != NULL && cache_home[0] == '/') {
+        result = snprintf(directory, sizeof(directory), "%s", cache_home);
+    } else {
+        result = snprintf(directory, sizeof(directory), "%s/.cache", home);
+    }
+#else
+    result = snprintf(directory, sizeof(directory), "%s/Library/Caches", home);
+#endif
+    if (result < 0 || result >= (int)sizeof(directory) - 7) return false;
+
+    mkdir(directory, 0700);
+    strcat(directory, "/cli2c");
+    if (mkdir(directory, 0700) != 0 && errno != EEXIST) return false;
+
+    result = snprintf(cache_path, size, "%s/%s-%08x.font", directory, name, hash);
+    return (result > 0 && result < (int)size);
+}
+
+
+/**
+ * @brief Read a font's cached form, if it is from the font file as
+ *        it is now.
+ *
+ * @param cache_path: The cached form's path.
+ * @param info:       The font file's details.
+ *
+ * @retval The font, or NULL if there's no usable cached form.
+ */
+static HT16K33Font* read_cache(const char* cache_path, const struct stat* info) {
+
+    FILE* file = fopen(cache_path, "rb");
+    if (file == NULL) return NULL;
+
+    HT16K33FontCacheHeader header;
+    HT16K33Font* font = NULL;
+    if (fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, HT16K33_FONT_CACHE_MAGIC, 4) == 0 &&
+        header.version == HT16K33_FONT_CACHE_VERSION &&
+        header.source_size == (int64_t)info->st_size &&
+        header.source_mtime == (int64_t)info->st_mtime &&
+        header.count <= HT16K33_FONT_CHARS &&
+        header.height >= 1 && header.height <= HT16K33_FONT_HEIGHT_MAX &&
+        header.column_count <= header.count * HT16K33_FONT_WIDTH_MAX) {
+        uint16_t* offsets;
+        uint8_t* widths;
+        uint8_t* columns;
+        font = alloc_font(header.count, header.column_count, &offsets, &widths, &columns);
+        if (font != NULL) {
+            font->first = header.first;
+            font->height = header.height;
+            if (fread(widths, 1, header.count, file) != header.count ||
+                fread(offsets, sizeof(uint16_t), header.count, file) != header.count ||
+                fread(columns, 1, header.column_count, file) != header.column_count) {
+                free(font);
+                font = NULL;
+            } else {
+                // Don't trust a glyph that runs past the columns
+                for (uint32_t i = 0 ; i < header.count ; ++i) {
+                    if (offsets[i] + widths[i] > header.column_count) {
+                        free(font);
+                        font = NULL;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    fclose(file);
+    return font;
+}
+
+
+/**
+ * @brief Write a font's cached form. The file is written in full under
+ *        a temporary name, then renamed, so readers never see part of
+ *        one. Failure is not an error: the font will just be parsed
+ *        again next time.
+ *
+ * @param cache_path: The cached form's path.
+ * @param info:       The font file's details.
+ * @param font:       The font.
+ */
+static void write_cache(const char* cache_path, const struct stat* info, const HT16K33Font* font) {
+
+    char temp_path[PATH_MAX];
+    int result = snprintf(temp_path, sizeof(temp_path), "%s.%i", cache_path, (int)getpid());
+    if (result < 0 || result >= (int)sizeof(temp_path)) return;
+
+    FILE* file = fopen(temp_path, "wb");
+    if (file == NULL) return;
+
+    HT16K33FontCacheHeader header = {0};
+    memcpy(header.magic, HT16K33_FONT_CACHE_MAGIC, 4);
+    header.version = HT16K33_FONT_CACHE_VERSION;
+    header.source_size = (int64_t)info->st_size;
+    header.source_mtime = (int64_t)info->st_mtime;
+    header.count = font->count;
+    header.first = font->first;
+    header.height = font->height;
+    for (uint32_t i = 0 ; i < font->count ; ++i) header.column_count += font->widths[i];
+
+    bool is_written = (fwrite(&header, sizeof(header), 1, file) == 1 &&
+                       fwrite(font->widths, 1, font->count, file) == font->count &&
+                       fwrite(font->offsets, sizeof(uint16_t), font->count, file) == font->count &&
+                       fwrite(font->columns, 1, header.column_count, file) == header.column_count);
+    if (fclose(file) != 0) is_written = false;
+
+    if (!is_written || rename(temp_path, cache_path) != 0) unlink(temp_path);
+}
+
+
+/**
+ * @brief Read a little-endian 32-bit value.
+ *
+ * @param data: The value's first byte.
+ *
+ * @retval The value.
+ */
+static inline uint32_t get_u32(const uint8_t* data) {
+
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
@@ -0,0 +1,77 @@
+/*
+ * HT16K33 8x8 matrix driver - Fonts
+ *
+ * Version 1.2.0
+ * Copyright © 2023, Tony Smith (@smittytone)
+ * Licence: MIT
+ *
+ */
+#ifndef _HT16K33_FONT_HEADER_
+#define _HT16K33_FONT_HEADER_
+
+
+/*
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+
+
+/*
+ * CONSTANTS
+ */
+// Fonts cover these character codes
+#define     HT16K33_FONT_FIRST_CHAR         32
+#define     HT16K33_FONT_LAST_CHAR          255
+#define     HT16K33_FONT_CHARS              (HT16K33_FONT_LAST_CHAR - HT16K33_FONT_FIRST_CHAR + 1)
+
+// Glyphs must fit a matrix
+#define     HT16K33_FONT_WIDTH_MAX          8
+#define     HT16K33_FONT_HEIGHT_MAX         8
+
+// Limits on font files
+#define     HT16K33_FONT_FILE_MAX_B         (4 * 1024 * 1024)
+#define     HT16K33_FONT_SOURCE_WIDTH_MAX   32
+
+#define     HT16K33_FONT_CACHE_MAGIC        "H16F"
+#define     HT16K33_FONT_CACHE_VERSION      1
+
+
+/*
+ * STRUCTURES
+ */
+// A proportional font, packed for O(1) glyph look-up
+typedef struct {
+    const uint8_t*      columns;        // Every glyph's columns, back to back, with bit 0 the bottom row
+    const uint16_t*     offsets;        // By character: the index of its first column
+    const uint8_t*      widths;         // By character: its width in columns, or 0 if it has no glyph
+    uint16_t            count;          // The number of characters
+    uint8_t             first;          // The code of the first character
+    uint8_t             height;         // The number of rows, from bit 0 up
+} HT16K33Font;
+
+// The start of a cached font file, in the host's byte order. The
+// widths, offsets and columns follow
+typedef struct {
+    char                magic[4];
+    uint32_t            version;
+    int64_t             source_size;    // The size of the font file when cached
+    int64_t             source_mtime;   // The modification time of the font file when cached
+    uint16_t            count;
+    uint8_t             first;
+    uint8_t             height;
+    uint32_t            column_count;
+} HT16K33FontCacheHeader;
+
+
+/*
+ * PROTOTYPES
+ */
+const HT16K33Font*  HT16K33_font_get_default(void);
+HT16K33Font*        HT16K33_font_load(const char* path);
+void                HT16K33_font_free(HT16K33Font* font);
+uint8_t             HT16K33_font_get_glyph(const HT16K33Font* font, uint8_t code, const uint8_t** columns);
+
+
+#endif  // _HT16K33_FONT_HEADER_
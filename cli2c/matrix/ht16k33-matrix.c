@@ -12,135 +12,141 @@
 /*
  * STATIC PROTOTYPES
  */
-static void HT16K33_sleep_ms(int ms);
 static void HT16K33_write_cmd(uint8_t cmd, bool do_stop);
+static bool HT16K33_write_changes(HT16K33Tile* tile, uint8_t* tx_buffer);
+static void HT16K33_get_tile(const HT16K33Tile* tile, uint8_t* tile_buffer);
+static void HT16K33_rotate(const uint8_t* in_buffer, uint8_t* out_buffer, uint8_t angle);
+static inline uint64_t HT16K33_transpose(uint64_t bits);
+static inline uint64_t HT16K33_reverse_bytes(uint64_t bits);
 
 
 /*
  * GLOBALS
  */
-// The Ascii character set
-const char CHARSET[128][6] = {
-    "\x00\x00\x00",              // space - Ascii 32
-    "\xfa\x00",                  // !
-    "\xc0\x00\xc0\x00",          // "
-    "\x24\x7e\x24\x7e\x24\x00",  // #
-    "\x24\xd4\x56\x48\x00",      // $
-    "\xc6\xc8\x10\x26\xc6\x00",  // %
-    "\x6c\x92\x6a\x04\x0a\x00",  // &
-    "\xc0\x00",                  // '
-    "\x7c\x82\x00",              // (
-    "\x82\x7c\x00",              // )
-    "\x10\x7c\x38\x7c\x10\x00",  // *
-    "\x10\x10\x7c\x10\x10\x00",  // +
-    "\x06\x07\x00",              // ,
-    "\x10\x10\x10\x10\x00",      // -
-    "\x06\x06\x00",              // .
-    "\x04\x08\x10\x20\x40\x00",  // /
-    "\x7c\x8a\x92\xa2\x7c\x00",  // 0 - Ascii 48
-    "\x42\xfe\x02\x00",          // 1
-    "\x46\x8a\x92\x92\x62\x00",  // 2
-    "\x44\x92\x92\x92\x6c\x00",  // 3
-    "\x18\x28\x48\xfe\x08\x00",  // 4
-    "\xf4\x92\x92\x92\x8c\x00",  // 5
-    "\x3c\x52\x92\x92\x8c\x00",  // 6
-    "\x80\x8e\x90\xa0\xc0\x00",  // 7
-    "\x6c\x92\x92\x92\x6c\x00",  // 8
-    "\x60\x92\x92\x94\x78\x00",  // 9
-    "\x36\x36\x00",              // : - Ascii 58
-    "\x36\x37\x00",              //
-    "\x10\x28\x44\x82\x00",      // <
-    "\x24\x24\x24\x24\x24\x00",  // =
-    "\x82\x44\x28\x10\x00",      // >
-    "\x60\x80\x9a\x90\x60\x00",  // ?
-    "\x7c\x82\xba\xaa\x78\x00",  // @
-    "\x7e\x90\x90\x90\x7e\x00",  // A - Ascii 65
-    "\xfe\x92\x92\x92\x6c\x00",  // B
-    "\x7c\x82\x82\x82\x44\x00",  // C
-    "\xfe\x82\x82\x82\x7c\x00",  // D
-    "\xfe\x92\x92\x92\x82\x00",  // E
-    "\xfe\x90\x90\x90\x80\x00",  // F
-    "\x7c\x82\x92\x92\x5c\x00",  // G
-    "\xfe\x10\x10\x10\xfe\x00",  // H
-    "\x82\xfe\x82\x00",          // I
-    "\x0c\x02\x02\x02\xfc\x00",  // J
-    "\xfe\x10\x28\x44\x82\x00",  // K
-    "\xfe\x02\x02\x02\x00",      // L
-    "\xfe\x40\x20\x40\xfe\x00",  // M
-    "\xfe\x40\x20\x10\xfe\x00",  // N
-    "\x7c\x82\x82\x82\x7c\x00",  // O
-    "\xfe\x90\x90\x90\x60\x00",  // P
-    "\x7c\x82\x92\x8c\x7a\x00",  // Q
-    "\xfe\x90\x90\x98\x66\x00",  // R
-    "\x64\x92\x92\x92\x4c\x00",  // S
-    "\x80\x80\xfe\x80\x80\x00",  // T
-    "\xfc\x02\x02\x02\xfc\x00",  // U
-    "\xf8\x04\x02\x04\xf8\x00",  // V
-    "\xfc\x02\x3c\x02\xfc\x00",  // W
-    "\xc6\x28\x10\x28\xc6\x00",  // X
-    "\xe0\x10\x0e\x10\xe0\x00",  // Y
-    "\x86\x8a\x92\xa2\xc2\x00",  // Z - Ascii 90
-    "\xfe\x82\x82\x00",          // [
-    "\x40\x20\x10\x08\x04\x00",  // forward slash
-    "\x82\x82\xfe\x00",          // ]
-    "\x20\x40\x80\x40\x20\x00",  // ^
-    "\x02\x02\x02\x02\x02\x00",  // _
-    "\xc0\xe0\x00",              // '
-    "\x04\x2a\x2a\x1e\x00",      // a - Ascii 97
-    "\xfe\x22\x22\x1c\x00",      // b
-    "\x1c\x22\x22\x22\x00",      // c
-    "\x1c\x22\x22\xfc\x00",      // d
-    "\x1c\x2a\x2a\x10\x00",      // e
-    "\x10\x7e\x90\x80\x00",      // f
-    "\x18\x25\x25\x3e\x00",      // g
-    "\xfe\x20\x20\x1e\x00",      // h
-    "\xbc\x02\x00",              // i
-    "\x02\x01\x21\xbe\x00",      // j
-    "\xfe\x08\x14\x22\x00",      // k
-    "\xfc\x02\x00",              // l
-    "\x3e\x20\x18\x20\x1e\x00",  // m
-    "\x3e\x20\x20 \x1e\x00",     // n
-    "\x1c\x22\x22\x1c\x00",      // o
-    "\x3f\x22\x22\x1c\x00",      // p
-    "\x1c\x22\x22\x3f\x00",      // q
-    "\x22\x1e\x20\x10\x00",      // r
-    "\x12\x2a\x2a\x04\x00",      // s
-    "\x20\x7c\x22\x04\x00",      // t
-    "\x3c\x02\x02\x3e\x00",      // u
-    "\x38\x04\x02\x04\x38\x00",  // v
-    "\x3c\x06\x0c\x06\x3c\x00",  // w
-    "\x22\x14\x08\x14\x22\x00",  // x
-    "\x39\x05\x06\x3c\x00",      // y
-    "\x26\x2a\x2a\x32\x00",      // z - Ascii 122
-    "\x10\x7c\x82\x82\x00",      //
-    "\xee\x00",                  // |
-    "\x82\x82\x7c\x10\x00",      //
-    "\x40\x80\x40\x80\x00",      // ~
-    "\x60\x90\x90\x60\x00"       // Degrees sign - Ascii 127
-};
-
 // Display buffer
-uint8_t display_buffer[8];
+// FROM 1.2.0 -- a canvas spanning all the matrices: each run of
+//               `canvas_width` bytes is a band of eight rows, one
+//               byte per column, with bit zero the lowest row
+uint8_t display_buffer[HT16K33_CANVAS_MAX_B];
 uint8_t display_angle = HT16K33_0_DEG;
+uint32_t canvas_width = 0;
+uint32_t canvas_height = 0;
 
 // The I2C bus
 I2CDriver* host_i2c;
-int i2c_address = HT16K33_I2C_ADDR;
+
+// FROM 1.2.0
+// The matrices showing the canvas. Each records its display RAM as
+// last written, so that `HT16K33_draw()` need only send the bytes
+// that have changed
+HT16K33Tile tiles[HT16K33_TILES_MAX];
+uint32_t tile_count = 0;
+
+// FROM 1.2.0
+// How late each scrolled frame is drawn
+I2CHistogram scroll_jitter = {0};
+
+// FROM 1.2.0
+// The font used for text, and the font loaded by `HT16K33_set_font()`
+const HT16K33Font* font = NULL;
+HT16K33Font* loaded_font = NULL;
 
 
 /**
- * @brief Set up the data the driver needs.
+ * @brief Set up the data the driver needs. Add the matrices
+ *        to drive with `HT16K33_add_tile()`.
  *
  * @param sd:       Pointer to the main I2C driver data structure.
- * @param address:  A non-standard HT16K33 address, or -1.
- * @param angle:    The mutiple of 90 degrees at which the matrix
- *                  is oriented.
+ * @param angle:    The mutiple of 90 degrees at which the matrices
+ *                  are oriented.
  */
-void HT16K33_init(I2CDriver *sd, int address, uint8_t angle) {
+void HT16K33_init(I2CDriver *sd, uint8_t angle) {
 
-    if (address != -1) i2c_address = address;
     HT16K33_set_angle(angle);
     host_i2c = sd;
+
+    // FROM 1.2.0
+    tile_count = 0;
+    font = HT16K33_font_get_default();
+    canvas_width = 0;
+    canvas_height = 0;
+    HT16K33_clear_buffer();
+}
+
+
+/**
+ * @brief Add a matrix showing an 8x8 area of the canvas, which
+ *        grows to span all the matrices. Add matrices before
+ *        drawing: adding one clears the canvas.
+ *        FROM 1.2.0
+ *
+ * @param address: The matrix's I2C address.
+ * @param x:       The canvas column shown in the matrix's column 0,
+ *                 or -1 to place the matrix right of the canvas.
+ * @param y:       The canvas row shown in the matrix's row 0, or -1 for 0.
+ * @param angle:   The multiple of 90 degrees at which the matrix is
+ *                 oriented, relative to the others.
+ *
+ * @retval Whether the matrix was added (`true`) or not (`false`).
+ */
+bool HT16K33_add_tile(int address, int x, int y, uint8_t angle) {
+
+    if (tile_count == HT16K33_TILES_MAX) {
+        print_error("Too many matrices (maximum %i)", HT16K33_TILES_MAX);
+        return false;
+    }
+
+    if (address < 0x08 || address > 0x77) {
+        print_error("I2C address out of range");
+        return false;
+    }
+
+    for (uint32_t i = 0 ; i < tile_count ; ++i) {
+        if (tiles[i].address == address) {
+            print_error("Matrix at 0x%02X added twice", address);
+            return false;
+        }
+    }
+
+    if (x < 0) x = canvas_width;
+    if (y < 0) y = 0;
+
+    // Make sure the canvas still fits the buffer
+    uint32_t width = (x + 8 > canvas_width) ? x + 8 : canvas_width;
+    uint32_t height = (y + 8 > canvas_height) ? y + 8 : canvas_height;
+    if (width * ((height + 7) >> 3) > HT16K33_CANVAS_MAX_B) {
+        print_error("Canvas too large for matrix at 0x%02X", address);
+        return false;
+    }
+
+    HT16K33Tile* tile = &tiles[tile_count++];
+    memset(tile, 0, sizeof(HT16K33Tile));
+    tile->address = (uint8_t)address;
+    tile->x = (uint8_t)x;
+    tile->y = (uint8_t)y;
+    tile->angle = angle & 0x03;
+
+    canvas_width = width;
+    canvas_height = height;
+    HT16K33_clear_buffer();
+    return true;
+}
+
+
+/**
+ * @brief Get the size of the canvas.
+ *        FROM 1.2.0
+ *
+ * @param width:  Set to the width in pixels. May be NULL.
+ * @param height: Set to the height in pixels. May be NULL.
+ *
+ * @retval The number of bytes the canvas occupies.
+ */
+size_t HT16K33_get_size(uint32_t* width, uint32_t* height) {
+
+    if (width != NULL) *width = canvas_width;
+    if (height != NULL) *height = canvas_height;
+    return canvas_width * ((canvas_height + 7) >> 3);
 }
 
 
@@ -193,34 +199,66 @@ void HT16K33_set_brightness(uint8_t brightness) {
  */
 void HT16K33_clear_buffer(void) {
 
-    memset(display_buffer, 0x00, 8);
+    memset(display_buffer, 0x00, sizeof(display_buffer));
 }
 
 
 /**
- * @brief Write the display buffer out to the LED.
+ * @brief Write the display buffer out to the LEDs.
+ *        FROM 1.2.0 -- every matrix is updated in a single pipeline,
+ *        back to back, so that the tiles change together.
+ *
+ * @param do_stop: Whether to end the transaction with a STOP.
+ *
+ * @retval Whether every matrix ACK'd its write (`true`) or not (`false`).
  */
-void HT16K33_draw(bool do_stop) {
-
-    // Set up the buffer holding the data to be
-    // transmitted to the LED
-    uint8_t tx_buffer[17] = { 0 };
+bool HT16K33_draw(bool do_stop) {
+
+    bool is_any_written = false;
+    i2c_pipeline_begin(host_i2c);
+
+    for (uint32_t t = 0 ; t < tile_count ; ++t) {
+        HT16K33Tile* tile = &tiles[t];
+
+        // Set up the buffer holding the data to be
+        // transmitted to the LED
+        uint8_t tx_buffer[17] = { 0 };
+
+        // FROM 1.2.0 -- rotate a copy of the tile's area of the
+        //               canvas, so the canvas itself keeps its
+        //               orientation from draw to draw
+        uint8_t tile_buffer[8];
+        uint8_t out_buffer[8];
+        HT16K33_get_tile(tile, tile_buffer);
+        HT16K33_rotate(tile_buffer, out_buffer, (display_angle + tile->angle) & 0x03);
+
+        // Span the 8 bytes of the graphics buffer
+        // across the 16 bytes of the LED's buffer
+        for (uint8_t i = 0 ; i < 8 ; ++i) {
+            uint8_t a = out_buffer[i];
+            tx_buffer[i * 2 + 1] = (a >> 1) + ((a << 7) & 0xFF);
+        }
 
-    if (display_angle != 0) {
-        HT16K33_rotate(display_angle);
+        if (HT16K33_write_changes(tile, tx_buffer)) is_any_written = true;
     }
 
-    // Span the 8 bytes of the graphics buffer
-    // across the 16 bytes of the LED's buffer
-    for (uint8_t i = 0 ; i < 8 ; ++i) {
-        uint8_t a = display_buffer[i];
-        tx_buffer[i * 2 + 1] = (a >> 1) + ((a << 7) & 0xFF);
+    // Nothing has changed: there's nothing to send unless we
+    // need to end the transaction, so just set a RAM address
+    if (!is_any_written && do_stop && tile_count > 0) {
+        uint8_t ram_address = 0;
+        i2c_start(host_i2c, tiles[0].address, 0);
+        i2c_write(host_i2c, &ram_address, 1);
     }
 
-    // Display the buffer and flash the LED
-    i2c_start(host_i2c, i2c_address, 0);
-    i2c_write(host_i2c, tx_buffer, 17);
     if (do_stop) i2c_stop(host_i2c);
+
+    // After a failure, we can't tell what any matrix holds
+    bool result = i2c_pipeline_end(host_i2c);
+    if (!result) {
+        for (uint32_t t = 0 ; t < tile_count ; ++t) tiles[t].is_sent_buffer_valid = false;
+    }
+
+    return result;
 }
 
 
@@ -233,45 +271,80 @@ void HT16K33_draw(bool do_stop) {
  */
 void HT16K33_plot(uint8_t x, uint8_t y, bool is_set) {
 
+    // FROM 1.2.0 -- co-ordinates are on the canvas
+    if (x >= canvas_width || y >= canvas_height) return;
+    uint8_t* column = &display_buffer[(y >> 3) * canvas_width + x];
+
     // Set or unset the specified pixel
     if (is_set) {
-        display_buffer[x] |= (1 << y);
+        *column |= (1 << (y & 0x07));
     } else {
-        display_buffer[x] &= ~(1 << y);
+        *column &= ~(1 << (y & 0x07));
     }
 }
 
 
+/**
+ * @brief Use a font loaded from a BDF or PSF file for text, in
+ *        place of the built-in font.
+ *        FROM 1.2.0
+ *
+ * @param path: The font file's path.
+ *
+ * @retval Whether the font was loaded (`true`) or not (`false`).
+ */
+bool HT16K33_set_font(const char* path) {
+
+    HT16K33Font* new_font = HT16K33_font_load(path);
+    if (new_font == NULL) return false;
+
+    HT16K33_font_free(loaded_font);
+    loaded_font = new_font;
+    font = new_font;
+    return true;
+}
+
+
 /**
  *  @brief Set an alphanumeric character on the display.
  *
  *  @param ascii:      The character's Ascii code.
  *  @param is_centred: Whether to centre the character on the display.
+ *
+ *  @retval Whether the font has the character (`true`) or not (`false`).
  */
-void HT16K33_set_char(uint8_t ascii, bool is_centred) {
+bool HT16K33_set_char(uint8_t ascii, bool is_centred) {
+
+    // FROM 1.2.0 -- Glyphs come from the current font, which records
+    //               each one's width
+    const uint8_t* columns = NULL;
+    uint8_t width = HT16K33_font_get_glyph(font, ascii, &columns);
+    if (width == 0) return false;
+    if (width > canvas_width) width = canvas_width;
 
     uint8_t delta = 0;
     if (is_centred) {
-        delta = (8 - strlen(CHARSET[ascii - 32])) >> 1;
+        delta = (canvas_width - width) >> 1;
     }
 
-    for (uint8_t i = 0 ; i < 8 ; ++i) {
-        if (CHARSET[ascii - 32][i] == 0) break;
-        display_buffer[i + delta] = CHARSET[ascii - 32][i];
-    }
+    memcpy(&display_buffer[delta], columns, width);
+    return true;
 }
 
 
 /**
  *  @brief Set an user-defined character on the display.
  *
- *  @param bytes: A pointer to an array of 8 bytes defining the glyph.
- *                Each byte is a column of image pixels, one bix per pixel,
- *                with bit zero at the bottom.
+ *  @param bytes:  A pointer to an array of bytes defining the glyph.
+ *                 Each byte is a column of image pixels, one bix per pixel,
+ *                 with bit zero at the bottom. Rows beyond the first eight
+ *                 follow in further bands of one byte per column.
+ *  @param length: The number of bytes. Bytes beyond the canvas are ignored.
  */
-void HT16K33_set_glyph(uint8_t* bytes) {
+void HT16K33_set_glyph(const uint8_t* bytes, size_t length) {
 
-    memcpy(display_buffer, bytes, 8);
+    size_t size = HT16K33_get_size(NULL, NULL);
+    memcpy(display_buffer, bytes, length < size ? length : size);
 }
 
 
@@ -283,128 +356,235 @@ void HT16K33_set_glyph(uint8_t* bytes) {
  */
 void HT16K33_print(const char *text, uint32_t delay_ms) {
 
-    if (strlen(text) == 0) return;
-    
-    // Get the length of the text: the number of columns it encompasses
+    // FROM 1.2.0 -- Glyphs come from the current font, which records
+    //               each one's width, so the text is measured in one
+    //               pass. Characters the font lacks show as spaces
+    size_t text_length = strlen(text);
+    if (text_length == 0) return;
+
+    // Get the length of the text: the number of columns it encompasses,
+    // including a blank column after each character
+    const uint8_t* space_columns = NULL;
+    uint8_t space_width = HT16K33_font_get_glyph(font, ' ', &space_columns);
     uint64_t length = 0;
-    for (size_t i = 0 ; i < strlen(text) ; ++i) {
-        uint8_t asc_val = text[i] - 32;
-        length += (asc_val == 0 ? 2 : strlen(CHARSET[asc_val]));
-        if (asc_val > 0) length++;
+    for (size_t i = 0 ; i < text_length ; ++i) {
+        const uint8_t* columns = NULL;
+        uint8_t width = HT16K33_font_get_glyph(font, (uint8_t)text[i], &columns);
+        length += (width > 0 ? width : space_width) + 1;
     }
 
     // Make the output buffer to match the required number of columns
-    if (length == 0) return;
-    uint8_t src_buffer[length];
+    uint8_t* src_buffer = calloc(length, 1);
+    if (src_buffer == NULL) {
+        print_error("Could not allocate text buffer");
+        return;
+    }
 
-    // Write each character's glyph columns into the output buffer
+    // Write each character's glyph columns into the output buffer,
+    // leaving the blank column that follows it
     uint64_t col = 0;
-    for (size_t i = 0 ; i < strlen(text) ; ++i) {
-        uint8_t asc_val = text[i] - 32;
-        if (asc_val == 0) {
-            // It's a space, so just add two blank columns
-            src_buffer[col++] = 0x00;
-            src_buffer[col++] = 0x00;
-        } else {
-            // Get the character glyph and write it to the buffer
-            uint8_t glyph_len = strlen(CHARSET[asc_val]);
-            for (size_t j = 0 ; j < glyph_len ; ++j) {
-                src_buffer[col] = CHARSET[asc_val][j];
-                ++col;
-            }
-
-            // Space between lines
-            src_buffer[col++] = 0x00;
+    for (size_t i = 0 ; i < text_length ; ++i) {
+        const uint8_t* columns = NULL;
+        uint8_t width = HT16K33_font_get_glyph(font, (uint8_t)text[i], &columns);
+        if (width == 0) {
+            columns = space_columns;
+            width = space_width;
         }
+
+        if (width > 0) memcpy(&src_buffer[col], columns, width);
+        col += width + 1;
     }
 
     // Finally, animate the line by repeatedly sending 8 columns
     // of the output buffer to the matrix
-    int cursor = 0;
+    // FROM 1.2.0 -- Frames are timed from absolute deadlines, so the
+    //               time taken to draw them doesn't add to the delay,
+    //               and the thread sleeps rather than spins between them
+    // FROM 1.2.0 -- The text scrolls across the width of the canvas,
+    //               in its lowest band of rows
+    uint64_t cursor = 0;
+    uint64_t deadline_us = get_monotonic_us();
     while (1) {
-        int a = cursor;
-        for (size_t i = 0 ; i < 8 ; ++i) {
-            display_buffer[i] = src_buffer[a];
-            a += 1;
+        for (uint64_t i = 0 ; i < canvas_width ; ++i) {
+            display_buffer[i] = (cursor + i < length) ? src_buffer[cursor + i] : 0x00;
         }
 
         cursor++;
-        HT16K33_draw(cursor > length - 8);
-        if (cursor > length - 8) break;
-
-        HT16K33_sleep_ms(display_angle == 0 ? delay_ms : (delay_ms * 2 / 3));
+        bool is_done = (cursor + canvas_width > length);
+        HT16K33_draw(is_done);
+        if (is_done) break;
+
+        // Record how late we wake for each frame
+        deadline_us += (uint64_t)delay_ms * 1000;
+        sleep_until_us(deadline_us);
+        uint64_t now_us = get_monotonic_us();
+        i2c_stats_add(&scroll_jitter, (uint32_t)(now_us > deadline_us ? now_us - deadline_us : 0));
     };
+
+    free(src_buffer);
 }
 
 
 /**
- *  @brief Rotate the display. Not a public function.
+ * @brief Get the timing of frames drawn by `HT16K33_print()`: how
+ *        late, in microseconds, each was drawn.
+ *        FROM 1.2.0
  *
- *  @param angle: The angle of rotation as an integer multiple of 90 degrees.
+ * @retval The histogram of lateness.
  */
-void HT16K33_rotate(uint8_t angle) {
-
-    uint8_t temp[8] = { 0 };
-    uint8_t a = 0;
-    uint8_t line_value = 0;
-
-    for (size_t y = 0 ; y < 8 ; ++y) {
-        line_value = display_buffer[y];
-        for (size_t x = 7 ; x > -1 ; x--) {
-            a = line_value & (1 << x);
-            if (a != 0) {
-                if (angle == 1) {
-                    temp[7 - x] |= (1 << y);
-                } else if (angle == 2) {
-                    temp[7 - y] |= (1 << (7 - x));
-                } else {
-                    temp[x] |= (1 << (7 - y));
-                }
-            }
-        }
+const I2CHistogram* HT16K33_get_jitter(void) {
+
+    return &scroll_jitter;
+}
+
+
+/**
+ * @brief Issue a single command byte to the HT16K33.
+ *
+ * @param cmd:     The single-byte command.
+ * @param do_stop: Issue a stop upon completion
+ */
+static void HT16K33_write_cmd(uint8_t cmd, bool do_stop) {
+
+    // NOTE Already connected at this stage
+    // FROM 1.2.0 -- pipeline the ops to save round trips,
+    //               and send the command to every matrix
+    i2c_pipeline_begin(host_i2c);
+    for (uint32_t i = 0 ; i < tile_count ; ++i) {
+        i2c_start(host_i2c, tiles[i].address, 0);
+        i2c_write(host_i2c, &cmd, 1);
     }
 
-    // Swap the matrices
-    memcpy(display_buffer, temp, 8);
+    if (do_stop) i2c_stop(host_i2c);
+    i2c_pipeline_end(host_i2c);
 }
 
 
 /**
- * @brief Sleep the thread for the specified period in milliseconds.
+ * @brief Queue a write of the bytes of a matrix's display RAM that
+ *        differ from those last written, starting at the address of
+ *        the first of them. Call within a pipeline.
+ *        FROM 1.2.0
+ *
+ * @param tile:      The matrix.
+ * @param tx_buffer: The RAM address, 0, then the 16 bytes of RAM.
+ *                   The address is overwritten.
  *
- * @param ms: The sleep period.
+ * @retval Whether a write was queued (`true`) or nothing has changed (`false`).
  */
-static void HT16K33_sleep_ms(int ms) {
-    
-    // FROM 1.1.2
-    // New, better alogrithm
-    long delta = 0;
-    struct timespec now, then;
-    clock_gettime(CLOCK_MONOTONIC_RAW, &then);
-    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-    
-    while (now.tv_nsec - then.tv_nsec < ms * 1000000 - delta) {
-        clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-        if (now.tv_nsec < then.tv_nsec) {
-            // Roll over
-            delta = LONG_MAX - then.tv_nsec;
-            then.tv_nsec = 0;
-        }
+static bool HT16K33_write_changes(HT16K33Tile* tile, uint8_t* tx_buffer) {
+
+    // Find the span of RAM that has changed
+    uint32_t first = 1;
+    uint32_t last = 16;
+    if (tile->is_sent_buffer_valid) {
+        while (first <= last && tx_buffer[first] == tile->sent_buffer[first]) first++;
+        while (last > first && tx_buffer[last] == tile->sent_buffer[last]) last--;
+        if (first > last) return false;
     }
+
+    // Prefix the span with its RAM address
+    tx_buffer[first - 1] = (uint8_t)(first - 1);
+
+    i2c_start(host_i2c, tile->address, 0);
+    i2c_write(host_i2c, &tx_buffer[first - 1], last - first + 2);
+    memcpy(&tile->sent_buffer[first], &tx_buffer[first], last - first + 1);
+    tile->is_sent_buffer_valid = true;
+    return true;
 }
 
 
 /**
- * @brief Issue a single command byte to the HT16K33.
+ * @brief Copy a matrix's 8x8 area of the canvas.
+ *        FROM 1.2.0
  *
- * @param cmd:     The single-byte command.
- * @param do_stop: Issue a stop upon completion
+ * @param tile:        The matrix.
+ * @param tile_buffer: A buffer for the area's 8 columns.
  */
-static void HT16K33_write_cmd(uint8_t cmd, bool do_stop) {
+static void HT16K33_get_tile(const HT16K33Tile* tile, uint8_t* tile_buffer) {
 
-    // NOTE Already connected at this stage
-    if (i2c_start(host_i2c, i2c_address, 0)) {
-        i2c_write(host_i2c, &cmd, 1);
-        if (do_stop) i2c_stop(host_i2c);
+    // An area that doesn't start on a band's bottom row
+    // takes its upper rows from the band above
+    const uint8_t* band = &display_buffer[(tile->y >> 3) * canvas_width + tile->x];
+    uint32_t shift = tile->y & 0x07;
+
+    for (uint32_t i = 0 ; i < 8 ; ++i) {
+        uint32_t column = band[i];
+        if (shift != 0) column |= (uint32_t)band[i + canvas_width] << 8;
+        tile_buffer[i] = (uint8_t)(column >> shift);
     }
 }
+
+
+/**
+ * @brief Rotate an 8x8 image. The image is handled as a single 64-bit
+ *        word, so each rotation is a transpose and/or a reflection
+ *        made with a few shifts and masks, rather than bit by bit.
+ *        FROM 1.2.0
+ *
+ * @param in_buffer:  The 8 columns of the image.
+ * @param out_buffer: A buffer for the 8 columns of the rotated image.
+ *                    Must not be `in_buffer`.
+ * @param angle:      The angle of rotation as an integer multiple of 90 degrees.
+ */
+static void HT16K33_rotate(const uint8_t* in_buffer, uint8_t* out_buffer, uint8_t angle) {
+
+    // Column n is byte n of the word, so pixel x,y is bit 8x + y
+    uint64_t bits = 0;
+    for (uint32_t i = 0 ; i < 8 ; ++i) bits |= (uint64_t)in_buffer[i] << (i << 3);
+
+    switch (angle & 0x03) {
+        case HT16K33_90_DEG:
+            // Transpose, then reverse the order of the columns
+            bits = __builtin_bswap64(HT16K33_transpose(bits));
+            break;
+        case HT16K33_180_DEG:
+            // Reverse the order of the columns and of the pixels in each
+            bits = __builtin_bswap64(HT16K33_reverse_bytes(bits));
+            break;
+        case HT16K33_270_DEG:
+            // Transpose, then reverse the order of the pixels in each column
+            bits = HT16K33_reverse_bytes(HT16K33_transpose(bits));
+    }
+
+    for (uint32_t i = 0 ; i < 8 ; ++i) out_buffer[i] = (uint8_t)(bits >> (i << 3));
+}
+
+
+/**
+ * @brief Transpose an 8x8 bit matrix held as a 64-bit word, ie.
+ *        swap bit 8x + y with bit 8y + x, by swapping ever larger
+ *        blocks across the diagonal (Hacker's Delight, 7-3).
+ *        FROM 1.2.0
+ *
+ * @param bits: The matrix.
+ *
+ * @retval The transposed matrix.
+ */
+static inline uint64_t HT16K33_transpose(uint64_t bits) {
+
+    uint64_t t = (bits ^ (bits >> 7)) & 0x00AA00AA00AA00AAULL;
+    bits ^= t ^ (t << 7);
+    t = (bits ^ (bits >> 14)) & 0x0000CCCC0000CCCCULL;
+    bits ^= t ^ (t << 14);
+    t = (bits ^ (bits >> 28)) & 0x00000000F0F0F0F0ULL;
+    bits ^= t ^ (t << 28);
+    return bits;
+}
+
+
+/**
+ * @brief Reverse the order of the bits in each byte of a 64-bit word.
+ *        FROM 1.2.0
+ *
+ * @param bits: The word.
+ *
+ * @retval The reflected word.
+ */
+static inline uint64_t HT16K33_reverse_bytes(uint64_t bits) {
+
+    bits = ((bits >> 1) & 0x5555555555555555ULL) | ((bits & 0x5555555555555555ULL) << 1);
+    bits = ((bits >> 2) & 0x3333333333333333ULL) | ((bits & 0x3333333333333333ULL) << 2);
+    bits = ((bits >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((bits & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return bits;
+}
@@ -43,21 +43,45 @@
 #define     HT16K33_180_DEG                 2
 #define     HT16K33_270_DEG                 3
 
+// FROM 1.2.0
+// HT16K33s take addresses 0x70-0x77, so a bus can hold eight
+#define     HT16K33_TILES_MAX               8
+#define     HT16K33_CANVAS_MAX_B            64
+
+
+/*
+ * STRUCTURES
+ */
+// FROM 1.2.0
+// A matrix showing an 8x8 area of the canvas
+typedef struct {
+    uint8_t     address;                // The matrix's I2C address
+    uint8_t     x;                      // The canvas column shown in the matrix's column 0
+    uint8_t     y;                      // The canvas row shown in the matrix's row 0
+    uint8_t     angle;                  // The matrix's orientation, relative to the others
+    uint8_t     sent_buffer[17];        // The display RAM as last written
+    bool        is_sent_buffer_valid;
+} HT16K33Tile;
+
 
 /*
  * PROTOTYPES
  */
-void        HT16K33_init(I2CDriver *sd, int address, uint8_t angle);
+void        HT16K33_init(I2CDriver *sd, uint8_t angle);
 void        HT16K33_power(bool is_on);
 void        HT16K33_set_angle(uint8_t angle);
-void        HT16K33_draw(bool do_stop);
+bool        HT16K33_draw(bool do_stop);
 void        HT16K33_clear_buffer(void);
 void        HT16K33_set_brightness(uint8_t brightness);
 void        HT16K33_plot(uint8_t x, uint8_t y, bool is_set);
 void        HT16K33_print(const char *text, uint32_t delay_ms);
-void        HT16K33_rotate(uint8_t angle);
-void        HT16K33_set_char(uint8_t ascii, bool is_centred);
-void        HT16K33_set_glyph(uint8_t* bytes);
+bool        HT16K33_set_char(uint8_t ascii, bool is_centred);
+void        HT16K33_set_glyph(const uint8_t* bytes, size_t length);
+// FROM 1.2.0
+const I2CHistogram* HT16K33_get_jitter(void);
+bool        HT16K33_add_tile(int address, int x, int y, uint8_t angle);
+size_t      HT16K33_get_size(uint32_t* width, uint32_t* height);
+bool        HT16K33_set_font(const char* path);
 
 
 #endif  // _HT16K33_MATRIX_HEADER_
@@ -13,6 +13,9 @@
  * STATIC PROTOTYPES
  */
 static int          matrix_commands(I2CDriver* sd, int argc, char* argv[], int delta);
+static bool         matrix_draw_frame(I2CDriver* sd, const uint8_t* frame);
+static bool         matrix_add_tile(char* spec);
+static void         show_jitter(const I2CHistogram* jitter);
 static void         show_help(void);
 static inline void  show_version(void);
 
@@ -21,7 +24,7 @@ static inline void  show_version(void);
  * GLOBALS
  */
 // Hold an I2C data structure
-I2CDriver i2c;
+I2CDriver* i2c = NULL;
 
 
 /**
@@ -29,9 +32,6 @@ I2CDriver i2c;
  */
 int main(int argc, char* argv[]) {
 
-    // Listen for SIGINT
-    signal(SIGINT, ctrl_c_handler);
-
     // Process arguments
     if (argc < 2) {
         // Insufficient arguments -- issue usage info and bail
@@ -57,13 +57,15 @@ int main(int argc, char* argv[]) {
 
         // Connect... with the device path
         int i2c_address = HT16K33_I2C_ADDR;
-        i2c.port = -1;
-        i2c_connect(&i2c, argv[1]);
-        if (i2c.connected) {
+        i2c = i2c_open(argv[1]);
+        if (i2c != NULL) {
+            // Listen for SIGINT
+            set_ctrl_c_handler(i2c);
+
             // Initialize the I2C host's I2C bus
-            if (!(i2c_init(&i2c))) {
+            if (!(i2c_init(i2c))) {
                 print_error("%s could not initialise I2C", argv[1]);
-                flush_and_close_port(i2c.port);
+                i2c_close(i2c);
                 return EXIT_ERR;
             }
 
@@ -78,7 +80,7 @@ int main(int argc, char* argv[]) {
                     // Only allow legal I2C address range
                     if (i2c_address < 0x08 || i2c_address > 0x77) {
                         print_error("I2C address out of range");
-                        flush_and_close_port(i2c.port);
+                        i2c_close(i2c);
                         return EXIT_ERR;
                     }
 
@@ -87,25 +89,163 @@ int main(int argc, char* argv[]) {
                 }
 
                 // Set up the display driver
-                HT16K33_init(&i2c, i2c_address, HT16K33_0_DEG);
+                HT16K33_init(i2c, HT16K33_0_DEG);
+
+                // FROM 1.2.0
+                // Check for stream and tile options, which precede the commands
+                bool has_tiles = false;
+                bool do_stream = false;
+                bool is_binary = false;
+                uint32_t fps = STREAM_FPS_DEFAULT;
+                while (argc > delta && strncmp(argv[delta], "--", 2) == 0) {
+                    if (strcasecmp(argv[delta], "--stream") == 0) {
+                        do_stream = true;
+                        delta += 1;
+                    } else if (strcasecmp(argv[delta], "--fps") == 0 && argc > delta + 1) {
+                        fps = (uint32_t)strtol(argv[delta + 1], NULL, 0);
+                        delta += 2;
+                    } else if (strcasecmp(argv[delta], "--binary") == 0) {
+                        is_binary = true;
+                        delta += 1;
+                    } else if (strcasecmp(argv[delta], "--tile") == 0 && argc > delta + 1) {
+                        if (!matrix_add_tile(argv[delta + 1])) {
+                            i2c_close(i2c);
+                            return EXIT_ERR;
+                        }
+
+                        has_tiles = true;
+                        delta += 2;
+                    } else if (strcasecmp(argv[delta], "--stats") == 0) {
+                        i2c_enable_stats(i2c);
+                        delta += 1;
+                    } else if (strcasecmp(argv[delta], "--font") == 0 && argc > delta + 1) {
+                        if (!HT16K33_set_font(argv[delta + 1])) {
+                            i2c_close(i2c);
+                            return EXIT_ERR;
+                        }
+
+                        delta += 2;
+                    } else {
+                        print_error("Unknown option: %s", argv[delta]);
+                        i2c_close(i2c);
+                        return EXIT_ERR;
+                    }
+                }
+
+                // With no tiles specified, drive a single matrix
+                if (!has_tiles) HT16K33_add_tile(i2c_address, 0, 0, HT16K33_0_DEG);
+
+                int result = EXIT_OK;
+                if (argc > delta && strcmp(argv[delta], "-") == 0) {
+                    // FROM 1.2.0
+                    // Process commands from a script file or stdin
+                    result = process_script(i2c, (argc > delta + 1 ? argv[delta + 1] : NULL), matrix_commands);
+                } else if (argc > delta) {
+                    // Process the commands one by one
+                    result = matrix_commands(i2c, argc, argv, delta);
+                }
+
+                // FROM 1.2.0
+                // Show frames from stdin, after any commands
+                if (do_stream && result == EXIT_OK) {
+                    result = process_stream(i2c, HT16K33_get_size(NULL, NULL), fps, is_binary, NULL, matrix_draw_frame);
+                }
+
+                // FROM 1.2.0
+                // Show bus and scroll timings
+                if (i2c_get_stats(i2c) != NULL) {
+                    i2c_stats_print(i2c_get_stats(i2c), stderr);
+                    show_jitter(HT16K33_get_jitter());
+                }
+
+                i2c_close(i2c);
 
-                // Process the commands one by one
-                int result =  matrix_commands(&i2c, argc, argv, delta);
-                flush_and_close_port(i2c.port);
                 return result;
             } else {
                 fprintf(stderr, "No commands supplied... exiting\n");
-                flush_and_close_port(i2c.port);
+                i2c_close(i2c);
                 return EXIT_OK;
             }
         }
     }
     
-    if (i2c.port != -1) flush_and_close_port(i2c.port);
     return EXIT_ERR;
 }
 
 
+/**
+ * @brief Show a frame from a stream: a byte per column of the
+ *        canvas, as `g` takes them.
+ *        FROM 1.2.0
+ *
+ * @param sd:    An I2C driver data structure.
+ * @param frame: The frame.
+ *
+ * @retval Whether the frame was shown (`true`) or not (`false`).
+ */
+static bool matrix_draw_frame(I2CDriver* sd, const uint8_t* frame) {
+
+    HT16K33_set_glyph(frame, HT16K33_get_size(NULL, NULL));
+    return HT16K33_draw(true);
+}
+
+
+/**
+ * @brief Add a matrix to the canvas, as specified by a `--tile`
+ *        option's argument: `{address}[,{x},{y}[,{angle}]]`.
+ *        FROM 1.2.0
+ *
+ * @param spec: The option's argument.
+ *
+ * @retval Whether the matrix was added (`true`) or not (`false`).
+ */
+static bool matrix_add_tile(char* spec) {
+
+    // Address, x, y, angle. By default, a matrix
+    // goes to the right of those already added
+    long values[4] = { 0, -1, -1, HT16K33_0_DEG };
+    size_t count = 0;
+    char* cursor = spec;
+    bool is_valid = false;
+
+    while (true) {
+        char* endptr = cursor;
+        values[count++] = strtol(cursor, &endptr, 0);
+        if (endptr == cursor) break;
+        if (*endptr == '\0') {
+            // X and y come as a pair
+            is_valid = (count != 2);
+            break;
+        }
+
+        if (*endptr != ',' || count == 4) break;
+        cursor = endptr + 1;
+    }
+
+    if (!is_valid || values[1] > 255 || values[2] > 255) {
+        print_error("Invalid matrix: %s", spec);
+        return false;
+    }
+
+    return HT16K33_add_tile((int)values[0], (int)values[1], (int)values[2], (uint8_t)values[3]);
+}
+
+
+/**
+ * @brief Show how late scrolled frames were drawn.
+ *        FROM 1.2.0
+ *
+ * @param jitter: The histogram of lateness.
+ */
+static void show_jitter(const I2CHistogram* jitter) {
+
+    if (jitter->count == 0) return;
+    fprintf(stderr, "Scroll lateness over %" PRIu64 " frames: mean %" PRIu64 "us, p50 %uus, p99 %uus, max %uus\n",
+            jitter->count, jitter->total_us / jitter->count,
+            i2c_stats_percentile(jitter, 50.0), i2c_stats_percentile(jitter, 99.0), jitter->max_us);
+}
+
+
 /**
  * @brief Parse and process commands for the HT16K33-based matrix.
  *
@@ -183,8 +323,9 @@ static int matrix_commands(I2CDriver* i2c, int argc, char* argv[], int delta) {
                         if (command[0] >= '0' && command[0] <= '9') {
                             uint8_t achar = (uint8_t)strtol(command, NULL, 0);
                         
-                            if (achar < 32 || achar > 127) {
-                                print_error("Character out of range (Ascii 32-127)");
+                            // FROM 1.2.0 -- Loaded fonts may cover Ascii 32-255
+                            if (achar < 32) {
+                                print_error("Character out of range (Ascii 32-255)");
                                 return EXIT_ERR;
                             }
 
@@ -200,7 +341,11 @@ static int matrix_commands(I2CDriver* i2c, int argc, char* argv[], int delta) {
                             }
 
                             // Perform the action
-                            HT16K33_set_char(achar, do_centre);
+                            if (!HT16K33_set_char(achar, do_centre)) {
+                                print_error("Character %i is not in the font", achar);
+                                return EXIT_ERR;
+                            }
+
                             do_draw = true;
                             break;
                         }
@@ -218,11 +363,13 @@ static int matrix_commands(I2CDriver* i2c, int argc, char* argv[], int delta) {
                     if (i < argc - 1) {
                         command = argv[++i];
                         if (command[0] == '0' && command[1] == 'x') {
-                            uint8_t bytes[8] = {0};
+                            // FROM 1.2.0 -- a byte per column of the canvas
+                            uint8_t bytes[HT16K33_CANVAS_MAX_B] = {0};
+                            size_t size = HT16K33_get_size(NULL, NULL);
                             char *endptr = command;
                             size_t length = 0;
 
-                            while (length < sizeof(bytes)) {
+                            while (length < size) {
                                 bytes[length++] = (uint8_t)strtol(endptr, &endptr, 0);
                                 if (*endptr == '\0') break;
                                 if (*endptr != ',') {
@@ -234,7 +381,7 @@ static int matrix_commands(I2CDriver* i2c, int argc, char* argv[], int delta) {
                             }
 
                             // Perform the action
-                            HT16K33_set_glyph(bytes);
+                            HT16K33_set_glyph(bytes, size);
                             do_draw = true;
                             break;
                         }
@@ -259,8 +406,11 @@ static int matrix_commands(I2CDriver* i2c, int argc, char* argv[], int delta) {
                                 if (command[0] >= '0' && command[0] <= '9') {
                                     y = strtol(command, NULL, 0);
 
-                                    if (x < 0 || x > 7 || y < 0 || y > 7) {
-                                        print_error("Co-ordinate out of range (0-7)");
+                                    // FROM 1.2.0 -- co-ordinates are on the canvas
+                                    uint32_t width = 0, height = 0;
+                                    HT16K33_get_size(&width, &height);
+                                    if (x < 0 || x >= width || y < 0 || y >= height) {
+                                        print_error("Co-ordinate out of range (0-%u, 0-%u)", width - 1, height - 1);
                                         return EXIT_ERR;
                                     }
 
@@ -307,7 +457,6 @@ static int matrix_commands(I2CDriver* i2c, int argc, char* argv[], int delta) {
                     
                     // Perform the action
                     HT16K33_set_angle((uint8_t)angle);
-                    HT16K33_rotate((uint8_t)angle);
                 }
                 break;
 
@@ -371,11 +520,31 @@ static int matrix_commands(I2CDriver* i2c, int argc, char* argv[], int delta) {
  */
 static void show_help(void) {
     
-    fprintf(stderr, "matrix {device} [address] [commands]\n\n");
+    fprintf(stderr, "matrix {device} [address] [options] [commands]\n\n");
     fprintf(stderr, "Usage:\n");
     fprintf(stderr, "  {device} is a mandatory device path, eg. /dev/cu.usbmodem-010101.\n");
     fprintf(stderr, "  [address] is an optional display I2C address. Default: 0x70.\n");
+    fprintf(stderr, "  [options] are optional settings, as shown below.\n");
+    fprintf(stderr, "  Pass - in place of [commands] to read them, one command sequence per line,\n");
+    fprintf(stderr, "  from stdin, or pass - {path} to read them from a file.\n");
     fprintf(stderr, "  [commands] are optional HT16K33 matrix commands:\n\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --stream               After any commands, draw frames read from stdin: one per line,\n");
+    fprintf(stderr, "                         in the form g takes. If frames arrive faster than they can be\n");
+    fprintf(stderr, "                         drawn, only the latest is drawn.\n");
+    fprintf(stderr, "  --fps {rate}           The rate at which to draw streamed frames, or 0 to draw them as\n");
+    fprintf(stderr, "                         fast as possible. Default: %i.\n", STREAM_FPS_DEFAULT);
+    fprintf(stderr, "  --binary               Streamed frames are raw bytes, not text.\n");
+    fprintf(stderr, "  --tile {address}[,{x},{y}[,{angle}]]\n");
+    fprintf(stderr, "                         Add a matrix to a canvas spanning several. It shows the 8x8\n");
+    fprintf(stderr, "                         area whose bottom-left pixel is at {x},{y}: by default, the\n");
+    fprintf(stderr, "                         area right of the last matrix added. {angle} rotates it, as a\n");
+    fprintf(stderr, "                         multiple of 90 degrees, relative to the others. Repeat for each\n");
+    fprintf(stderr, "                         matrix, up to %i. Replaces [address].\n", HT16K33_TILES_MAX);
+    fprintf(stderr, "  --stats                On exit, show response latencies for each type of command,\n");
+    fprintf(stderr, "                         and how late scrolled frames were drawn.\n");
+    fprintf(stderr, "  --font {path}          Draw characters and text with a BDF or PSF font of up to eight\n");
+    fprintf(stderr, "                         rows, in place of the built-in font.\n\n");
     fprintf(stderr, "Commands:\n");
     fprintf(stderr, "  a [on|off]             Activate/deactivate the display. Default: on.\n");
     fprintf(stderr, "  b {0-15}               Set the display brightness from low (0) to high (15).\n");
@@ -384,9 +553,10 @@ static void show_help(void) {
     fprintf(stderr, "                         set it to be centred (true).\n");
     fprintf(stderr, "  g {glyph}              Draw the user-defined character on the screen. The definition\n");
     fprintf(stderr, "                         is a string of eight comma-separated 8-bit hex values, eg.\n");
-    fprintf(stderr, "                         '0x3C,0x42,0xA9,0x85,0x85,0xA9,0x42,0x3C'.\n");
+    fprintf(stderr, "                         '0x3C,0x42,0xA9,0x85,0x85,0xA9,0x42,0x3C', one per column.\n");
+    fprintf(stderr, "                         On a canvas, pass one per column, band of eight rows by band.\n");
     fprintf(stderr, "  p {x} {y} [1|0]        Set or clear the specified pixel. X and Y coordinates are in\n");
-    fprintf(stderr, "                         the range 0-7.\n");
+    fprintf(stderr, "                         the range 0-7, or span the canvas.\n");
     fprintf(stderr, "  t {string} [delay]     Scroll the specified string. The second argument is an optional\n");
     fprintf(stderr, "                         delay be between column shifts in milliseconds. Default: 250ms.\n");
     fprintf(stderr, "  w                      Wipe (clear) the display.\n");
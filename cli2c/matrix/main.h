@@ -15,6 +15,7 @@
  */
 #include "i2cdriver.h"
 #include "utils.h"
+#include "ht16k33-font.h"
 #include "ht16k33-matrix.h"
 
 
@@ -13,7 +13,6 @@
  * STATIC PROTOYPYES
  */
 static uint32_t bcd(uint32_t base);
-static void     HT16K33_sleep_ms(int ms);
 static void     HT16K33_write_cmd(uint8_t cmd, bool do_stop);
 
 
@@ -32,6 +31,12 @@ bool is_flipped = false;
 I2CDriver* host_i2c;
 int i2c_address = HT16K33_I2C_ADDR;
 
+// FROM 1.2.0
+// The LED's display RAM as last written, so that `HT16K33_draw()`
+// need only send the bytes that have changed
+uint8_t sent_buffer[17] = {0};
+bool is_sent_buffer_valid = false;
+
 
 /**
  * @brief Set up the data the driver needs.
@@ -98,34 +103,69 @@ void HT16K33_clear_buffer(void) {
 
 /**
  * @brief Write the display buffer out to the LED.
+ *
+ * @param do_stop: Whether to end the transaction with a STOP.
+ *
+ * @retval Whether the LED ACK'd the write (`true`) or not (`false`).
  */
-void HT16K33_draw(bool do_stop) {
+bool HT16K33_draw(bool do_stop) {
+
+    // FROM 1.2.0 -- flip a copy of the buffer, so the buffer itself
+    //               keeps its orientation from draw to draw
+    uint8_t out_buffer[17];
+    memcpy(out_buffer, display_buffer, sizeof(out_buffer));
 
     // Check for an overturned LED
     if (is_flipped) {
         // Swap digits 0,3 and 1,2
-        uint8_t a = display_buffer[POS[0]];
-        display_buffer[POS[0]] = display_buffer[POS[3]];
-        display_buffer[POS[3]] = a;
+        uint8_t a = out_buffer[POS[0]];
+        out_buffer[POS[0]] = out_buffer[POS[3]];
+        out_buffer[POS[3]] = a;
 
-        a = display_buffer[POS[1]];
-        display_buffer[POS[1]] = display_buffer[POS[2]];
-        display_buffer[POS[2]] = a;
+        a = out_buffer[POS[1]];
+        out_buffer[POS[1]] = out_buffer[POS[2]];
+        out_buffer[POS[2]] = a;
 
         // Rotate each digit
         for (uint32_t i = 0 ; i < 4 ; ++i) {
-            a = display_buffer[POS[i]];
+            a = out_buffer[POS[i]];
             uint8_t b = (a & 0x07) << 3;
             uint8_t c = (a & 0x38) >> 3;
             a &= 0xC0;
-            display_buffer[POS[i]] = (a | b | c);
+            out_buffer[POS[i]] = (a | b | c);
         }
     }
 
     // Display the buffer and flash the LED
+    // FROM 1.2.0 -- pipeline the ops to save round trips, and
+    //               send only the bytes that have changed
+    uint32_t first = 1;
+    uint32_t last = 16;
+    if (is_sent_buffer_valid) {
+        while (first <= last && out_buffer[first] == sent_buffer[first]) first++;
+        while (last > first && out_buffer[last] == sent_buffer[last]) last--;
+
+        // Nothing has changed: there's nothing to send unless we
+        // need to end the transaction, so just set the RAM address
+        if (first > last) {
+            if (!do_stop) return true;
+            first = 1;
+            last = 0;
+        }
+    }
+
+    // Prefix the span with its RAM address
+    uint8_t tx_buffer[17];
+    tx_buffer[0] = (uint8_t)(first - 1);
+    memcpy(&tx_buffer[1], &out_buffer[first], last - first + 1);
+
+    i2c_pipeline_begin(host_i2c);
     i2c_start(host_i2c, i2c_address, 0);
-    i2c_write(host_i2c, display_buffer, 17);
+    i2c_write(host_i2c, tx_buffer, last - first + 2);
     if (do_stop) i2c_stop(host_i2c);
+    memcpy(&sent_buffer[first], &out_buffer[first], last - first + 1);
+    is_sent_buffer_valid = i2c_pipeline_end(host_i2c);
+    return is_sent_buffer_valid;
 }
 
 
@@ -270,30 +310,6 @@ static uint32_t bcd(uint32_t base) {
 }
 
 
-/**
- * @brief Sleep the thread for the specified period in milliseconds.
- *
- * @param ms: The sleep period.
- */
-static void HT16K33_sleep_ms(int ms) {
-
-    // FROM 1.1.2
-    // New, better alogrithm
-    long delta = 0;
-    struct timespec now, then;
-    clock_gettime(CLOCK_MONOTONIC_RAW, &then);
-    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-    while (now.tv_nsec - then.tv_nsec < ms * 1000000 - delta) {
-        clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-        if (now.tv_nsec < then.tv_nsec) {
-            // Roll over
-            delta = LONG_MAX - then.tv_nsec;
-            then.tv_nsec = 0;
-        }
-    }
-}
-
-
 /**
  * @brief Issue a single command byte to the HT16K33.
  *
@@ -303,8 +319,10 @@ static void HT16K33_sleep_ms(int ms) {
 static void HT16K33_write_cmd(uint8_t cmd, bool do_stop) {
 
     // NOTE Already connected at this stage
-    if (i2c_start(host_i2c, i2c_address, 0)) {
-        i2c_write(host_i2c, &cmd, 1);
-        if (do_stop) i2c_stop(host_i2c);
-    }
+    // FROM 1.2.0 -- pipeline the ops to save round trips
+    i2c_pipeline_begin(host_i2c);
+    i2c_start(host_i2c, i2c_address, 0);
+    i2c_write(host_i2c, &cmd, 1);
+    if (do_stop) i2c_stop(host_i2c);
+    i2c_pipeline_end(host_i2c);
 }
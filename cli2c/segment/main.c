@@ -13,6 +13,8 @@
  * STATIC PROTOTYPES
  */
 static int          segment_commands(I2CDriver* sd, int argc, char* argv[], int delta);
+static bool         segment_parse_value(char* line, uint8_t* frame, size_t frame_size);
+static bool         segment_draw_value(I2CDriver* sd, const uint8_t* frame);
 static void         show_help(void);
 static inline void  show_version(void);
 
@@ -21,7 +23,7 @@ static inline void  show_version(void);
  * GLOBALS
  */
 // Hold an I2C data structure
-I2CDriver i2c;
+I2CDriver* i2c = NULL;
 
 
 /**
@@ -29,13 +31,10 @@ I2CDriver i2c;
  */
 int main(int argc, char* argv[]) {
 
-    // Listen for SIGINT
-    signal(SIGINT, ctrl_c_handler);
-
     // Process arguments
     if (argc < 2) {
         // Insufficient arguments -- issue usage info and bail
-        fprintf(stderr, "Usage: segment {DEVICE_PATH} [I2C Address] [command] ... [command]\n");
+        fprintf(stderr, "Usage: segment {DEVICE_PATH} [I2C Address] [options] [command] ... [command]\n");
         return EXIT_OK;
     } else {
         // Check for a help request
@@ -57,12 +56,15 @@ int main(int argc, char* argv[]) {
 
         // Connect... with the device path
         int i2c_address = HT16K33_I2C_ADDR;
-        i2c_connect(&i2c, argv[1]);
-        if (i2c.connected) {
+        i2c = i2c_open(argv[1]);
+        if (i2c != NULL) {
+            // Listen for SIGINT
+            set_ctrl_c_handler(i2c);
+
             // Initialize the I2C host's I2C bus
-            if (!(i2c_init(&i2c))) {
+            if (!(i2c_init(i2c))) {
                 print_error("%s could not initialise I2C", argv[1]);
-                flush_and_close_port(i2c.port);
+                i2c_close(i2c);
                 return EXIT_ERR;
             }
 
@@ -77,7 +79,7 @@ int main(int argc, char* argv[]) {
                     // Only allow legal I2C address range
                     if (i2c_address < 0x08 || i2c_address > 0x77) {
                         print_error("I2C address out of range");
-                        flush_and_close_port(i2c.port);
+                        i2c_close(i2c);
                         return EXIT_ERR;
                     }
 
@@ -85,26 +87,181 @@ int main(int argc, char* argv[]) {
                     delta = 3;
                 }
 
+                // FROM 1.2.0
+                // Check for stream options, which precede the commands
+                bool do_stream = false;
+                uint32_t fps = STREAM_FPS_DEFAULT;
+                while (argc > delta && strncmp(argv[delta], "--", 2) == 0) {
+                    if (strcasecmp(argv[delta], "--stream") == 0) {
+                        do_stream = true;
+                        delta += 1;
+                    } else if (strcasecmp(argv[delta], "--fps") == 0 && argc > delta + 1) {
+                        fps = (uint32_t)strtol(argv[delta + 1], NULL, 0);
+                        delta += 2;
+                    } else {
+                        print_error("Unknown option: %s", argv[delta]);
+                        i2c_close(i2c);
+                        return EXIT_ERR;
+                    }
+                }
+
                 // Set up the display driver
-                HT16K33_init(&i2c, i2c_address);
+                HT16K33_init(i2c, i2c_address);
+
+                int result;
+                if (argc > delta && strcmp(argv[delta], "-") == 0) {
+                    // FROM 1.2.0
+                    // Process commands from a script file or stdin
+                    result = process_script(i2c, (argc > delta + 1 ? argv[delta + 1] : NULL), segment_commands);
+                } else {
+                    // Process the commands one by one
+                    result = segment_commands(i2c, argc, argv, delta);
+                }
+
+                // FROM 1.2.0
+                // Show values from stdin, after any commands
+                if (do_stream && result == EXIT_OK) {
+                    result = process_stream(i2c, sizeof(SegmentValue), fps, false, segment_parse_value, segment_draw_value);
+                }
 
-                // Process the commands one by one
-                int result =  segment_commands(&i2c, argc, argv, delta);
-                flush_and_close_port(i2c.port);
+                i2c_close(i2c);
                 return result;
             } else {
                 fprintf(stderr, "No commands supplied... exiting\n");
-                flush_and_close_port(i2c.port);
+                i2c_close(i2c);
                 return EXIT_OK;
             }
         } 
     }
 
-    if (i2c.port != -1) flush_and_close_port(i2c.port);
     return EXIT_ERR;
 }
 
 
+/**
+ * @brief Read a value from a stream: a decimal integer (-999 to 9999),
+ *        a fixed-point number, eg. `-1.5` or `12.34`, or a hex value
+ *        (`0x0000` to `0xFFFF`). Fixed-point values are rounded to the
+ *        decimal places the display has room for.
+ *        FROM 1.2.0
+ *
+ * @param line:       The line of text.
+ * @param frame:      A buffer for the value, as a SegmentValue.
+ * @param frame_size: The size of the buffer.
+ *
+ * @retval Whether the line holds a value (`true`) or not (`false`).
+ */
+static bool segment_parse_value(char* line, uint8_t* frame, size_t frame_size) {
+
+    SegmentValue value = { 0, SEGMENT_VALUE_DECIMAL, 0 };
+    char* endptr = line;
+    bool is_valid = false;
+
+    if (line[0] == '0' && (line[1] == 'x' || line[1] == 'X')) {
+        long number = strtol(line, &endptr, 16);
+        is_valid = (endptr > line + 2 && number >= 0 && number <= 0xFFFF);
+        value.value = (int32_t)number;
+        value.format = SEGMENT_VALUE_HEX;
+    } else if (strchr(line, '.') == NULL) {
+        long number = strtol(line, &endptr, 10);
+        is_valid = (endptr > line && number >= -999 && number <= 9999);
+        value.value = (int32_t)number;
+    } else {
+        // Fixed point: get the integer part...
+        bool is_neg = (*endptr == '-');
+        if (is_neg) endptr++;
+
+        int32_t limit = is_neg ? 1000 : 10000;
+        int32_t whole = 0;
+        bool has_digits = false;
+        while (isdigit((unsigned char)*endptr)) {
+            if (whole < limit) whole = whole * 10 + (*endptr - '0');
+            has_digits = true;
+            endptr++;
+        }
+
+        // ...then as many decimal places as will fit, rounding the rest
+        int32_t max_places = 4 - (is_neg ? 1 : 0) - 1;
+        for (int32_t a = whole / 10 ; a > 0 ; a /= 10) max_places--;
+
+        int32_t scaled = whole;
+        int32_t places = 0;
+        bool has_rounded = false;
+        if (*endptr == '.') endptr++;
+        while (isdigit((unsigned char)*endptr)) {
+            if (places < max_places) {
+                scaled = scaled * 10 + (*endptr - '0');
+                places++;
+            } else if (!has_rounded) {
+                if (*endptr >= '5') scaled++;
+                has_rounded = true;
+            }
+
+            has_digits = true;
+            endptr++;
+        }
+
+        // Rounding up may need another digit, eg. 9.999 -> 10.00
+        if (scaled >= limit && places > 0) {
+            scaled /= 10;
+            places--;
+        }
+
+        is_valid = (has_digits && scaled < limit);
+        value.value = is_neg ? -scaled : scaled;
+        value.format = SEGMENT_VALUE_FIXED;
+        value.places = (uint8_t)places;
+    }
+
+    if (!is_valid || *endptr != '\0') {
+        print_warning("Invalid value: %s", line);
+        return false;
+    }
+
+    memcpy(frame, &value, sizeof(SegmentValue));
+    return true;
+}
+
+
+/**
+ * @brief Show a value read from a stream across the display.
+ *        FROM 1.2.0
+ *
+ * @param sd:    An I2C driver data structure.
+ * @param frame: The value, as a SegmentValue.
+ *
+ * @retval Whether the value was shown (`true`) or not (`false`).
+ */
+static bool segment_draw_value(I2CDriver* sd, const uint8_t* frame) {
+
+    SegmentValue value;
+    memcpy(&value, frame, sizeof(SegmentValue));
+
+    if (value.format == SEGMENT_VALUE_HEX) {
+        for (uint8_t i = 0 ; i < 4 ; ++i) {
+            HT16K33_set_number((value.value >> (12 - (i << 2))) & 0x0F, i, false);
+        }
+    } else if (value.format == SEGMENT_VALUE_FIXED && value.places > 0) {
+        // As `HT16K33_show_value()`, but with the point where it's needed
+        uint32_t magnitude = (value.value < 0) ? -value.value : value.value;
+        uint8_t first = 0;
+        if (value.value < 0) {
+            HT16K33_set_char('-', 0, false);
+            first = 1;
+        }
+
+        for (int8_t i = 3 ; i >= first ; --i) {
+            HT16K33_set_number(magnitude % 10, i, i == 3 - value.places);
+            magnitude /= 10;
+        }
+    } else {
+        HT16K33_show_value(value.value, false);
+    }
+
+    return HT16K33_draw(true);
+}
+
+
 /**
  * @brief Parse and process commands for the HT16K33-based matrix.
  *
@@ -424,11 +581,21 @@ static int segment_commands(I2CDriver* i2c, int argc, char* argv[], int delta) {
  */
 static void show_help(void) {
     
-    fprintf(stderr, "segment {device} [address] [commands]\n\n");
+    fprintf(stderr, "segment {device} [address] [options] [commands]\n\n");
     fprintf(stderr, "Usage:\n");
     fprintf(stderr, "  {device} is a mandatory device path, eg. /dev/cu.usbmodem-010101.\n");
     fprintf(stderr, "  [address] is an optional display I2C address. Default: 0x70.\n");
+    fprintf(stderr, "  [options] are optional settings, as shown below.\n");
+    fprintf(stderr, "  Pass - in place of [commands] to read them, one command sequence per line,\n");
+    fprintf(stderr, "  from stdin, or pass - {path} to read them from a file.\n");
     fprintf(stderr, "  [commands] are optional HT16K33 segment commands.\n\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --stream                        After any commands, show values read from stdin, one\n");
+    fprintf(stderr, "                                  per line: decimal (-999 to 9999), fixed-point, eg. 12.34,\n");
+    fprintf(stderr, "                                  or hex (0x0000-0xFFFF). If values arrive faster than\n");
+    fprintf(stderr, "                                  they can be shown, only the latest is shown.\n");
+    fprintf(stderr, "  --fps {rate}                    The rate at which to show streamed values, or 0 to show\n");
+    fprintf(stderr, "                                  them as fast as possible. Default: %i.\n\n", STREAM_FPS_DEFAULT);
     fprintf(stderr, "Commands:\n");
     fprintf(stderr, "  a [on|off]                      Activate/deactivate the display. Default: on.\n");
     fprintf(stderr, "  b {0-15}                        Set the display brightness from low (0) to high (15).\n");
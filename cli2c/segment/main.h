@@ -18,4 +18,26 @@
 #include "ht16k33-segment.h"
 
 
+/*
+ * CONSTANTS
+ */
+// FROM 1.2.0
+// Formats of streamed values
+#define SEGMENT_VALUE_DECIMAL           0
+#define SEGMENT_VALUE_FIXED             1
+#define SEGMENT_VALUE_HEX               2
+
+
+/*
+ * STRUCTURES
+ */
+// FROM 1.2.0
+// A value read from a stream, as passed from parser to renderer
+typedef struct {
+    int32_t     value;                  // Scaled by 10^places for fixed-point values
+    uint8_t     format;                 // SEGMENT_VALUE_*
+    uint8_t     places;                 // Digits after the decimal point
+} SegmentValue;
+
+
 #endif      // _MAIN_H_
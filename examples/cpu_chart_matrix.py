@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 
 import signal
-from subprocess import run, TimeoutExpired, STDOUT
+from subprocess import run, Popen, PIPE
 from psutil import cpu_percent
 from sys import exit, argv
 from time import sleep
@@ -29,9 +29,10 @@ if len(argv) > 2:
     
 
 if device:
-    # Activate I2C on the host, clear the screen, and turn it on
-    run([app, device, i2c_address, "w", "a", "on", "b", "2"])
-        
+    # Open a single connection to the host: clear the screen, turn it
+    # on, then draw frames fed via stdin
+    host = Popen([app, device, i2c_address, "--stream", "w", "a", "on", "b", "2"], stdin=PIPE, text=True)
+
     while True:
         # Get the CPU percentage
         cpu = int(cpu_percent())
@@ -68,13 +69,9 @@ if device:
             data_string += "0x{:02x},".format(b)
         data_string = data_string[:-1]
         
-        try:
-            # Write out the display buffer
-            run([app, device, i2c_address, "g", data_string], timeout=90.0)
-        except TimeoutExpired:
-            print("Attempt to write data timed out")
-            exit(1)
-
+        # Write out the display buffer
+        host.stdin.write(data_string + "\n")
+        host.stdin.flush()
         sleep(1)
 else:
     print("Usage: python cpu_chart_matrix.py {device} {i2C address}")
@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 
 import signal
-from subprocess import run
+from subprocess import run, Popen, PIPE
 from psutil import cpu_percent
 from sys import exit, argv
 from time import sleep
@@ -26,13 +26,17 @@ if len(argv) > 2:
     i2c_address = argv[2]
 
 if device:
-    # Activate I2C on the host, clear the screen, and turn it on
-    run([app, device, i2c_address, "w", "a", "on", "b", "4"])
+    # Open a single connection to the host, fed with commands via stdin
+    host = Popen([app, device, i2c_address, "-"], stdin=PIPE, text=True)
+
+    # Clear the screen, and turn it on
+    host.stdin.write("w a on b 4\n")
 
     while True:
         # Get the CPU percentage and display it
         cpu = int(cpu_percent() * 10.0)
-        run([app, device, i2c_address, "n", str(cpu), "d", "2"])
+        host.stdin.write("n {} d 2\n".format(cpu))
+        host.stdin.flush()
         sleep(0.5)
 else:
     print("Usage: python cpu_chart_segment.py {device} {i2C address}")
@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 
 import signal
-from subprocess import run, PIPE
+from subprocess import run, Popen, PIPE
 from psutil import cpu_percent
 from sys import exit, argv
 from time import sleep
@@ -26,16 +26,21 @@ if len(argv) > 2:
     i2c_address = argv[2]
 
 if device:
+    # Open a single connection to the host, fed with commands via stdin
+    host = Popen([app, device, "-"], stdin=PIPE, stdout=PIPE, text=True)
+
     # Activate I2C on the host
-    run([app, device, "z"])
-    
+    host.stdin.write("z\n")
+
     # Loop and read the temperature from the MCP9808
     while True:
         # Read the MCP9808's ambient temperature measurement (two bytes from register 0x05)
-        result = run([app, device, "w", i2c_address, "0x05", "r", i2c_address, "2"], stdout=PIPE)
-        
+        host.stdin.write("w {0} 0x05 r {0} 2\n".format(i2c_address))
+        host.stdin.flush()
+        result = host.stdout.readline()
+
         # Convert the raw value to a Celsius reading
-        temp_raw = (int(result.stdout[0:2], 16) << 8) | int(result.stdout[2:], 16)
+        temp_raw = (int(result[0:2], 16) << 8) | int(result[2:4], 16)
         temp_col = (temp_raw & 0x0FFF) / 16.0
         if temp_raw & 0x10000: temp_col -= 256.0
         print(" Current temperature: {:.2f}°C\r".format(temp_col), end="")
@@ -15,6 +15,8 @@
  */
 static bool check_i2c_pins(uint8_t* data);
 static bool pin_check(uint8_t* pins, uint8_t pin);
+// FROM 1.2.0
+static void probe_i2c_bus(I2C_State* its, uint8_t first, uint8_t last, uint32_t timeout_us, uint8_t* bitmap);
 
 
 /*
@@ -149,31 +151,85 @@ bool configure_i2c(I2C_State* its, uint8_t* data) {
  */
 void send_i2c_scan(I2C_State* its) {
 
-    uint8_t rx_data;
-    int reading;
     char scan_buffer[1024] = {0};
-    uint32_t device_count = 0;;
+    uint32_t length = 0;
+
+    // FROM 1.2.0 -- Probe the bus once, then list the devices found
+    //               from the bitmap
+    uint8_t bitmap[SCAN_BITMAP_LENGTH_B] = {0};
+    probe_i2c_bus(its, 0x00, SCAN_ADDRESS_MAX, 1000, bitmap);
 
     // Generate a list if devices by their addresses.
     // List in the form "13.71.A0."
-    for (uint32_t i = 0 ; i < 0x78 ; ++i) {
-        reading = i2c_read_timeout_us(its->bus, i, &rx_data, 1, false, 1000);
-        if (reading > 0) {
-            sprintf(scan_buffer + (device_count * 3), "%02X.", i);
-            device_count++;
+    static const char hex_chars[] = "0123456789ABCDEF";
+    for (uint32_t i = 0 ; i <= SCAN_ADDRESS_MAX ; ++i) {
+        if (bitmap[i >> 3] & (1 << (i & 0x07))) {
+            scan_buffer[length++] = hex_chars[i >> 4];
+            scan_buffer[length++] = hex_chars[i & 0x0F];
+            scan_buffer[length++] = '.';
         }
     }
 
     // Write 'Z' if there are no devices,
     // or send the device list string
-    if (strlen(scan_buffer) == 0) {
-        sprintf(scan_buffer, "Z\r\n");
-    } else {
-        sprintf(scan_buffer + (device_count * 3), "\r\n");
-    }
+    if (length == 0) scan_buffer[length++] = 'Z';
+    scan_buffer[length++] = '\r';
+    scan_buffer[length++] = '\n';
 
     // Send the scan data back
-    tx(scan_buffer, strlen(scan_buffer));
+    tx((uint8_t*)scan_buffer, length);
+}
+
+
+/**
+ * @brief Scan a range of I2C addresses for devices, and send the
+ *        results as ACK and a 16-byte bitmap: bit (address & 7) of
+ *        byte (address >> 3) is set for each device found. Sends
+ *        ERR if the range is invalid.
+ *        FROM 1.2.0
+ *
+ * @param its:  The I2C state record.
+ * @param data: The command's parameters: first and last addresses,
+ *              then the probe timeout in microseconds (16 bits,
+ *              little-endian), or 0 for the default.
+ */
+void send_i2c_scan_bitmap(I2C_State* its, uint8_t* data) {
+
+    uint8_t first = data[0];
+    uint8_t last = data[1];
+    uint32_t timeout_us = data[2] | (data[3] << 8);
+    if (timeout_us == 0) timeout_us = SCAN_PROBE_TIMEOUT_US;
+
+    if (first > last || last > SCAN_ADDRESS_MAX) {
+        uint8_t err = ERR;
+        tx(&err, 1);
+        return;
+    }
+
+    uint8_t reply[SCAN_BITMAP_LENGTH_B + 1] = {ACK};
+    probe_i2c_bus(its, first, last, timeout_us, &reply[1]);
+    tx(reply, sizeof(reply));
+}
+
+
+/**
+ * @brief Probe a range of I2C addresses with single-byte reads,
+ *        and set a device's bit in a bitmap if it responds.
+ *        FROM 1.2.0
+ *
+ * @param its:        The I2C state record.
+ * @param first:      The first address to probe.
+ * @param last:       The last address to probe.
+ * @param timeout_us: The time to allow each probe.
+ * @param bitmap:     A zeroed buffer of SCAN_BITMAP_LENGTH_B bytes.
+ */
+static void probe_i2c_bus(I2C_State* its, uint8_t first, uint8_t last, uint32_t timeout_us, uint8_t* bitmap) {
+
+    uint8_t rx_data;
+    for (uint32_t i = first ; i <= last ; ++i) {
+        int reading = i2c_read_timeout_us(its->bus, i, &rx_data, 1, false, timeout_us);
+        if (reading > 0) bitmap[i >> 3] |= (1 << (i & 0x07));
+    }
 }
 
 
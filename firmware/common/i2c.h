@@ -33,6 +33,11 @@
 #define DEFAULT_I2C_BUS                         1
 #endif
 
+// FROM 1.2.0
+#define SCAN_ADDRESS_MAX                        0x77
+#define SCAN_BITMAP_LENGTH_B                    16
+#define SCAN_PROBE_TIMEOUT_US                   500
+
 
 /*
  * STRUCTURES
@@ -60,6 +65,7 @@ void    reset_i2c(I2C_State* itr);
 void    set_i2c_frequency(I2C_State* its, uint32_t frequency_khz);
 bool    configure_i2c(I2C_State* its, uint8_t* data);
 void    send_i2c_scan(I2C_State* itr);
+void    send_i2c_scan_bitmap(I2C_State* its, uint8_t* data);
 void    send_i2c_status(I2C_State* itr);
 bool    is_pin_in_use_by_i2c(I2C_State* its, uint8_t pin);
 
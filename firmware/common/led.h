@@ -11,6 +11,14 @@
 #define _HEADER_LED_
 
 
+/*
+ * INCLUDES
+ */
+// FROM 1.2.0 -- don't rely on the board's LED header for these
+#include <stdbool.h>
+#include <stdint.h>
+
+
 /*
  * CONSTANTS
  */
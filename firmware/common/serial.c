@@ -18,9 +18,12 @@ static void         sig_handler(int signal);
 // FROM 1.1.2 -- make ack and err sends inline
 static inline void  send_ack(void);
 static inline void  send_err(void);
-static uint32_t     rx(uint8_t *buffer);
+static uint32_t     rx(uint8_t *buffer, uint32_t max_bytes);
 // FROM 1.1.3
 static uint8_t      get_mode(char mode_key);
+// FROM 1.2.0
+static uint32_t     get_frame_length(uint8_t* frame, uint32_t available);
+static uint32_t     get_i2c_timeout_us(I2C_State* i2c_state, uint32_t byte_count);
 
 
 /*
@@ -31,6 +34,11 @@ static uint8_t      get_mode(char mode_key);
 extern uint8_t I2C_PIN_PAIRS_BUS_0[];
 extern uint8_t I2C_PIN_PAIRS_BUS_1[];
 
+// FROM 1.2.0
+// Buffers sized for long frames, kept off the stack
+static uint8_t rx_buffer[RX_BUFFER_LENGTH_B];
+static uint8_t i2c_long_rx_buffer[LONG_FRAME_LENGTH_MAX_B + 1];
+
 
 /**
  * @brief Listen on the USB-fed stdin for signals from the driver.
@@ -45,10 +53,20 @@ void rx_loop(void) {
     signal(SIGABRT | SIGSEGV | SIGBUS | SIGTRAP | SIGSYS, sig_handler);
 
     // Prepare a UART RX buffer
-    uint8_t rx_buffer[RX_BUFFER_LENGTH_B] = {0};
+    // FROM 1.2.0 -- now a static global, as it's large
     uint32_t read_count = 0;
     bool do_use_led = true;
 
+    // FROM 1.2.0
+    // Record the bytes of any incomplete frame held over
+    // from the previous pass, and when they arrived
+    uint32_t held_count = 0;
+    uint64_t last_rx = 0;
+
+    // FROM 1.2.0
+    // Bytes of an oversized frame still to arrive and be skipped
+    uint32_t discard_count = 0;
+
     // Prepare a transaction record with default data
     I2C_State i2c_state;
     i2c_state.is_started = false;                         // No transaction taking place
@@ -76,20 +94,45 @@ void rx_loop(void) {
     bool is_on = false;
 
     while(1) {
-        // Scan for input
-        read_count = rx(rx_buffer);
+        // Scan for input, appending it to any held-over bytes
+        read_count = rx(&rx_buffer[held_count], RX_BUFFER_LENGTH_B - held_count);
+        if (read_count > 0) last_rx = time_us_64();
+
+        // FROM 1.2.0
+        // The host may send several frames back to back, so process
+        // every complete frame we have. Frame lengths are implied by
+        // their leading bytes -- see `get_frame_length()`
+        uint32_t rx_count = held_count + read_count;
+        uint32_t offset = 0;
+        while (offset < rx_count) {
+            // Skip the rest of an oversized frame we've ERR'd
+            if (discard_count > 0) {
+                uint32_t skip_count = rx_count - offset;
+                if (skip_count > discard_count) skip_count = discard_count;
+                offset += skip_count;
+                discard_count -= skip_count;
+                continue;
+            }
+
+            uint8_t* rx_ptr = &rx_buffer[offset];
+            uint32_t frame_length = get_frame_length(rx_ptr, rx_count - offset);
+            if (offset + frame_length > rx_count) break;
+            offset += frame_length;
 
-        // Did we receive anything?
-        if (read_count > 0) {
             // Are we expecting write data or a read op next?
             // NOTE The first byte will always be:
             //      32-127  (ascii char as a command),
             //      128-191 (read 1-64 bytes), or
             //      192-255 (write 1-64 bytes)
-            uint8_t status_byte = rx_buffer[0];
-            uint8_t* rx_ptr = rx_buffer;
-
-            if (i2c_state.is_started && status_byte >= READ_LENGTH_BASE) {
+            uint8_t status_byte = rx_ptr[0];
+
+            if (status_byte >= READ_LENGTH_BASE && !i2c_state.is_started) {
+                // FROM 1.2.0
+                // Data or a read op outside of a transaction, eg. if the
+                // host pipelined them after a START that failed
+                last_error_code = I2C_NOT_STARTED;
+                send_err();
+            } else if (status_byte >= READ_LENGTH_BASE) {
                 // We have data or a read op
                 if (status_byte >= WRITE_LENGTH_BASE) {
                     // Write data received, so send it and ACK
@@ -99,7 +142,7 @@ void rx_loop(void) {
                     debug_log("Bytes to write: %i", i2c_state.write_byte_count);
 #endif
 
-                    int bytes_sent = i2c_write_timeout_us(i2c_state.bus, i2c_state.address, &rx_buffer[1], i2c_state.write_byte_count, false, 1000);
+                    int bytes_sent = i2c_write_timeout_us(i2c_state.bus, i2c_state.address, &rx_ptr[1], i2c_state.write_byte_count, false, 1000);
 
 #ifdef DO_UART_DEBUG
                     debug_log("Bytes sent: %i", bytes_sent);
@@ -145,7 +188,7 @@ void rx_loop(void) {
 
                     // FROM 1.1.0
                     case '*':   // SET LED STATE
-                        do_use_led = rx_buffer[1] == 1 ? true : false;
+                        do_use_led = rx_ptr[1] == 1 ? true : false;
 #ifdef SHOW_HEARTBEAT
                         send_ack();
 #else
@@ -165,6 +208,15 @@ void rx_loop(void) {
                         }
                         break;
 
+                    // FROM 1.2.0
+                    case '#':   // GET CAPABILITIES AND RX WINDOW SIZE
+                        {
+                            uint8_t caps_buffer[4] = {ACK, HOST_CAPABILITIES,
+                                                      (RX_BUFFER_LENGTH_B & 0xFF), (RX_BUFFER_LENGTH_B >> 8)};
+                            tx(caps_buffer, 4);
+                        }
+                        break;
+
                     // FROM 1.1.3
                     case '$':   // GET LAST ERROR
                         uint8_t err_buffer[3] = {(uint8_t)last_error_code, '\r', '\n'};
@@ -182,7 +234,7 @@ void rx_loop(void) {
                     case 'c':   // CONFIGURE THE BUS AND PINS
                         switch(current_mode) {
                             case MODE_I2C:
-                                if (configure_i2c(&i2c_state, &rx_buffer[1])) {
+                                if (configure_i2c(&i2c_state, &rx_ptr[1])) {
                                     send_ack();
                                 } else {
                                     last_error_code = GEN_CANT_CONFIG_BUS;
@@ -252,6 +304,12 @@ void rx_loop(void) {
                         send_i2c_scan(&i2c_state);
                         break;
 
+                    // FROM 1.2.0
+                    case 'D':   // SCAN A RANGE OF ADDRESSES, RETURNING A BITMAP
+                        if (!i2c_state.is_ready) init_i2c(&i2c_state);
+                        send_i2c_scan_bitmap(&i2c_state, &rx_ptr[1]);
+                        break;
+
                     case 'p':   // SEND AN I2C STOP
                         if (i2c_state.is_ready && i2c_state.is_started) {
                             // Send no bytes and STOP
@@ -271,8 +329,8 @@ void rx_loop(void) {
                     case 's':   // START AN I2C TRANSACTION
                         if (i2c_state.is_ready) {
                             // Received data is in the form ['s', (address << 1) | op];
-                            i2c_state.address = (rx_buffer[1] & 0xFE) >> 1;
-                            i2c_state.is_read_op = ((rx_buffer[1] & 0x01) == 1);
+                            i2c_state.address = (rx_ptr[1] & 0xFE) >> 1;
+                            i2c_state.is_read_op = ((rx_ptr[1] & 0x01) == 1);
                             i2c_state.is_started = true;
                             send_ack();
                         } else {
@@ -281,6 +339,117 @@ void rx_loop(void) {
                         }
                         break;
 
+                    // FROM 1.2.0
+                    case 't':   // WRITE THEN READ, WITH A REPEATED START
+                        {
+                            // Received data is in the form
+                            // ['t', address << 1, write count, read count, write data...]
+                            uint8_t write_count = rx_ptr[2];
+                            uint8_t read_count = rx_ptr[3];
+
+                            if (!i2c_state.is_ready) {
+                                last_error_code = I2C_NOT_READY;
+                                send_err();
+                                break;
+                            }
+
+                            if (write_count == 0 || write_count > TRANSFER_LENGTH_MAX_B ||
+                                read_count == 0 || read_count > TRANSFER_LENGTH_MAX_B) {
+                                last_error_code = GEN_UNKNOWN_COMMAND;
+                                send_err();
+                                break;
+                            }
+
+                            uint32_t timeout_us = get_i2c_timeout_us(&i2c_state, write_count + read_count);
+                            i2c_state.address = (rx_ptr[1] & 0xFE) >> 1;
+                            i2c_state.is_started = false;
+
+                            // Write without a STOP, so the read begins with a repeated START
+                            int bytes_sent = i2c_write_timeout_us(i2c_state.bus, i2c_state.address, &rx_ptr[4], write_count, true, timeout_us);
+                            if (bytes_sent != write_count) {
+                                last_error_code = I2C_COULD_NOT_WRITE;
+                                send_err();
+                                break;
+                            }
+
+                            // Return ACK then the data in one block
+                            uint8_t i2c_rx_buffer[TRANSFER_LENGTH_MAX_B + 1] = {ACK};
+                            int bytes_read = i2c_read_timeout_us(i2c_state.bus, i2c_state.address, &i2c_rx_buffer[1], read_count, false, timeout_us);
+                            if (bytes_read != read_count) {
+                                last_error_code = I2C_COULD_NOT_READ;
+                                send_err();
+                                break;
+                            }
+
+                            tx(i2c_rx_buffer, read_count + 1);
+                        }
+                        break;
+
+                    // FROM 1.2.0
+                    case 'w':   // WRITE UP TO 4KB IN ONE TRANSACTION
+                        {
+                            // Received data is in the form
+                            // ['w', length (little endian, 2 bytes), data...]
+                            uint32_t write_count = rx_ptr[1] | (rx_ptr[2] << 8);
+
+                            // Skip any data that didn't fit the frame
+                            if (3 + write_count > frame_length) discard_count = 3 + write_count - frame_length;
+
+                            if (!i2c_state.is_started) {
+                                last_error_code = I2C_NOT_STARTED;
+                                send_err();
+                                break;
+                            }
+
+                            if (write_count == 0 || write_count > LONG_FRAME_LENGTH_MAX_B) {
+                                last_error_code = GEN_UNKNOWN_COMMAND;
+                                send_err();
+                                break;
+                            }
+
+                            int bytes_sent = i2c_write_timeout_us(i2c_state.bus, i2c_state.address, &rx_ptr[3], write_count, false,
+                                                                  get_i2c_timeout_us(&i2c_state, write_count));
+                            if (bytes_sent != write_count) {
+                                last_error_code = I2C_COULD_NOT_WRITE;
+                                send_err();
+                            } else {
+                                send_ack();
+                            }
+                        }
+                        break;
+
+                    // FROM 1.2.0
+                    case 'r':   // READ UP TO 4KB IN ONE TRANSACTION
+                        {
+                            // Received data is in the form
+                            // ['r', length (little endian, 2 bytes)]
+                            uint32_t read_count = rx_ptr[1] | (rx_ptr[2] << 8);
+
+                            if (!i2c_state.is_started) {
+                                last_error_code = I2C_NOT_STARTED;
+                                send_err();
+                                break;
+                            }
+
+                            if (read_count == 0 || read_count > LONG_FRAME_LENGTH_MAX_B) {
+                                last_error_code = GEN_UNKNOWN_COMMAND;
+                                send_err();
+                                break;
+                            }
+
+                            // Return ACK then the data in one block
+                            i2c_long_rx_buffer[0] = ACK;
+                            int bytes_read = i2c_read_timeout_us(i2c_state.bus, i2c_state.address, &i2c_long_rx_buffer[1], read_count, false,
+                                                                 get_i2c_timeout_us(&i2c_state, read_count));
+                            if (bytes_read != read_count) {
+                                last_error_code = I2C_COULD_NOT_READ;
+                                send_err();
+                            } else {
+                                tx(i2c_long_rx_buffer, read_count + 1);
+                            }
+                        }
+                        break;
+
                     /*
                      * GPIO COMMANDS
                      */
@@ -314,9 +483,24 @@ void rx_loop(void) {
                         send_err();
                 }
             }
+        }
 
-            // Clear buffer and listen for input
-            memset(rx_buffer, 0, RX_BUFFER_LENGTH_B);
+        // FROM 1.2.0
+        // Retain any incomplete frame until the rest of it arrives,
+        // but drop it if the host has gone quiet
+        held_count = rx_count - offset;
+        if (held_count > 0) {
+            if (offset > 0) {
+                memmove(rx_buffer, &rx_buffer[offset], held_count);
+            } else if (time_us_64() - last_rx > PARTIAL_FRAME_TIMEOUT_US) {
+#ifdef DO_UART_DEBUG
+                debug_log("Partial frame dropped: %i bytes", held_count);
+#endif
+                held_count = 0;
+            }
+        } else if (discard_count > 0 && time_us_64() - last_rx > PARTIAL_FRAME_TIMEOUT_US) {
+            // Likewise stop skipping if the rest never comes
+            discard_count = 0;
         }
 
 #ifdef SHOW_HEARTBEAT
@@ -345,7 +529,8 @@ void rx_loop(void) {
 #endif
 
         // Pause? May not be necessary or might be bad
-        sleep_ms(RX_LOOP_DELAY_MS);
+        // FROM 1.2.0 -- only pause when idle
+        if (read_count == 0) sleep_ms(RX_LOOP_DELAY_MS);
     }
 
     // Should not get here, but just in case...
@@ -385,21 +570,24 @@ static inline void send_err(void) {
 
 
 /**
- * @brief Read in a single transmitted block.
+ * @brief Read in whatever bytes the host has sent.
+ *        FROM 1.2.0 -- Frames are now delimited by their
+ *        length, not by gaps in transmission, so there's
+ *        no need to pause between bytes.
  *
- * @param buffer: A pointer to the byte store buffer.
+ * @param buffer:    A pointer to the byte store buffer.
+ * @param max_bytes: The space available in the buffer.
  *
  * @retval The number of bytes to process.
  */
-static uint32_t rx(uint8_t* buffer) {
+static uint32_t rx(uint8_t* buffer, uint32_t max_bytes) {
 
     uint32_t buffer_byte_count = 0;
     int c = PICO_ERROR_TIMEOUT;
-    while (buffer_byte_count < RX_BUFFER_LENGTH_B) {
+    while (buffer_byte_count < max_bytes) {
         c = getchar_timeout_us(1);
         if (c == PICO_ERROR_TIMEOUT) break;
         buffer[buffer_byte_count++] = (uint8_t)c;
-        sleep_ms(UART_LOOP_DELAY_MS);
     }
 
 #ifdef DO_UART_DEBUG
@@ -411,6 +599,9 @@ static uint32_t rx(uint8_t* buffer) {
 
 /**
  * @brief Send a single transmitted block.
+ *        FROM 1.2.0 -- Don't pause between bytes: stdio
+ *        blocks when it needs to, and pausing would add
+ *        seconds to long reads.
  *
  * @param buffer:     A pointer to the byte store buffer.
  * @param byte_count: The number of bytes to send.
@@ -419,10 +610,9 @@ void tx(uint8_t* buffer, uint32_t byte_count) {
 
     for (uint32_t i = 0 ; i < byte_count ; ++i) {
         putchar((buffer[i]));
-        sleep_ms(UART_LOOP_DELAY_MS);
     }
 
-    // stdio_flush();
+    stdio_flush();
 }
 
 
@@ -471,6 +661,69 @@ static uint8_t get_mode(char mode_key) {
 }
 
 
+/**
+ * @brief Determine the length of the frame starting at the
+ *        specified byte. Every command has a fixed length,
+ *        and the data frame length is set by its prefix byte.
+ *        FROM 1.2.0
+ *
+ * @param frame:     A pointer to the first byte of the frame.
+ * @param available: The number of bytes received from `frame` on.
+ *
+ * @retval The frame length in bytes.
+ */
+static uint32_t get_frame_length(uint8_t* frame, uint32_t available) {
+
+    uint8_t status_byte = frame[0];
+    if (status_byte >= WRITE_LENGTH_BASE) return status_byte - WRITE_LENGTH_BASE + 2;
+    if (status_byte >= READ_LENGTH_BASE) return 1;
+
+    switch((char)status_byte) {
+        case 'c':   // Bus ID, SDA pin, SCL pin
+            return 4;
+        case 'D':   // First and last addresses, probe timeout (2 bytes)
+            return 5;
+        case '*':   // LED state
+        case 'g':   // Pin data
+        case 's':   // Address and op
+            return 2;
+        case 't':   // Address, counts, then the bytes to write.
+                    // Until the write count has arrived, ask for the header.
+                    // Take oversized frames whole, for the handler to ERR
+            if (available < 3) return 4;
+            return 4 + frame[2];
+        case 'w':   // Length (2 bytes), then the bytes to write.
+                    // Oversized frames are cut to fit the buffer: the
+                    // handler ERRs them and skips what's left
+            {
+                if (available < 3) return 3;
+                uint32_t length = 3 + (frame[1] | (frame[2] << 8));
+                return length <= RX_BUFFER_LENGTH_B ? length : RX_BUFFER_LENGTH_B;
+            }
+        case 'r':   // Length (2 bytes)
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+
+/**
+ * @brief Calculate a timeout for an I2C transfer: nine bit
+ *        periods per byte, plus the address, plus a margin.
+ *        FROM 1.2.0
+ *
+ * @param i2c_state:  The I2C state record.
+ * @param byte_count: The number of bytes to transfer.
+ *
+ * @retval The timeout in microseconds.
+ */
+static uint32_t get_i2c_timeout_us(I2C_State* i2c_state, uint32_t byte_count) {
+
+    return 1000 + (byte_count + 2) * 9000 / i2c_state->frequency;
+}
+
+
 static void sig_handler(int signal) {
 
 #ifdef DO_UART_DEBUG
@@ -61,7 +61,6 @@
 
 // FROM 1.1.2
 #define UART_LOOP_DELAY_MS                      1
-#define RX_BUFFER_LENGTH_B                      128
 
 // FROM 1.1.3
 #define MODE_NONE                               0
@@ -78,6 +77,21 @@
 #define ERROR_BUFFER_LENGTH_B                   129
 #define I2C_RX_BUFFER_LENGTH_B                  65
 
+// FROM 1.2.0
+#define PARTIAL_FRAME_TIMEOUT_US                100000
+#define TRANSFER_LENGTH_MAX_B                   64
+#define LONG_FRAME_LENGTH_MAX_B                 4096
+// Room for the largest long frame plus others queued behind it
+#define RX_BUFFER_LENGTH_B                      (LONG_FRAME_LENGTH_MAX_B + 64)
+
+// FROM 1.2.0
+// Features reported to the host by the `#` command
+#define CAPABILITY_PIPELINE                     0x01
+#define CAPABILITY_TRANSFER                     0x02
+#define CAPABILITY_LONG_FRAMES                  0x04
+#define CAPABILITY_SCAN_BITMAP                  0x08
+#define HOST_CAPABILITIES                       (CAPABILITY_PIPELINE | CAPABILITY_TRANSFER | CAPABILITY_LONG_FRAMES | CAPABILITY_SCAN_BITMAP)
+
 
 /*
  * PROTOTYPES
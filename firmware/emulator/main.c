@@ -0,0 +1,159 @@
+/*
+ * I2C Host Firmware -- Emulator
+ *
+ * Runs the firmware's command loop on a Linux or macOS computer,
+ * with simulated I2C peripherals, and presents its USB-serial
+ * port as a pseudo-terminal that the host apps can connect to.
+ *
+ * @version     1.2.0
+ * @author      Tony Smith (@smittytone)
+ * @copyright   2023
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static int          open_port(char* path, size_t path_size);
+static void         stop_handler(int signal);
+static inline void  show_help(void);
+
+
+/*
+ * GLOBALS
+ */
+// A link to the port, removed on exit
+static const char* link_path = NULL;
+
+
+/*
+ * ENTRY POINT
+ */
+int main(int argc, char* argv[]) {
+
+    bool has_devices = false;
+    for (int i = 1 ; i < argc ; ++i) {
+        if (strcmp(argv[i], "--link") == 0 && i + 1 < argc) {
+            link_path = argv[++i];
+        } else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+            if (!emulator_add_device((uint8_t)strtol(argv[++i], NULL, 0))) {
+                fprintf(stderr, "[ERROR] Invalid I2C address: %s\n", argv[i]);
+                return 1;
+            }
+
+            has_devices = true;
+        } else if (strcmp(argv[i], "--fast") == 0) {
+            emulator_set_bus_timing(false);
+        } else {
+            show_help();
+            return (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) ? 0 : 1;
+        }
+    }
+
+    if (!has_devices) {
+        uint8_t addresses[] = EMULATOR_DEVICES_DEFAULT;
+        for (size_t i = 0 ; i < sizeof(addresses) ; ++i) emulator_add_device(addresses[i]);
+    }
+
+    char port_path[128] = {0};
+    int fd = open_port(port_path, sizeof(port_path));
+    if (fd == -1) return 1;
+
+    if (link_path != NULL) {
+        unlink(link_path);
+        if (symlink(port_path, link_path) == -1) {
+            fprintf(stderr, "[ERROR] Could not link %s - %s (%d)\n", link_path, strerror(errno), errno);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, stop_handler);
+    signal(SIGTERM, stop_handler);
+
+    // Tell the user, or a calling script, where to connect
+    printf("%s\n", link_path != NULL ? link_path : port_path);
+    fflush(stdout);
+
+    // Start the loop
+    // Function defined in `serial.c`
+    emulator_set_port(fd);
+    rx_loop();
+    return 1;
+}
+
+
+/**
+ * @brief Create the pseudo-terminal the host connects to, and
+ *        make it raw, like the RP2040's USB serial port.
+ *
+ * @param path:      A buffer for the path of the host's side.
+ * @param path_size: The size of the buffer.
+ *
+ * @retval The file descriptor of the firmware's side, or -1 on error.
+ */
+static int open_port(char* path, size_t path_size) {
+
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd == -1 || grantpt(fd) == -1 || unlockpt(fd) == -1) {
+        fprintf(stderr, "[ERROR] Could not create a pseudo-terminal - %s (%d)\n", strerror(errno), errno);
+        if (fd != -1) close(fd);
+        return -1;
+    }
+
+    const char* name = ptsname(fd);
+    if (name == NULL || strlen(name) >= path_size) {
+        close(fd);
+        return -1;
+    }
+
+    strcpy(path, name);
+
+    // Set the host's side raw, then close it so that the host can
+    // take exclusive use of it
+    int host_fd = open(path, O_RDWR | O_NOCTTY);
+    if (host_fd != -1) {
+        struct termios settings;
+        if (tcgetattr(host_fd, &settings) == 0) {
+            cfmakeraw(&settings);
+            tcsetattr(host_fd, TCSANOW, &settings);
+        }
+
+        close(host_fd);
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+
+/**
+ * @brief Remove the link to the port, and exit.
+ *
+ * @param signal: The signal received.
+ */
+static void stop_handler(int signal) {
+
+    (void)signal;
+    if (link_path != NULL) unlink(link_path);
+    _exit(0);
+}
+
+
+/**
+ * @brief Show help.
+ */
+static inline void show_help(void) {
+
+    fprintf(stderr, "firmware_emulator [--link {path}] [--device {address}] ... [--fast]\n\n");
+    fprintf(stderr, "Runs the bus host firmware with simulated I2C peripherals, and prints\n");
+    fprintf(stderr, "the path of a pseudo-terminal to pass to cli2c, matrix or segment.\n\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --link {path}        Also make the port available at this path.\n");
+    fprintf(stderr, "  --device {address}   Simulate a peripheral at this address. Repeat for more.\n");
+    fprintf(stderr, "                       Default: 0x18 and 0x70\n");
+    fprintf(stderr, "  --fast               Complete I2C transactions at once, rather than in the\n");
+    fprintf(stderr, "                       time they'd take on a real bus.\n");
+}
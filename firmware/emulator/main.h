@@ -0,0 +1,39 @@
+/*
+ * I2C Host Firmware -- Emulator
+ *
+ * @version     1.2.0
+ * @author      Tony Smith (@smittytone)
+ * @copyright   2023
+ * @licence     MIT
+ *
+ */
+#ifndef _MAIN_H_
+#define _MAIN_H_
+
+
+/*
+ * INCLUDES
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <termios.h>
+// Pico SDK Includes
+#include "pico/stdlib.h"
+// App includes
+#include "../common/serial.h"
+#include "sdk.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define EMULATOR_DEVICES_DEFAULT                {0x18, 0x70}
+
+
+#endif  // _MAIN_H_
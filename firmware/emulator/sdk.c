@@ -0,0 +1,433 @@
+/*
+ * I2C Host Firmware -- Emulator implementation of the Pico SDK calls
+ *                      the firmware makes
+ *
+ * @version     1.2.0
+ * @author      Tony Smith (@smittytone)
+ * @copyright   2023
+ * @licence     MIT
+ *
+ */
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "pico/unique_id.h"
+#include "hardware/i2c.h"
+#include "hardware/gpio.h"
+#include "sdk.h"
+
+
+/*
+ * STRUCTURES
+ */
+// A simulated I2C peripheral: a bank of registers. The first byte of
+// a write sets the register pointer; further bytes are written from
+// the pointer, and reads are made from it. The pointer auto-increments
+typedef struct {
+    bool        is_present;
+    uint8_t     pointer;
+    uint8_t     registers[EMULATOR_REGISTERS_B];
+} Device;
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static bool     fill_input(uint32_t timeout_us);
+static void     flush_output(void);
+static int      bus_access(i2c_inst_t* i2c, uint8_t addr, size_t len);
+
+
+/*
+ * GLOBALS
+ */
+i2c_inst_t i2c0_inst = {0};
+i2c_inst_t i2c1_inst = {0};
+
+// The master side of the pseudo-terminal the host connects to
+static int port_fd = -1;
+
+// Bytes received from the host but not yet consumed, and bytes
+// waiting to be sent to it, like the USB stack's FIFOs
+static uint8_t input[EMULATOR_IO_BUFFER_B];
+static size_t input_start = 0;
+static size_t input_count = 0;
+static uint8_t output[EMULATOR_IO_BUFFER_B];
+static size_t output_count = 0;
+
+static Device devices[128];
+static bool gpio_values[32];
+static bool is_bus_timed = true;
+static uint64_t start_us = 0;
+
+
+#pragma mark - Emulator Functions
+
+/**
+ * @brief Set the file descriptor the firmware's stdio uses.
+ *
+ * @param fd: The master side of a pseudo-terminal.
+ */
+void emulator_set_port(int fd) {
+
+    port_fd = fd;
+}
+
+
+/**
+ * @brief Attach a simulated peripheral to both I2C buses.
+ *
+ * @param address: The peripheral's 7-bit address.
+ *
+ * @retval Whether the address is valid (`true`) or not (`false`).
+ */
+bool emulator_add_device(uint8_t address) {
+
+    if (address < 0x08 || address > 0x77) return false;
+    devices[address].is_present = true;
+    return true;
+}
+
+
+/**
+ * @brief Set whether I2C transactions take as long as they would on
+ *        a real bus at its set frequency (`true`) or complete at once.
+ *
+ * @param is_timed: Whether to simulate bus timing.
+ */
+void emulator_set_bus_timing(bool is_timed) {
+
+    is_bus_timed = is_timed;
+}
+
+
+#pragma mark - Time Functions
+
+/**
+ * @brief Get the time since the emulator started.
+ *
+ * @retval The time in microseconds.
+ */
+uint64_t time_us_64(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t now_us = (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    if (start_us == 0) start_us = now_us;
+    return now_us - start_us;
+}
+
+
+/**
+ * @brief Sleep for a number of milliseconds. Pending output
+ *        is sent first, as the USB stack would while idle.
+ *
+ * @param ms: The period to sleep.
+ */
+void sleep_ms(uint32_t ms) {
+
+    sleep_us((uint64_t)ms * 1000);
+}
+
+
+/**
+ * @brief Sleep for a number of microseconds. Pending output
+ *        is sent first, as the USB stack would while idle.
+ *
+ * @param us: The period to sleep.
+ */
+void sleep_us(uint64_t us) {
+
+    flush_output();
+    struct timespec period = {.tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000};
+    while (nanosleep(&period, &period) == -1 && errno == EINTR) {}
+}
+
+
+#pragma mark - stdio Functions
+
+/**
+ * @brief Get a byte sent by the host.
+ *
+ * @param timeout_us: How long to wait for a byte.
+ *
+ * @retval The byte, or `PICO_ERROR_TIMEOUT`.
+ */
+int getchar_timeout_us(uint32_t timeout_us) {
+
+    if (input_count == 0 && !fill_input(timeout_us)) return PICO_ERROR_TIMEOUT;
+    input_count--;
+    return input[input_start++];
+}
+
+
+/**
+ * @brief Queue a byte for the host.
+ *
+ * @param c: The byte.
+ *
+ * @retval The byte.
+ */
+int emulator_putchar(int c) {
+
+    if (output_count == EMULATOR_IO_BUFFER_B) flush_output();
+    output[output_count++] = (uint8_t)c;
+    return c;
+}
+
+
+/**
+ * @brief Send any queued bytes to the host.
+ */
+void stdio_flush(void) {
+
+    flush_output();
+}
+
+
+/**
+ * @brief Read whatever the host has sent, waiting for it if necessary.
+ *        Pending output is sent first, so the host gets responses
+ *        before the firmware waits for further commands.
+ *
+ * @param timeout_us: How long to wait.
+ *
+ * @retval Whether any bytes were read (`true`) or not (`false`).
+ */
+static bool fill_input(uint32_t timeout_us) {
+
+    flush_output();
+    input_start = 0;
+
+    struct pollfd pfd = {.fd = port_fd, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_us / 1000) <= 0 || (pfd.revents & POLLIN) == 0) return false;
+
+    // NOTE read() fails with EIO while the host has the port closed
+    ssize_t count = read(port_fd, input, sizeof(input));
+    if (count <= 0) return false;
+    input_count = count;
+    return true;
+}
+
+
+/**
+ * @brief Write all queued bytes to the host.
+ */
+static void flush_output(void) {
+
+    size_t sent = 0;
+    while (sent < output_count) {
+        ssize_t count = write(port_fd, output + sent, output_count - sent);
+        if (count > 0) {
+            sent += count;
+        } else if (count == -1 && errno == EAGAIN) {
+            struct pollfd pfd = {.fd = port_fd, .events = POLLOUT};
+            poll(&pfd, 1, 100);
+        } else if (count == -1 && errno != EINTR) {
+            // The host has gone, so drop the output
+            break;
+        }
+    }
+
+    output_count = 0;
+}
+
+
+#pragma mark - I2C Functions
+
+/**
+ * @brief Initialise an I2C bus.
+ *
+ * @param i2c:      The bus.
+ * @param baudrate: The bus frequency in Hz.
+ *
+ * @retval The frequency set.
+ */
+unsigned int i2c_init(i2c_inst_t* i2c, unsigned int baudrate) {
+
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+
+/**
+ * @brief Disable an I2C bus.
+ *
+ * @param i2c: The bus.
+ */
+void i2c_deinit(i2c_inst_t* i2c) {
+
+    i2c->baudrate = 0;
+}
+
+
+/**
+ * @brief Write bytes to a simulated peripheral.
+ *
+ * @param i2c:        The bus.
+ * @param addr:       The peripheral's 7-bit address.
+ * @param src:        The bytes to write.
+ * @param len:        The number of bytes.
+ * @param nostop:     Ignored.
+ * @param timeout_us: Ignored.
+ *
+ * @retval The number of bytes written, or `PICO_ERROR_GENERIC` if
+ *         nothing ACK'd the address.
+ */
+int i2c_write_timeout_us(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop, unsigned int timeout_us) {
+
+    (void)nostop;
+    (void)timeout_us;
+    int result = bus_access(i2c, addr, len);
+    if (result <= 0) return result;
+
+    Device* device = &devices[addr];
+    device->pointer = src[0];
+    for (size_t i = 1 ; i < len ; ++i) {
+        device->registers[device->pointer++] = src[i];
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief Read bytes from a simulated peripheral.
+ *
+ * @param i2c:        The bus.
+ * @param addr:       The peripheral's 7-bit address.
+ * @param dst:        A buffer for the bytes read.
+ * @param len:        The number of bytes.
+ * @param nostop:     Ignored.
+ * @param timeout_us: Ignored.
+ *
+ * @retval The number of bytes read, or `PICO_ERROR_GENERIC` if
+ *         nothing ACK'd the address.
+ */
+int i2c_read_timeout_us(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop, unsigned int timeout_us) {
+
+    (void)nostop;
+    (void)timeout_us;
+    int result = bus_access(i2c, addr, len);
+    if (result <= 0) return result;
+
+    Device* device = &devices[addr];
+    for (size_t i = 0 ; i < len ; ++i) {
+        dst[i] = device->registers[device->pointer++];
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief Write bytes to a simulated peripheral, without a timeout.
+ */
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop) {
+
+    return i2c_write_timeout_us(i2c, addr, src, len, nostop, 0);
+}
+
+
+/**
+ * @brief Read bytes from a simulated peripheral, without a timeout.
+ */
+int i2c_read_blocking(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop) {
+
+    return i2c_read_timeout_us(i2c, addr, dst, len, nostop, 0);
+}
+
+
+/**
+ * @brief Address a simulated peripheral, taking as long as the
+ *        transaction would on a real bus: nine clocks per byte,
+ *        including the address byte.
+ *
+ * @param i2c:  The bus.
+ * @param addr: The peripheral's 7-bit address.
+ * @param len:  The number of data bytes.
+ *
+ * @retval `len`, or `PICO_ERROR_GENERIC` if the bus is off or
+ *         nothing ACK'd the address.
+ */
+static int bus_access(i2c_inst_t* i2c, uint8_t addr, size_t len) {
+
+    if (i2c->baudrate == 0 || addr > 0x7F) return PICO_ERROR_GENERIC;
+
+    // A missing peripheral NACKs the address byte
+    bool is_present = devices[addr].is_present;
+    size_t clocked = is_present ? len + 1 : 1;
+    if (is_bus_timed) {
+        // Sleep through most of a long transaction, then spin for accuracy
+        uint64_t period_us = (clocked * 9 * 1000000ULL) / i2c->baudrate;
+        uint64_t end_us = time_us_64() + period_us;
+        if (period_us > 1000) {
+            uint64_t sleep_period_us = period_us - 500;
+            struct timespec period = {.tv_sec = sleep_period_us / 1000000, .tv_nsec = (sleep_period_us % 1000000) * 1000};
+            while (nanosleep(&period, &period) == -1 && errno == EINTR) {}
+        }
+
+        while (time_us_64() < end_us) {}
+    }
+
+    return (is_present && len > 0) ? (int)len : PICO_ERROR_GENERIC;
+}
+
+
+#pragma mark - GPIO Functions
+
+// Pins hold the last value put; pin functions and pulls have no effect
+
+void gpio_init(unsigned int gpio) {
+
+    if (gpio < 32) gpio_values[gpio] = false;
+}
+
+
+void gpio_set_dir(unsigned int gpio, bool out) {
+
+    (void)gpio;
+    (void)out;
+}
+
+
+void gpio_put(unsigned int gpio, bool value) {
+
+    if (gpio < 32) gpio_values[gpio] = value;
+}
+
+
+bool gpio_get(unsigned int gpio) {
+
+    return gpio < 32 ? gpio_values[gpio] : false;
+}
+
+
+void gpio_set_function(unsigned int gpio, enum gpio_function fn) {
+
+    (void)gpio;
+    (void)fn;
+}
+
+
+void gpio_pull_up(unsigned int gpio) {
+
+    (void)gpio;
+}
+
+
+#pragma mark - Board Functions
+
+/**
+ * @brief Get the board's ID as a hex string.
+ *
+ * @param id_out: A buffer for the string.
+ * @param len:    The buffer's size.
+ */
+void pico_get_unique_board_id_string(char* id_out, unsigned int len) {
+
+    snprintf(id_out, len, "%s", "E0E1A7000000C12C");
+}
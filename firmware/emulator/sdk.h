@@ -0,0 +1,36 @@
+/*
+ * I2C Host Firmware -- Emulator
+ *
+ * @version     1.2.0
+ * @author      Tony Smith (@smittytone)
+ * @copyright   2023
+ * @licence     MIT
+ *
+ */
+#ifndef _EMULATOR_SDK_H_
+#define _EMULATOR_SDK_H_
+
+
+/*
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * CONSTANTS
+ */
+#define EMULATOR_REGISTERS_B                    256
+#define EMULATOR_IO_BUFFER_B                    8192
+
+
+/*
+ * PROTOTYPES
+ */
+void        emulator_set_port(int fd);
+bool        emulator_add_device(uint8_t address);
+void        emulator_set_bus_timing(bool is_timed);
+
+
+#endif  // _EMULATOR_SDK_H_
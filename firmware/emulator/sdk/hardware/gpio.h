@@ -0,0 +1,47 @@
+/*
+ * I2C Host Firmware -- Emulator stub of the Pico SDK
+ *
+ * @version     1.2.0
+ * @author      Tony Smith (@smittytone)
+ * @copyright   2023
+ * @licence     MIT
+ *
+ */
+#ifndef _EMULATOR_HARDWARE_GPIO_H_
+#define _EMULATOR_HARDWARE_GPIO_H_
+
+
+/*
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * CONSTANTS
+ */
+#define GPIO_OUT                                1
+#define GPIO_IN                                 0
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_NULL = 0x1F,
+};
+
+
+/*
+ * PROTOTYPES
+ */
+void        gpio_init(unsigned int gpio);
+void        gpio_set_dir(unsigned int gpio, bool out);
+void        gpio_put(unsigned int gpio, bool value);
+bool        gpio_get(unsigned int gpio);
+void        gpio_set_function(unsigned int gpio, enum gpio_function fn);
+void        gpio_pull_up(unsigned int gpio);
+
+
+#endif  // _EMULATOR_HARDWARE_GPIO_H_
@@ -0,0 +1,51 @@
+/*
+ * I2C Host Firmware -- Emulator stub of the Pico SDK
+ *
+ * @version     1.2.0
+ * @author      Tony Smith (@smittytone)
+ * @copyright   2023
+ * @licence     MIT
+ *
+ */
+#ifndef _EMULATOR_HARDWARE_I2C_H_
+#define _EMULATOR_HARDWARE_I2C_H_
+
+
+/*
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct i2c_inst {
+    uint32_t    baudrate;               // Zero while the bus is not initialised
+} i2c_inst_t;
+
+
+/*
+ * GLOBALS
+ */
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+
+#define i2c0                                    (&i2c0_inst)
+#define i2c1                                    (&i2c1_inst)
+
+
+/*
+ * PROTOTYPES
+ */
+unsigned int    i2c_init(i2c_inst_t* i2c, unsigned int baudrate);
+void            i2c_deinit(i2c_inst_t* i2c);
+int             i2c_write_timeout_us(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop, unsigned int timeout_us);
+int             i2c_read_timeout_us(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop, unsigned int timeout_us);
+int             i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop);
+int             i2c_read_blocking(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop);
+
+
+#endif  // _EMULATOR_HARDWARE_I2C_H_
@@ -0,0 +1,16 @@
+/*
+ * I2C Host Firmware -- Emulator stub of the Pico SDK
+ *
+ * @version     1.2.0
+ * @author      Tony Smith (@smittytone)
+ * @copyright   2023
+ * @licence     MIT
+ *
+ */
+#ifndef _EMULATOR_PICO_BINARY_INFO_H_
+#define _EMULATOR_PICO_BINARY_INFO_H_
+
+// Binary info is only embedded in RP2040 images
+
+
+#endif  // _EMULATOR_PICO_BINARY_INFO_H_
@@ -0,0 +1,57 @@
+/*
+ * I2C Host Firmware -- Emulator stub of the Pico SDK
+ *
+ * @version     1.2.0
+ * @author      Tony Smith (@smittytone)
+ * @copyright   2023
+ * @licence     MIT
+ *
+ */
+#ifndef _EMULATOR_PICO_STDLIB_H_
+#define _EMULATOR_PICO_STDLIB_H_
+
+
+/*
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "hardware/gpio.h"
+
+
+/*
+ * CONSTANTS
+ */
+enum pico_error_codes {
+    PICO_OK = 0,
+    PICO_ERROR_NONE = 0,
+    PICO_ERROR_TIMEOUT = -1,
+    PICO_ERROR_GENERIC = -2,
+    PICO_ERROR_NO_DATA = -3,
+};
+
+// Route the firmware's output to the emulator's port,
+// as the SDK does to USB
+#define putchar(c)                              emulator_putchar(c)
+
+
+/*
+ * STRUCTURES
+ */
+typedef unsigned int uint;
+
+
+/*
+ * PROTOTYPES
+ */
+uint64_t    time_us_64(void);
+void        sleep_ms(uint32_t ms);
+void        sleep_us(uint64_t us);
+int         getchar_timeout_us(uint32_t timeout_us);
+int         emulator_putchar(int c);
+void        stdio_flush(void);
+
+
+#endif  // _EMULATOR_PICO_STDLIB_H_
@@ -0,0 +1,26 @@
+/*
+ * I2C Host Firmware -- Emulator stub of the Pico SDK
+ *
+ * @version     1.2.0
+ * @author      Tony Smith (@smittytone)
+ * @copyright   2023
+ * @licence     MIT
+ *
+ */
+#ifndef _EMULATOR_PICO_UNIQUE_ID_H_
+#define _EMULATOR_PICO_UNIQUE_ID_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define PICO_UNIQUE_BOARD_ID_SIZE_BYTES         8
+
+
+/*
+ * PROTOTYPES
+ */
+void        pico_get_unique_board_id_string(char* id_out, unsigned int len);
+
+
+#endif  // _EMULATOR_PICO_UNIQUE_ID_H_